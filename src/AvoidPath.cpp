@@ -0,0 +1,201 @@
+#include "AvoidPath.h"
+
+// 段内弧长 u 处的点
+static PathPoint pointOn(const PathSegment& seg, float u) {
+    const PathPoint& b = seg.begin;
+    PathPoint p;
+    if (seg.curvature == 0) {
+        p.x = b.x + u * cosf(b.heading);
+        p.y = b.y + u * sinf(b.heading);
+        p.heading = b.heading;
+    } else {
+        p.heading = b.heading + seg.curvature * u;
+        p.x = b.x + (sinf(p.heading) - sinf(b.heading)) / seg.curvature;
+        p.y = b.y - (cosf(p.heading) - cosf(b.heading)) / seg.curvature;
+    }
+    return p;
+}
+
+// 变道: 两段半径 radius、转角 angle 的反向圆弧, 中间直线 straight.
+// 偏移不超过 2R(1-cos θmax) 时不需要直线, 否则以 θmax 斜插
+static void solveLaneChange(float offset, float radius, float& angle, float& straight) {
+    float maxAngle = AVOID_ARC_MAX_DEG * (float)PI / 180.0f;
+    float arcOffset = 2 * radius * (1 - cosf(maxAngle));
+    if (offset <= arcOffset) {
+        angle = acosf(1 - offset / (2 * radius));
+        straight = 0;
+    } else {
+        angle = maxAngle;
+        straight = (offset - arcOffset) / sinf(maxAngle);
+    }
+}
+
+// 变道沿原方向前进的距离
+static float laneChangeForward(float radius, float angle, float straight) {
+    return 2 * radius * sinf(angle) + straight * cosf(angle);
+}
+
+AvoidPath::AvoidPath() {
+    clear();
+}
+
+void AvoidPath::clear() {
+    count = 0;
+    length = 0;
+    progress = 0;
+    returnStart = 0;
+    outRadius = 0;
+}
+
+void AvoidPath::addSegment(float segmentLength, float curvature) {
+    if (segmentLength < 0.5f || count >= AVOID_PATH_MAX_SEGMENTS) {
+        return;
+    }
+    PathSegment& seg = segments[count];
+    if (count == 0) {
+        seg.begin = {0, 0, 0};
+    } else {
+        seg.begin = pointOn(segments[count - 1], segments[count - 1].length);
+    }
+    seg.start = length;
+    seg.length = segmentLength;
+    seg.curvature = curvature;
+    count++;
+    length += segmentLength;
+}
+
+bool AvoidPath::plan(const AvoidGeometry& geometry) {
+    clear();
+
+    // 出发变道必须在车头到达障碍物前完成: 来不及时减小半径 (转得更急, 速度相应降低)
+    float available = geometry.obstacleFront - geometry.margin;
+    float radius = geometry.radius;
+    float angle, straight;
+    while (true) {
+        solveLaneChange(geometry.offset, radius, angle, straight);
+        if (laneChangeForward(radius, angle, straight) <= available) {
+            break;
+        }
+        radius *= 0.9f;
+        if (radius < AVOID_ARC_MIN_RADIUS_MM) {
+            return false;
+        }
+    }
+    outRadius = radius;
+    float outForward = laneChangeForward(radius, angle, straight);
+    addSegment(radius * angle, 1 / radius);
+    addSegment(straight, 0);
+    addSegment(radius * angle, -1 / radius);
+
+    // 平行段: 车尾越过障碍物后沿 (含余量) 再回线
+    float passEnd = geometry.obstacleFront + geometry.obstacleLength + geometry.margin + AVOID_BODY_REAR_MM;
+    addSegment(max(passEnd - outForward, 0.0f), 0);
+
+    // 回线变道不受距离限制, 用期望半径
+    returnStart = length;
+    solveLaneChange(geometry.offset, geometry.radius, angle, straight);
+    addSegment(geometry.radius * angle, -1 / geometry.radius);
+    addSegment(straight, 0);
+    addSegment(geometry.radius * angle, 1 / geometry.radius);
+    addSegment(AVOID_REJOIN_MM, 0);
+    return true;
+}
+
+int AvoidPath::segmentAt(float s) const {
+    int index = 0;
+    while (index < count - 1 && s >= segments[index + 1].start) {
+        index++;
+    }
+    return index;
+}
+
+PathPoint AvoidPath::pointAt(float s) const {
+    if (count == 0) {
+        PathPoint origin = {0, 0, 0};
+        return origin;
+    }
+    if (s >= length) {
+        // 终点之后沿末段方向外推 (前视点不会停在终点上)
+        const PathSegment& last = segments[count - 1];
+        PathPoint end = pointOn(last, last.length);
+        float extra = s - length;
+        end.x += extra * cosf(end.heading);
+        end.y += extra * sinf(end.heading);
+        return end;
+    }
+    const PathSegment& seg = segments[segmentAt(s)];
+    return pointOn(seg, max(s - seg.start, 0.0f));
+}
+
+float AvoidPath::curvatureAt(float s) const {
+    if (count == 0 || s >= length) {
+        return 0;
+    }
+    return segments[segmentAt(s)].curvature;
+}
+
+float AvoidPath::speedLimit(float maxSpeed, float latAccel, float decel) const {
+    float limit = maxSpeed;
+    for (int i = segmentAt(progress); i < count; i++) {
+        const PathSegment& seg = segments[i];
+        if (seg.curvature == 0) {
+            continue;
+        }
+        float distance = max(seg.start - progress, 0.0f);
+        limit = min(limit, sqrtf(latAccel / fabsf(seg.curvature) + 2 * decel * distance));
+    }
+    return limit;
+}
+
+// 位姿在第 index 段上的最近点, 返回其累计弧长
+float AvoidPath::project(int index, float x, float y, float& distance2) const {
+    const PathSegment& seg = segments[index];
+    const PathPoint& b = seg.begin;
+    float u;
+    if (seg.curvature == 0) {
+        u = (x - b.x) * cosf(b.heading) + (y - b.y) * sinf(b.heading);
+    } else {
+        // 圆心在起点左侧 (左转) 或右侧 (右转) 1/κ 处, 取位姿相对起点绕圆心转过的角度
+        float r = 1 / seg.curvature;
+        float cx = b.x - r * sinf(b.heading);
+        float cy = b.y + r * cosf(b.heading);
+        float bx = b.x - cx, by = b.y - cy;
+        float px = x - cx, py = y - cy;
+        float turned = atan2f(bx * py - by * px, bx * px + by * py);
+        u = turned / seg.curvature;
+    }
+    u = constrain(u, 0.0f, seg.length);
+    PathPoint p = pointOn(seg, u);
+    distance2 = (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y);
+    return seg.start + u;
+}
+
+float AvoidPath::track(float x, float y, float heading, float lookahead) {
+    // 最近点只在当前段和后两段里找, 且不后退 (路径自身不交叉, 但变道两端离得很近)
+    int first = segmentAt(progress);
+    float best = progress;
+    float bestDistance2 = 1e30f;
+    for (int i = first; i < count && i <= first + 2; i++) {
+        float distance2;
+        float s = project(i, x, y, distance2);
+        if (s >= progress && distance2 < bestDistance2) {
+            bestDistance2 = distance2;
+            best = s;
+        }
+    }
+    progress = best;
+
+    // 前视点转到车体坐标系: 过当前位置、与当前朝向相切并经过前视点的圆弧曲率 = 2·横向偏差/距离²
+    PathPoint target = pointAt(progress + lookahead);
+    float dx = target.x - x;
+    float dy = target.y - y;
+    float c = cosf(heading);
+    float s = sinf(heading);
+    float forward = dx * c + dy * s;
+    float lateral = -dx * s + dy * c;
+    float distance2 = forward * forward + lateral * lateral;
+    if (distance2 < 1.0f) {
+        return curvatureAt(progress);
+    }
+    return 2 * lateral / distance2;
+}
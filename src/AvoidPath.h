@@ -0,0 +1,68 @@
+#ifndef AVOID_PATH_H
+#define AVOID_PATH_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define AVOID_PATH_MAX_SEGMENTS 8
+
+// 路径上的一点 (规划坐标系: 原点为规划时的位姿, x 沿当时朝向, y 向左, 逆时针为正)
+struct PathPoint {
+    float x, y;
+    float heading;   // rad
+};
+
+// 路径段: 圆弧或直线 (曲率为0), 首尾相接
+struct PathSegment {
+    PathPoint begin;
+    float start;       // 起点处的累计弧长 (mm)
+    float length;      // mm
+    float curvature;   // 1/mm, 左转为正
+};
+
+// 绕障规划输入 (mm)
+struct AvoidGeometry {
+    float obstacleFront;    // 障碍物前沿到驱动轴的距离 (沿当前朝向)
+    float obstacleLength;   // 障碍物沿赛道方向的长度
+    float offset;           // 绕行时驱动轴中心相对赛道的横向偏移 (向左)
+    float radius;           // 期望转弯半径
+    float margin;           // 前后留出的余量
+};
+
+// 绕障路径: 变道 (左弧-直线-右弧) -> 平行直线 -> 变道回线 (右弧-直线-左弧) -> 沿原赛道直线,
+// 全程曲率分段常数, 航向连续, 不需要停车原地转. 障碍物太近时减小出发变道的半径
+// 跟踪用纯追踪: 每周期给出当前位姿, 取路径上前视距离处的点, 返回走到该点的圆弧曲率
+class AvoidPath {
+public:
+    AvoidPath();
+    void clear();
+    bool plan(const AvoidGeometry& geometry);   // 半径减到 AVOID_ARC_MIN_RADIUS_MM 仍来不及变道时返回 false
+
+    // 输入规划坐标系下的位姿, 推进进度 (只增不减), 返回目标曲率 (1/mm, 左转为正)
+    float track(float x, float y, float heading, float lookahead);
+
+    PathPoint pointAt(float s) const;     // 超出终点时沿末段方向外推
+    float curvatureAt(float s) const;
+    // 当前位置的限速: 前方每段圆弧按横向加速度限速, 再按减速度倒推到当前位置 (提前减速入弯)
+    float speedLimit(float maxSpeed, float latAccel, float decel) const;
+    float getProgress() { return progress; }
+    float getLength() { return length; }
+    float getReturnStart() { return returnStart; }   // 回线变道起点的弧长
+    float getOutRadius() { return outRadius; }
+    int getSegmentCount() { return count; }
+    const PathSegment& getSegment(int i) { return segments[i]; }
+
+private:
+    PathSegment segments[AVOID_PATH_MAX_SEGMENTS];
+    int count;
+    float length;
+    float progress;
+    float returnStart;
+    float outRadius;
+
+    void addSegment(float segmentLength, float curvature);
+    int segmentAt(float s) const;
+    float project(int index, float x, float y, float& distance2) const;
+};
+
+#endif
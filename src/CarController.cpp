@@ -0,0 +1,1472 @@
+#include "CarController.h"
+
+CarController::CarController(LineSensor* lineSensor, MotorControl* motor, CarSensors* sensors,
+                             PIDController* pidController, PIDController* encoderPid,
+                             ObjectDetector* objectDetector, TaskManager* taskManager,
+                             ParameterManager* params) {
+    this->lineSensor = lineSensor;
+    this->motor = motor;
+    this->sensors = sensors;
+    this->pidController = pidController;
+    this->encoderPid = encoderPid;
+    this->objectDetector = objectDetector;
+    this->taskManager = taskManager;
+    this->params = params;
+    
+    currentState = STATE_IDLE;
+    systemRunning = false;
+    
+    pendingTestTurn = false;
+    pendingTestStraight = false;
+    pendingTestAvoid = false;
+    pendingTestParking = false;
+    pendingLineCalibration = false;
+    pendingDetectStart = false;
+    pendingDetectStop = false;
+    pendingDetectBaseline = 0;
+    pendingDetectThreshold = 0;
+    pendingWeights = false;
+    pendingTaskCmd = TASK_CMD_NONE;
+    pendingTaskQuery = false;
+    pendingManualCmd = CMD_NONE;
+    pendingManualValue = 0;
+    
+    obstacleDetectCount = 0;
+    obstacleDetectionEnabled = false;
+    
+    avoidSubState = AVOID_NONE;
+    avoidStateStartTime = 0;
+    avoidStateStartDistance = 0;
+    avoidMoveState = AVOID_NONE;
+    avoidLineFound = false;
+    avoidOrigin = {0, 0, 0, 0};
+    avoidPathSpeed = 0;
+    avoidanceFinishTime = 0;
+    postAvoidanceStable = false;
+    
+    parkingSubState = PARK_APPROACH;
+    parkingStateStartTime = 0;
+    lastParkingDebug = 0;
+    
+    currentTestState = TEST_NONE;
+    testStartTime = 0;
+    calibrationPhase = 0;
+    calibrationStartHeading = 0;
+    
+    moveKind = MOVE_STRAIGHT;
+    moveStartLeft = moveStartRight = 0;
+    moveStartHeading = 0;
+    moveLeftScale = moveRightScale = 1.0f;
+    moveHeadingKp = MOTION_HEADING_KP;
+    lastMoveUs = 0;
+    moveDoneTime = 0;
+    
+    buttonPressStart = 0;
+    buttonWasPressed = false;
+    buttonProcessed = false;
+    
+    manualControlActive = false;
+    manualControlEndTime = 0;
+    
+    wasLost = false;
+    appliedLineMode = -1;
+    appliedLineStream = -1;
+    appliedLineCalRevision = 0;
+    lastPidDebug = 0;
+    
+    lineFollowStartTime = 0;
+    totalLineFollowTime = 0;
+    loopCounter = 0;
+    loopFrequency = 0;
+    lastStatsTime = 0;
+    controlLinePosition = 0;
+    pendingDisplayMessage = nullptr;
+    
+    lastLineSeq = UINT32_MAX;
+    lastEstimateSeq = UINT32_MAX;
+    taskTriggerBase = 0;
+    lapCount = 0;
+    lapStartMs = 0;
+    lastLapMs = 0;
+}
+
+// 按当前参数配置控制器 (外设初始化之后调用)
+void CarController::begin() {
+    lineSensor->setWeights(params->sensorWeights);
+    lineSensor->setCalibration(params->lineCalMin, params->lineCalMax);
+    appliedLineCalRevision = params->lineCalRevision;
+    applyLineMode();
+    
+    motor->setCalibration(params->motorLeftCalib, params->motorRightCalib);
+    motor->setDeadband(params->motorDeadband); // 设置死区
+    motor->setVelocityGains(params->velKp, params->velKi, params->velKff);
+    motor->stop();
+    
+    // 初始化PID控制器
+    pidController->setGains(params->kp, params->ki, params->kd);
+    pidController->setSetpoint(0);  // 目标位置为中心
+    pidController->setIntegralRange(params->pidIntegralRange); // 设置积分分离
+    pidController->setOutputLimits(-255, 255);
+    
+    // 初始化编码器PID
+    encoderPid->setGains(params->encKp, params->encKi, params->encKd);
+    encoderPid->setSetpoint(0); // 目标差值为0
+    encoderPid->setOutputLimits(-50, 50); // 限制修正量
+    
+    objectDetector->setDeviationCorrection(params->objectDeviationCorrection);
+    trackMap.begin();
+    
+    currentState = STATE_IDLE;
+    systemRunning = false;
+    lastStatsTime = millis();
+}
+
+const char* CarController::takeDisplayMessage() {
+    const char* msg = pendingDisplayMessage;
+    if (msg) {
+        pendingDisplayMessage = nullptr;
+    }
+    return msg;
+}
+
+// 任务执行器 - 启动任务
+bool CarController::executeTask(Task* task) {
+    if (!task) return false;
+    
+    switch (task->type) {
+        case TASK_LINE_FOLLOW:
+            // 开启循迹模式
+            systemRunning = true;
+            currentState = STATE_LINE_FOLLOW;
+            taskTriggerBase = trackFeatures.getCount((TrackFeature)task->params.trigger);
+            return true;
+            
+        case TASK_MEASURE_OBJECT:
+            // 启动物块测量
+            objectDetector->startDetection(
+                task->params.laserBaseline, 
+                task->params.laserThreshold
+            );
+            return true;
+            
+        case TASK_FORWARD:
+            // 前进指定距离 (按速度曲线走到并停在目标处) 或指定时间
+            motor->resetEncoders();
+            {
+                int speed = task->params.speed > 0 ? task->params.speed : params->speedNormal;
+                if (task->params.distance > 0) {
+                    startMove(MOVE_STRAIGHT, task->params.distance, speed * VELOCITY_MMS_PER_UNIT);
+                } else {
+                    driveWheels(speed, speed);
+                }
+            }
+            return true;
+            
+        case TASK_STOP:
+            // 停止
+            systemRunning = false;
+            motor->stop();
+            return true;
+            
+        case TASK_DELAY:
+            // 延时（通过startTime判断）
+            return true;
+            
+        case TASK_BEEP:
+            // 蜂鸣
+            // sensors->beep(task->params.duration > 0 ? task->params.duration : 100);
+            return true;
+            
+        default:
+            Serial.printf("⚠ Unknown task type: %d\n", task->type);
+            return false;
+    }
+}
+
+// 任务完成检查器
+bool CarController::checkTaskCompletion(Task* task) {
+    if (!task) return true;
+    
+    switch (task->type) {
+        case TASK_LINE_FOLLOW:
+            // 循迹任务需要手动停止、达到距离或出现指定赛道特征
+            if (task->params.trigger != FEATURE_NONE &&
+                trackFeatures.getCount((TrackFeature)task->params.trigger) > taskTriggerBase) {
+                return true;
+            }
+            if (task->params.distance > 0) {
+                float avgDist = motor->getAverageDistance();
+                return avgDist >= task->params.distance;
+            }
+            return false;  // 无限循迹，需要其他条件停止
+            
+        case TASK_MEASURE_OBJECT:
+            // 检查物块测量是否完成
+            return objectDetector->isCompleted() || 
+                   (millis() - task->startTime > 30000);  // 30秒超时
+            
+        case TASK_FORWARD:
+            // 检查是否达到目标距离 (曲线走完并到位)
+            if (task->params.distance > 0) {
+                return updateMove();
+            } else if (task->params.duration > 0) {
+                // 按时间前进
+                if (millis() - task->startTime >= task->params.duration) {
+                    motor->stop();
+                    return true;
+                }
+            }
+            return false;
+            
+        case TASK_STOP:
+            return true;  // 立即完成
+            
+        case TASK_DELAY:
+            return (millis() - task->startTime) >= task->params.duration;
+            
+        case TASK_BEEP:
+            return true;  // 立即完成
+            
+        default:
+            return true;
+    }
+}
+
+// 运动控制回调 (仅设置标志位，不在中断/异步任务中执行逻辑)
+void CarController::requestMotion(String action, float value) {
+    // 映射字符串命令到枚举，确保原子操作
+    if (action == "stop") pendingManualCmd = CMD_STOP;
+    else if (action == "forward") pendingManualCmd = CMD_FORWARD;
+    else if (action == "backward") pendingManualCmd = CMD_BACKWARD;
+    else if (action == "left") pendingManualCmd = CMD_LEFT;
+    else if (action == "right") pendingManualCmd = CMD_RIGHT;
+    else if (action == "turn_180") pendingManualCmd = CMD_TURN_180;
+    
+    pendingManualValue = value;
+}
+
+// 处理挂起的命令 (在主循环中调用)
+bool CarController::requestTaskCommand(TaskCommand cmd, const String& json) {
+    if (pendingTaskCmd != TASK_CMD_NONE) {
+        return false;
+    }
+    pendingTaskJson = json;
+    pendingTaskCmd = cmd;
+    return true;
+}
+
+String CarController::queryTasksJson(uint32_t timeoutMs) {
+    // 上次超时未取走的查询仍然有效, 控制任务写完回复才清标志
+    pendingTaskQuery = true;
+    unsigned long start = millis();
+    while (pendingTaskQuery) {
+        if (millis() - start >= timeoutMs) {
+            return "";
+        }
+        delay(1);
+    }
+    return taskQueryReply;
+}
+
+void CarController::processPendingCommands() {
+    // 1. 处理测试命令
+    if (pendingTestTurn) {
+        pendingTestTurn = false;
+        if (!systemRunning) {
+            Serial.println("CMD: Starting Turn 90 Test");
+            currentState = STATE_TESTING;
+            currentTestState = TEST_TURN_90;
+            testStartTime = millis();
+            motor->resetEncoders();
+            startMove(MOVE_SPIN, params->turn90Dist, params->avoidTurnSpeed * VELOCITY_MMS_PER_UNIT);
+            systemRunning = true;
+        }
+    }
+    
+    if (pendingTestStraight) {
+        pendingTestStraight = false;
+        if (!systemRunning) {
+            Serial.println("CMD: Starting Straight 1m Test");
+            currentState = STATE_TESTING;
+            currentTestState = TEST_STRAIGHT_1M;
+            testStartTime = millis();
+            motor->resetEncoders();
+            encoderPid->reset();
+            encoderPid->setGains(params->encKp, params->encKi, params->encKd);
+            systemRunning = true;
+        }
+    }
+    
+    if (pendingTestAvoid) {
+        pendingTestAvoid = false;
+        if (!systemRunning) {
+            Serial.println("CMD: Starting Avoidance Test");
+            // 圆弧模式按前方读数规划 (没有读数或比触发距离远时按触发距离)
+            float obstacleCm = params->obstacleDetectDist;
+            if (sensors->isUltrasonicValid()) {
+                obstacleCm = min(sensors->getUltrasonicDistance(), obstacleCm);
+            }
+            if (!startAvoidPath(obstacleCm)) {
+                // 直接进入分步避障状态
+                currentState = STATE_OBSTACLE_AVOID;
+                avoidSubState = AVOID_TURN_LEFT;
+                avoidMoveState = AVOID_NONE;
+                avoidStateStartTime = millis();
+                motor->resetEncoders();
+                avoidStateStartDistance = 0;
+            }
+            systemRunning = true;
+            // sensors->beep(100);
+        }
+    }
+
+    if (pendingLineCalibration) {
+        pendingLineCalibration = false;
+        if (!systemRunning) {
+            Serial.println("CMD: Starting Line Sensor Calibration");
+            currentState = STATE_TESTING;
+            currentTestState = TEST_LINE_CALIBRATION;
+            calibrationPhase = 0;
+            calibrationStartHeading = odometry.getPose().heading;
+            testStartTime = millis();
+            motor->resetEncoders();
+            lineSensor->startCalibration();
+            systemRunning = true;
+        }
+    }
+
+    if (pendingTestParking) {
+        pendingTestParking = false;
+        Serial.println("CMD: Starting Parking Test");
+        
+        // 重置系统状态
+        systemRunning = true;
+        currentState = STATE_LINE_FOLLOW;
+        lineFollowStartTime = millis();
+        motor->resetEncoders();
+        pidController->reset();
+        
+        // 设置为入库测试模式
+        objectDetector->stopDetection(); // 确保不处于物块检测模式
+        obstacleDetectionEnabled = true; // 启用障碍物检测
+        obstacleDetectCount = 1; // 假装已经避过第一个障碍物，下一个就是车库
+        
+        // sensors->beep(100);
+        // delay(50);
+        // sensors->beep(100);
+        postDisplayMessage("TEST PARKING\nSearching...");
+    }
+    
+    if (pendingDetectStop) {
+        pendingDetectStop = false;
+        objectDetector->stopDetection();
+    }
+    
+    if (pendingDetectStart) {
+        pendingDetectStart = false;
+        objectDetector->setFilterSize(params->objectFilterSize);
+        objectDetector->setCorrection(params->objectLengthScale, params->objectLengthOffset);
+        objectDetector->setDeviationCorrection(params->objectDeviationCorrection);
+        objectDetector->startDetection(pendingDetectBaseline, pendingDetectThreshold);
+    }
+    
+    // 先清标志再读权重: 读取期间网页又改了权重时下个周期再重建一次
+    if (pendingWeights) {
+        pendingWeights = false;
+        lineSensor->setWeights(params->sensorWeights);
+    }
+    
+    // 任务列表: 执行完再清除标志, 网页才能投递下一条
+    if (pendingTaskCmd != TASK_CMD_NONE) {
+        switch (pendingTaskCmd) {
+            case TASK_CMD_LOAD:  taskManager->loadTasksFromJson(pendingTaskJson); break;
+            case TASK_CMD_START: taskManager->startExecution(); break;
+            case TASK_CMD_STOP:  taskManager->stopExecution(); break;
+            case TASK_CMD_CLEAR: taskManager->clearAllTasks(); break;
+            default: break;
+        }
+        pendingTaskJson = "";
+        pendingTaskCmd = TASK_CMD_NONE;
+    }
+    
+    if (pendingTaskQuery) {
+        taskQueryReply = taskManager->getTasksJson();
+        pendingTaskQuery = false;
+    }
+    
+    // 2. 处理手动控制命令
+    if (pendingManualCmd != CMD_NONE) {
+        ManualCommand cmd = pendingManualCmd;
+        float val = pendingManualValue;
+        pendingManualCmd = CMD_NONE; // 清除标志
+        
+        // 执行逻辑
+        if (cmd == CMD_STOP) {
+            motor->stop();
+            manualControlActive = false;
+            if (systemRunning) Serial.println("Manual Stop");
+        } else {
+            // 激活手动控制
+            if (systemRunning) {
+                Serial.println("Auto mode paused for manual control");
+            }
+            manualControlActive = true;
+            
+            int moveSpeed = (val > 0) ? (int)val : params->speedNormal;
+            int turnSpeed = params->speedTurn;
+            
+            switch (cmd) {
+                case CMD_FORWARD:
+                    motor->setBothSpeed(moveSpeed);
+                    manualControlEndTime = millis() + 10000;
+                    break;
+                case CMD_BACKWARD:
+                    motor->setBothSpeed(-moveSpeed);
+                    manualControlEndTime = millis() + 10000;
+                    break;
+                case CMD_LEFT:
+                    motor->setLeftSpeed(-turnSpeed);
+                    motor->setRightSpeed(turnSpeed);
+                    manualControlEndTime = millis() + 10000;
+                    break;
+                case CMD_RIGHT:
+                    motor->setLeftSpeed(turnSpeed);
+                    motor->setRightSpeed(-turnSpeed);
+                    manualControlEndTime = millis() + 10000;
+                    break;
+                case CMD_TURN_180:
+                    motor->setLeftSpeed(turnSpeed);
+                    motor->setRightSpeed(-turnSpeed);
+                    manualControlEndTime = millis() + 1200;
+                    break;
+                default: break;
+            }
+        }
+    }
+}
+
+// 原地转向进度 (单轮行程mm): 陀螺仪航向可用时取转过的角度, 按无打滑几何换算成单轮行程
+// (原有行程参数直接沿用, 118mm≈90°), 否则取两轮中行程较大者
+float CarController::turnProgress(float deltaLeft, float deltaRight, float startHeading) {
+    if (params->imuTurns && headingEstimator.isGyroActive()) {
+        return fabsf(odometry.getPose().heading - startHeading) * ODOM_TRACK_MM / 2;
+    }
+    return max(fabsf(deltaLeft), fabsf(deltaRight));
+}
+
+// 启动离散动作: 目标为直行距离或原地转单轮弧长 (正为左转), maxSpeed 为曲线限速 (mm/s);
+// 从当前实测轮速起步, 运动中的车接着走不会突变
+void CarController::startMove(MoveKind kind, float target, float maxSpeed, float leftScale, float rightScale,
+                              float headingKp) {
+    moveKind = kind;
+    moveStartLeft = motor->getLeftDistance();
+    moveStartRight = motor->getRightDistance();
+    moveStartHeading = odometry.getPose().heading;
+    moveLeftScale = leftScale;
+    moveRightScale = rightScale;
+    moveHeadingKp = headingKp;
+    lastMoveUs = micros();
+    moveDoneTime = 0;
+
+    float left = motor->getLeftSpeed();
+    float right = motor->getRightSpeed();
+    float vel = kind == MOVE_STRAIGHT ? (left + right) / 2 : (right - left) / 2;
+    moveProfile.setLimits(maxSpeed, params->moveAccel, params->moveJerk);
+    moveProfile.start(target, vel);
+}
+
+// 当前动作的实测进度 (与曲线同单位): 直行取两轮平均行程, 原地转取 turnProgress 并带上方向
+float CarController::moveProgress() {
+    float deltaLeft = motor->getLeftDistance() - moveStartLeft;
+    float deltaRight = motor->getRightDistance() - moveStartRight;
+    if (moveKind == MOVE_STRAIGHT) {
+        return (deltaLeft + deltaRight) / 2;
+    }
+    float direction = moveProfile.getTarget() >= 0 ? 1.0f : -1.0f;
+    return direction * turnProgress(deltaLeft, deltaRight, moveStartHeading);
+}
+
+// 距上次调用的时间 (s), 离散动作与圆弧绕行按实际周期推进
+float CarController::takeMoveDt() {
+    uint32_t now = micros();
+    float dt = (now - lastMoveUs) * 1e-6f;
+    lastMoveUs = now;
+    if (dt <= 0 || dt > 0.05f) {
+        dt = 1.0f / CONTROL_LOOP_HZ;   // 首个周期/长时间未调用: 按标称周期推进
+    }
+    return dt;
+}
+
+// 每个控制周期推进曲线, 目标轮速 = 曲线速度 + 位置误差修正, 交给轮速闭环;
+// 曲线走完且实测到位 (或等待超过 MOTION_SETTLE_MS) 后停车并返回 true
+bool CarController::updateMove() {
+    const MotionState& sp = moveProfile.step(takeMoveDt());
+
+    float progress = moveProgress();
+    float vel = sp.vel + MOTION_POS_KP * (sp.pos - progress);
+    if (moveKind == MOVE_STRAIGHT) {
+        float deltaLeft = motor->getLeftDistance() - moveStartLeft;
+        float deltaRight = motor->getRightDistance() - moveStartRight;
+        float adjustment = (deltaLeft - deltaRight) * moveHeadingKp;
+        motor->setVelocity(vel * moveLeftScale - adjustment, vel * moveRightScale + adjustment);
+    } else {
+        motor->setVelocity(-vel * moveLeftScale, vel * moveRightScale);
+    }
+
+    if (!moveProfile.isDone()) {
+        return false;
+    }
+    if (moveDoneTime == 0) {
+        moveDoneTime = millis();
+    }
+    bool settled = fabsf(moveProfile.getTarget() - progress) < MOTION_DONE_MM;
+    if (!settled && millis() - moveDoneTime < MOTION_SETTLE_MS) {
+        return false;
+    }
+    motor->stop();
+    return true;
+}
+
+// 圆弧模式: 按障碍物距离规划绕行路径, 直接进入 AVOID_PATH (不停车);
+// 分步模式或障碍物太近来不及变道时返回 false, 由调用方按原流程分步绕行
+bool CarController::startAvoidPath(float obstacleCm) {
+    if (!params->avoidMode) {
+        return false;
+    }
+    // 障碍物假定居中压在赛道上, 绕行时驱动轴中心偏到 (障碍物宽 + 车宽)/2 + 余量
+    AvoidGeometry geometry;
+    geometry.obstacleFront = obstacleCm * 10 + AVOID_SONAR_FORWARD_MM;
+    geometry.obstacleLength = OBSTACLE_LENGTH_CM * 10;
+    geometry.offset = (OBSTACLE_WIDTH_CM + CAR_WIDTH_CM) * 10 / 2 + params->avoidMargin;
+    geometry.radius = params->avoidRadius;
+    geometry.margin = params->avoidMargin;
+    if (!avoidPath.plan(geometry)) {
+        Serial.printf("⚠ Obstacle too close for arc path (%.1fcm), using step sequence\n", obstacleCm);
+        return false;
+    }
+    Serial.printf("Avoid path: %d segments, %.0fmm, radius %.0fmm\n",
+                  avoidPath.getSegmentCount(), avoidPath.getLength(), avoidPath.getOutRadius());
+
+    avoidOrigin = odometry.getPose();
+    avoidPathSpeed = (motor->getLeftSpeed() + motor->getRightSpeed()) / 2;
+    lastMoveUs = micros();
+    currentState = STATE_OBSTACLE_AVOID;
+    avoidSubState = AVOID_PATH;
+    avoidMoveState = AVOID_NONE;
+    avoidStateStartTime = millis();
+    return true;
+}
+
+// 圆弧绕行: 纯追踪给出曲率, 车速按前方弯道限速并以 moveAccel 加减速,
+// 两轮目标轮速 v·(1 ∓ κ·轮距/2)
+void CarController::followAvoidPath() {
+    float dt = takeMoveDt();
+    Pose rel = odometry.relativeTo(avoidOrigin);
+    float curvature = avoidPath.track(rel.x, rel.y, rel.heading, AVOID_LOOKAHEAD_MM);
+
+    float maxSpeed = params->avoidSpeed * VELOCITY_MMS_PER_UNIT;
+    float target = avoidPath.speedLimit(maxSpeed, AVOID_LAT_ACCEL, params->moveAccel);
+    float step = params->moveAccel * dt;
+    avoidPathSpeed = constrain(target, avoidPathSpeed - step, avoidPathSpeed + step);
+
+    float turn = curvature * ODOM_TRACK_MM / 2;
+    motor->setVelocity(avoidPathSpeed * (1 - turn), avoidPathSpeed * (1 + turn));
+
+    // 回线变道开始后识到线, 且航向已接近原赛道方向: 直接接回循迹
+    float progress = avoidPath.getProgress();
+    bool lineSeen = lineSensor->isDataReady() && lineSensor->getRawStates() != 0;
+    if (progress >= avoidPath.getReturnStart() && lineSeen &&
+        fabsf(rel.heading) < AVOID_REJOIN_DEG * (float)PI / 180.0f) {
+        Serial.printf("✓ Avoid path: line found at %.0f/%.0fmm, resuming line follow\n",
+                      progress, avoidPath.getLength());
+        finishAvoidance();
+    } else if (progress >= avoidPath.getLength()) {
+        Serial.println("⚠ Avoid path done without line, resuming line follow");
+        finishAvoidance();
+    }
+}
+
+// 避障结束, 回到循迹 (并开始监测稳定性)
+void CarController::finishAvoidance() {
+    currentState = STATE_LINE_FOLLOW;
+    avoidSubState = AVOID_NONE;
+    pidController->reset();
+    
+    // 记录避障完成时间，开始监测稳定性
+    avoidanceFinishTime = millis();
+    postAvoidanceStable = false;
+}
+
+// 障碍物避障处理: 每一步是一段速度曲线 (起步/停车都按加速度限幅, 不再刹车等待)
+void CarController::handleObstacleAvoidance() {
+    // 超时保护
+    if (millis() - avoidStateStartTime > AVOID_TIME_MS) {
+        Serial.println("⚠ Avoidance timeout, returning to line follow");
+        currentState = STATE_LINE_FOLLOW;
+        avoidSubState = AVOID_NONE;
+        motor->stop();
+        return;
+    }
+    
+    if (avoidSubState == AVOID_PATH) {
+        followAvoidPath();
+        return;
+    }
+    
+    if (avoidSubState == AVOID_BRAKE) {
+        // 0. 保持刹车直到车停稳, 再从静止开始第一步
+        motor->brake();
+        if (millis() - avoidStateStartTime >= AVOID_BRAKE_MS) {
+            motor->stop();
+            avoidSubState = AVOID_TURN_LEFT;
+            avoidStateStartTime = millis();
+            motor->resetEncoders();
+        }
+        return;
+    }
+    
+    float turnSpeed = params->avoidTurnSpeed * VELOCITY_MMS_PER_UNIT;
+    float forwardSpeed = params->avoidSpeed * VELOCITY_MMS_PER_UNIT;
+    float searchSpeed = params->speedSlow * VELOCITY_MMS_PER_UNIT;
+    // 直行修正沿用 avoidKp (PWM/mm), 换算到轮速
+    float forwardKp = params->avoidKp * VELOCITY_MMS_PER_UNIT;
+    
+    // 进入子状态时按该步目标启动曲线 (右转目标为负)
+    if (avoidSubState != avoidMoveState) {
+        avoidMoveState = avoidSubState;
+        switch (avoidSubState) {
+            case AVOID_TURN_LEFT:
+                startMove(MOVE_SPIN, params->avoidTurn1Dist, turnSpeed, params->avoidS1_L, params->avoidS1_R);
+                break;
+            case AVOID_FORWARD_OUT:
+                startMove(MOVE_STRAIGHT, params->avoidForwardDist, forwardSpeed,
+                          params->avoidS2_L, params->avoidS2_R, forwardKp);
+                break;
+            case AVOID_TURN_RIGHT_1:
+                startMove(MOVE_SPIN, -params->avoidTurn2Dist, turnSpeed, params->avoidS3_L, params->avoidS3_R);
+                break;
+            case AVOID_FORWARD_PARALLEL:
+                startMove(MOVE_STRAIGHT, params->avoidParallelDist, forwardSpeed,
+                          params->avoidS4_L, params->avoidS4_R, forwardKp);
+                break;
+            case AVOID_TURN_RIGHT_2:
+                startMove(MOVE_SPIN, -params->avoidTurn3Dist, turnSpeed, params->avoidS5_L, params->avoidS5_R);
+                break;
+            case AVOID_FORWARD_IN:
+                // 最远走 avoidSearchDist, 途中识到线时提前停下
+                startMove(MOVE_STRAIGHT, params->avoidSearchDist, searchSpeed,
+                          params->avoidS6_L, params->avoidS6_R, forwardKp);
+                avoidLineFound = false;
+                break;
+            case AVOID_TURN_LEFT_ALIGN:
+                startMove(MOVE_SPIN, params->avoidFinalTurnDist, turnSpeed);
+                break;
+            default:
+                break;
+        }
+    }
+    bool moveDone = updateMove();
+    
+    switch (avoidSubState) {
+        case AVOID_TURN_LEFT:
+            // 1. 左转90度离开赛道
+            if (moveDone) {
+                Serial.printf("✓ Step 1: Left turn done. Progress:%.1f\n", moveProgress());
+                
+                avoidSubState = AVOID_FORWARD_OUT;
+                avoidStateStartTime = millis();
+                motor->resetEncoders();
+                // sensors->beep(50);
+            }
+            break;
+            
+        case AVOID_FORWARD_OUT:
+            // 2. 直行离开赛道 (距离由网页配置 avoidForwardDist)
+            // 万向轮横置时会产生巨大阻力，导致启动时偏向一边, 按两轮行程差修正 (avoidKp)
+            if (moveDone) {
+                Serial.printf("✓ Step 2: Forward OUT done. Dist:%.1f\n", moveProgress());
+                
+                avoidSubState = AVOID_TURN_RIGHT_1;
+                avoidStateStartTime = millis();
+                motor->resetEncoders();
+                // sensors->beep(50);
+            }
+            break;
+            
+        case AVOID_TURN_RIGHT_1:
+            // 3. 右转90度 (平行于赛道)
+            if (moveDone) {
+                Serial.printf("✓ Step 3: Right turn 1 done.\n");
+                
+                avoidSubState = AVOID_FORWARD_PARALLEL;
+                avoidStateStartTime = millis();
+                motor->resetEncoders();
+                // sensors->beep(50);
+            }
+            break;
+            
+        case AVOID_FORWARD_PARALLEL:
+            // 4. 直行 (平行移动，绕过障碍物, 距离 avoidParallelDist 需大于障碍物长度)
+            if (moveDone) {
+                Serial.printf("✓ Step 4: Parallel move done. Dist:%.1f\n", moveProgress());
+                
+                avoidSubState = AVOID_TURN_RIGHT_2;
+                avoidStateStartTime = millis();
+                motor->resetEncoders();
+                // sensors->beep(50);
+            }
+            break;
+            
+        case AVOID_TURN_RIGHT_2:
+            // 5. 右转90度 (面向赛道)
+            if (moveDone) {
+                Serial.printf("✓ Step 5: Right turn 2 done.\n");
+                
+                avoidSubState = AVOID_FORWARD_IN;
+                avoidStateStartTime = millis();
+                motor->resetEncoders();
+                // sensors->beep(50);
+            }
+            break;
+            
+        case AVOID_FORWARD_IN:
+            // 6. 慢速直行寻找黑线
+            // 只要有任意一个传感器检测到黑线(状态不为0)，即认为找到线, 曲线改为就近停下
+            if (!avoidLineFound && lineSensor->isDataReady() && lineSensor->getRawStates() != 0) {
+                avoidLineFound = true;
+                moveProfile.stop();
+            }
+            if (moveDone) {
+                if (avoidLineFound) {
+                    Serial.println("✓ Step 6: Line found!");
+                } else {
+                    // 走完搜索距离仍未识线
+                    Serial.println("⚠ Line not found, forcing align");
+                }
+                
+                avoidSubState = AVOID_TURN_LEFT_ALIGN;
+                avoidStateStartTime = millis();
+                motor->resetEncoders();
+                // sensors->beep(100);
+            }
+            break;
+            
+        case AVOID_TURN_LEFT_ALIGN:
+            // 7. 左转90度对齐赛道
+            if (moveDone) {
+                Serial.println("✓ Step 7: Align done, resuming line follow");
+                finishAvoidance();
+                
+                // sensors->beep(100);
+                // delay(50);
+                // sensors->beep(100);
+            }
+            break;
+            
+        default:
+            break;
+    }
+}
+
+// 入库停车处理
+void CarController::handleParking() {
+    float ultraDist = sensors->getUltrasonicDistance();
+    // 读数过期时不做距离判断, 保持当前阶段的速度继续靠近
+    bool ultraValid = sensors->isUltrasonicValid();
+    
+    // 简单的P控制保持直线 (使用编码器)
+    // 目标是左右轮走过的距离相等
+    float error = motor->getLeftDistance() - motor->getRightDistance();
+    int adjustment = (int)(error * params->encKp); // 使用编码器PID参数或固定Kp
+    
+    switch (parkingSubState) {
+        case PARK_APPROACH:
+            // 阶段1: 接近车库
+            // 如果距离还很远(>减速距离)，可以用稍快一点的速度(如speedSlow)
+            // 如果距离进入减速范围(<减速距离)，用parkingSpeedSlow
+            
+            if (!ultraValid || ultraDist > params->parkingDistSlow) {
+                // 还没到减速区，保持慢速接近
+                motor->setLeftSpeed(params->speedSlow - adjustment);
+                motor->setRightSpeed(params->speedSlow + adjustment);
+            } else {
+                // 进入减速区
+                motor->setLeftSpeed(params->parkingSpeedSlow - adjustment);
+                motor->setRightSpeed(params->parkingSpeedSlow + adjustment);
+                
+                // 检查是否进入极慢速区
+                if (ultraValid && ultraDist <= params->parkingDistVerySlow) {
+                    Serial.printf("✓ Parking: Entering Very Slow Zone (Dist: %.1fcm)\n", ultraDist);
+                    parkingSubState = PARK_VERY_SLOW;
+                }
+            }
+            break;
+            
+        case PARK_VERY_SLOW:
+            // 阶段2: 极慢速靠近
+            motor->setLeftSpeed(params->parkingSpeedVerySlow - adjustment);
+            motor->setRightSpeed(params->parkingSpeedVerySlow + adjustment);
+            
+            // 检查是否到达停止距离
+            if (ultraValid && ultraDist <= params->parkingDistStop) {
+                Serial.printf("✓ Parking: Stop Distance Reached (Dist: %.1fcm)\n", ultraDist);
+                motor->brake();
+                
+                parkingSubState = PARK_STOP;
+                parkingStateStartTime = millis();
+            }
+            break;
+            
+        case PARK_STOP:
+            // 阶段3: 刹车 PARKING_BRAKE_MS 后松开
+            motor->brake();
+            if (millis() - parkingStateStartTime >= PARKING_BRAKE_MS) {
+                motor->stop();
+                parkingSubState = PARK_ALARM;
+                parkingStateStartTime = millis();
+                Serial.println("✓ Parking: Stopped, Alarm starting...");
+            }
+            break;
+            
+        case PARK_ALARM:
+            // 阶段4: 报警3秒
+            sensors->setAlarm(true);
+            
+            if (millis() - parkingStateStartTime >= 3000) {
+                sensors->setAlarm(false);
+                Serial.println("✓ Parking completed!");
+                currentState = STATE_FINISHED;
+                systemRunning = false;
+            }
+            break;
+    }
+    
+    // 调试输出 (每500ms)
+    if (millis() - lastParkingDebug > 500) {
+        Serial.printf("[Parking] State:%d Dist:%.1fcm\n", parkingSubState, ultraDist);
+        lastParkingDebug = millis();
+    }
+}
+
+// 循迹采集/传输模式只在参数变化时下发, 传感器自行退回数字/请求模式后不会被反复切回
+void CarController::applyLineMode() {
+    appliedLineMode = params->lineMode;
+    appliedLineStream = params->lineStream;
+    lineSensor->setPositionMethod(appliedLineMode == 2 ? LINE_POS_QUADRATIC : LINE_POS_CENTROID);
+    lineSensor->setMode(appliedLineMode == 0 ? LINE_MODE_DIGITAL : LINE_MODE_ANALOG);
+    lineSensor->setStreaming(appliedLineStream != 0);
+    lineEstimator.setMeasurementNoise(appliedLineMode == 0 ? LINE_EST_DIGITAL_SIGMA : LINE_EST_ANALOG_SIGMA);
+}
+
+void CarController::updateSensors() {
+    if (params->lineMode != appliedLineMode || params->lineStream != appliedLineStream) {
+        applyLineMode();
+    }
+    // 网页导入/恢复默认后的校准值在控制线程下发, 不必重启
+    if (params->lineCalRevision != appliedLineCalRevision) {
+        appliedLineCalRevision = params->lineCalRevision;
+        lineSensor->setCalibration(params->lineCalMin, params->lineCalMax);
+    }
+    {
+        PerfScope scope(profiler, PERF_LINE_SENSOR);
+        lineSensor->update();
+        
+        // 每个新帧更新一次线状态估计 (按帧时间戳, 不依赖控制周期)
+        const LineSnapshot& snapshot = lineSensor->getSnapshot();
+        if (lineSensor->isDataReady() && snapshot.seq != lastEstimateSeq) {
+            lastEstimateSeq = snapshot.seq;
+            lineEstimator.update(snapshot);
+        }
+        
+        // 循迹时每个新帧送入特征分类 (与控制周期解耦); 避障/测试等动作中压线不算赛道特征
+        if (systemRunning && currentState == STATE_LINE_FOLLOW) {
+            if (lineSensor->isDataReady() && snapshot.seq != lastLineSeq) {
+                lastLineSeq = snapshot.seq;
+                TrackFeature feature = trackFeatures.update(snapshot, odometry.getPose().distance);
+                if (feature != FEATURE_NONE) {
+                    onTrackFeature(feature);
+                }
+            }
+        } else if (currentState != STATE_IDLE) {
+            trackFeatures.interrupt();
+            // 避障/入库时里程计连续, 地图照常分格 (记为曲率未知); 测试等其他动作中本圈作废
+            if (currentState != STATE_OBSTACLE_AVOID && currentState != STATE_PARKING) {
+                trackMap.abortRecording();
+            }
+        }
+    }
+    {
+        PerfScope scope(profiler, PERF_SENSORS);
+        sensors->update();  // 更新激光等传感器
+    }
+    {
+        PerfScope scope(profiler, PERF_MOTOR);
+        motor->update();
+        WheelStep step = odometry.takeStep(motor->getLeftTotalCount(), motor->getRightTotalCount());
+        bool still = fabsf(motor->getLeftSpeed()) < IMU_STILL_SPEED && fabsf(motor->getRightSpeed()) < IMU_STILL_SPEED;
+        odometry.integrate(step, headingEstimator.update(odometry.wheelTurn(step), still));
+    }
+    
+    // 赛道学习: 第一圈循迹中逐周期记录航向与线偏移 (线位置向右为正, 地图按向左为正)
+    if (trackMap.isRecording()) {
+        trackMap.record(odometry.getPose(), -lineSensor->getLinePosition() * TRACK_LINE_MM_PER_UNIT,
+                        !lineSensor->isLostLine(), currentState == STATE_LINE_FOLLOW);
+    }
+    
+    controlLinePosition = lineSensor->getLinePosition();
+    
+    // 更新物块检测器（如果正在检测）
+    if (objectDetector->isDetecting()) {
+        {
+            PerfScope scope(profiler, PERF_OBJECT_DETECTOR);
+            objectDetector->update(controlLinePosition);
+        }
+        
+        // 如果检测完成，启用障碍物检测
+        if (objectDetector->isCompleted() && !obstacleDetectionEnabled) {
+            obstacleDetectionEnabled = true;
+            Serial.println("✓ Object measurement completed, obstacle detection enabled");
+            // sensors->beep(50);
+            // delay(50);
+            // sensors->beep(50);
+        }
+    }
+    
+    // 更新循环计数器（用于监控频率）
+    loopCounter++;
+    
+    // 每秒重置计数器
+    if (millis() - lastStatsTime >= 1000) {
+        lastStatsTime = millis();
+        loopFrequency = loopCounter;
+        loopCounter = 0;
+    }
+}
+
+// 赛道特征事件: 记录日志, 起/终点横条作为圈标记
+void CarController::onTrackFeature(TrackFeature feature) {
+    // 事件里程与地图录制/查表同为里程计累计里程, 圈起点取横条起点
+    float eventDistance = trackFeatures.getLastEvent().distanceMm;
+    Serial.printf("◆ Track feature: %s at %.0fmm\n", TrackFeatures::name(feature), eventDistance);
+    
+    if (feature == FEATURE_STOP_BAR && systemRunning && currentState == STATE_LINE_FOLLOW) {
+        unsigned long now = millis();
+        if (lapStartMs != 0) {
+            lastLapMs = now - lapStartMs;
+            lapCount++;
+            Serial.printf("◆ Lap %u: %.2fs\n", lapCount, lastLapMs / 1000.0f);
+        }
+        lapStartMs = now;
+        
+        // 赛道学习: 横条之间为一圈, 录完后按当前参数生成速度曲线
+        if (trackMap.lapMark(eventDistance, params->trackLearn)) {
+            trackMap.computeProfile(params->trackLatAccel, params->moveAccel, params->moveAccel);
+            Serial.printf("◆ Track map: %.2fm, %d bins, min radius %.0fmm\n", trackMap.getLength() / 1000.0f,
+                          trackMap.getBinCount(), trackMap.getMinRadius());
+        }
+    }
+}
+
+// 速度曲线给出的基础速度 (速度档位, 限幅到 [minSpeed, maxSpeed]); 未启用/无地图/里程对不上时返回 -1
+int CarController::plannedBaseSpeed(int minSpeed, int maxSpeed) {
+    if (!params->trackLearn) {
+        return -1;
+    }
+    float speed = trackMap.speedAt(odometry.getPose().distance, TRACK_LOOKAHEAD_MM);
+    if (speed < 0) {
+        return -1;
+    }
+    return constrain((int)(speed / VELOCITY_MMS_PER_UNIT), minSpeed, maxSpeed);
+}
+
+// 循迹/前进任务的轮速输出: 速度档位 (-255~255), 轮速闭环模式下换算为 mm/s 交给 MotorControl
+void CarController::driveWheels(int leftSpeed, int rightSpeed) {
+    if (params->velocityMode) {
+        motor->setVelocity(leftSpeed * VELOCITY_MMS_PER_UNIT, rightSpeed * VELOCITY_MMS_PER_UNIT);
+    } else {
+        motor->setLeftSpeed(leftSpeed);
+        motor->setRightSpeed(rightSpeed);
+    }
+}
+
+// PID循迹控制
+void CarController::lineFollowControl() {
+    // 避障后稳定性检测逻辑
+    if (avoidanceFinishTime > 0 && !postAvoidanceStable) {
+        if (lineSensor->isLostLine()) {
+            // 如果在稳定期内丢线，重置计时器
+            avoidanceFinishTime = millis();
+        } else {
+            // 持续识线超过1秒
+            if (millis() - avoidanceFinishTime > 1000) {
+                postAvoidanceStable = true;
+                Serial.println("✓ Post-avoidance stability achieved: Lost line -> Straight mode enabled");
+            }
+        }
+    }
+
+    // 检查数据就绪
+    if (!lineSensor->isDataReady()) {
+        Serial.println("⚠ Line sensor data not ready!");
+        motor->stop();
+        return;
+    }
+    
+    // 障碍物检测（物块测量完成后启用）
+    if (obstacleDetectionEnabled && obstacleDetectCount < 2) {
+        float ultraDist = sensors->getUltrasonicDistance();
+        
+        // 检测到障碍物 (过期读数不参与判断)
+        if (sensors->isUltrasonicValid() && ultraDist < params->obstacleDetectDist && ultraDist > 2.0) {
+            obstacleDetectCount++;
+            Serial.printf("\n🚧 Obstacle %d detected! Distance: %.1fcm\n", obstacleDetectCount, ultraDist);
+            
+            if (obstacleDetectCount == 1) {
+                // 第一次：执行避障
+                Serial.println("=== Starting Obstacle Avoidance ===");
+                if (startAvoidPath(ultraDist)) {
+                    return;
+                }
+                
+                // 分步绕行: 立即刹车，防止冲向障碍物 (刹停计时在 AVOID_BRAKE 中)
+                motor->brake();
+                
+                currentState = STATE_OBSTACLE_AVOID;
+                avoidSubState = AVOID_BRAKE;
+                avoidMoveState = AVOID_NONE;
+                avoidStateStartTime = millis();
+                avoidStateStartDistance = 0;
+                // sensors->beep(100); // 短促提示音
+                return;
+            } else if (obstacleDetectCount == 2) {
+                // 第二次：执行入库停车
+                Serial.println("=== Starting Parking Procedure ===");
+                currentState = STATE_PARKING;
+                parkingSubState = PARK_APPROACH;
+                parkingStateStartTime = millis();
+                motor->resetEncoders();
+                // sensors->beep(200); // 长提示音
+                return;
+            }
+        }
+    }
+    
+    // 获取线位置 (-1000 到 +1000)
+    int16_t linePosition = lineSensor->getLinePosition();
+    
+    // 检测丢线
+    if (lineSensor->isLostLine()) {
+        if (!wasLost) {
+            Serial.println("⚠ Line lost! Searching...");
+            wasLost = true;
+        }
+        
+        // 特殊逻辑：如果避障后已经稳定行驶过1秒，丢线后直接走直线
+        if (postAvoidanceStable) {
+            driveWheels(params->speedSlow, params->speedSlow); // 使用慢速直行
+            return;
+        }
+
+        // 丢线时减速搜索
+        int searchSpeed = params->speedSlow;
+        int16_t lastPos = lineSensor->getLastPosition();
+        
+        // 修改：去除直行搜索，总是旋转搜索
+        if (lastPos >= 0) {
+            // 上次在右边或中间，右转搜索
+            driveWheels(searchSpeed, searchSpeed / 3);
+        } else {
+            // 上次在左边，左转搜索
+            driveWheels(searchSpeed / 3, searchSpeed);
+        }
+        return;
+    }
+    
+    // 如果刚找回线，重置PID
+    if (wasLost) {
+        Serial.println("✓ Line found! Resetting PID...");
+        pidController->reset();
+        wasLost = false;
+        // 找回线时短暂蜂鸣提示
+        // sensors->beep(50); 
+    }
+    
+    // 更新PID参数（支持Web实时调整）
+    // 增益调度: 阶段基础增益 × 调度表系数 (阶段 / 实测轮速 / 误差, 插值), 输入不变时不重算
+    float baseKp, baseKi, baseKd;
+    int currentSpeedNormal, currentSpeedFast, currentSpeedTurn;
+    GainPhase gainPhase;
+    
+    // 根据物块检测状态选择参数组
+    if (objectDetector->isCompleted()) {
+        // Phase 2: 测距完成后
+        baseKp = params->kpPost;
+        baseKi = params->kiPost;
+        baseKd = params->kdPost;
+        currentSpeedNormal = params->speedNormalPost;
+        currentSpeedFast = params->speedFastPost;
+        currentSpeedTurn = params->speedTurnPost;
+        gainPhase = GAIN_PHASE_POST;
+    } else {
+        // Phase 1: 测距前及测距中
+        baseKp = params->kp;
+        baseKi = params->ki;
+        baseKd = params->kd;
+        currentSpeedNormal = params->speedNormal;
+        currentSpeedFast = params->speedFast;
+        currentSpeedTurn = params->speedTurn;
+        gainPhase = objectDetector->isDetecting() ? GAIN_PHASE_MEASURE : GAIN_PHASE_PRE;
+    }
+    
+    float wheelSpeed = (motor->getLeftSpeed() + motor->getRightSpeed()) / 2;
+    GainChange gainChange = gainScheduler.update(params->gainSchedule, params->gainRevision, gainPhase,
+                                                 wheelSpeed, linePosition, baseKp, baseKi, baseKd);
+    if (gainChange == GAIN_CHANGED_CONFIG) {
+        // 阶段切换、基础增益或调度表改动时无扰过渡 (输出差值按 PID_BUMPLESS_MS 衰减)
+        pidController->setGainsBumpless(gainScheduler.getKp(), gainScheduler.getKi(), gainScheduler.getKd());
+    } else if (gainChange == GAIN_CHANGED_INPUT) {
+        // 随轮速/误差插值的变化本身就是调度, 直接生效; 若也走无扰过渡, 补偿量会抵消调度效果
+        pidController->setGains(gainScheduler.getKp(), gainScheduler.getKi(), gainScheduler.getKd());
+    }
+    pidController->setIntegralRange(params->pidIntegralRange); // 实时更新积分分离阈值
+    pidController->setDerivativeCutoff(params->pidDCutoff);
+    motor->setDeadband(params->motorDeadband); // 实时更新死区
+    motor->setVelocityGains(params->velKp, params->velKi, params->velKff);
+    
+    // PID计算差速 (按帧时刻, 每个新帧算一次): 估计器置信度足够时微分项用估计的横向速度, 否则对量化位置差分
+    uint32_t sampleUs = lineSensor->getSnapshot().timestampUs;
+    float pidOutput;
+    if (params->lineEstimator && lineEstimator.getConfidence() >= LINE_EST_MIN_CONFIDENCE) {
+        pidOutput = pidController->computeAt(linePosition, lineEstimator.getRate(), sampleUs);
+    } else {
+        pidOutput = pidController->computeAt(linePosition, sampleUs);
+    }
+    
+    // 基础速度
+    int baseSpeed = currentSpeedNormal;
+    int maxSpeed = currentSpeedFast;
+    int minSpeed = currentSpeedTurn; // 转弯速度作为下限
+    
+    // 已学到赛道地图: 按里程查预先算好的速度曲线 (弯前已减速), 否则按当前误差调速
+    int plannedSpeed = plannedBaseSpeed(minSpeed, maxSpeed);
+    if (plannedSpeed >= 0) {
+        baseSpeed = plannedSpeed;
+    } else {
+        // 优化：基于误差的连续动态速度调整
+        // 误差越大，速度越慢。使用二次曲线使直道更快，弯道更稳
+        float errorRatio = constrain(abs(linePosition) / 1000.0f, 0.0f, 1.0f);
+        
+        // 动态速度公式: Base = Min + (Max - Min) * (1 - ratio^2)
+        // ratio=0(直道) -> MaxSpeed
+        // ratio=1(急弯) -> MinSpeed
+        baseSpeed = minSpeed + (int)((maxSpeed - minSpeed) * (1.0f - errorRatio * errorRatio));
+    }
+    
+    // 极端情况处理：如果误差极大(>800)，强制使用更低的速度
+    if (abs(linePosition) > 800) {
+        baseSpeed = params->speedSlow;
+    }
+    
+    // 计算左右轮速度
+    int leftSpeed = baseSpeed - pidOutput;
+    int rightSpeed = baseSpeed + pidOutput;
+    
+    // 改进：差速过大时，允许内侧轮反转(原地转向辅助)以获得更小的转弯半径
+    // 但限制反转速度，防止突然掉头
+    // leftSpeed = constrain(leftSpeed, -100, 255);
+    // rightSpeed = constrain(rightSpeed, -100, 255);
+    
+    // 目前保持正转逻辑，仅限幅
+    leftSpeed = constrain(leftSpeed, -255, 255);
+    rightSpeed = constrain(rightSpeed, -255, 255);
+    
+    // 设置电机 (轮速闭环模式下为目标轮速)
+    driveWheels(leftSpeed, rightSpeed);
+    
+    // 调试输出
+#if DEBUG_PID
+    if (millis() - lastPidDebug > 200) {  // 每200ms输出一次
+        Serial.printf("Pos:%5d | P:%6.1f I:%6.1f D:%6.1f | Out:%6.1f | L:%4d R:%4d\n",
+            linePosition, 
+            pidController->getP(), 
+            pidController->getI(), 
+            pidController->getD(),
+            pidOutput,
+            leftSpeed, 
+            rightSpeed);
+        lastPidDebug = millis();
+    }
+#endif
+}
+
+// 测试模式处理
+void CarController::handleTestMode() {
+    unsigned long stepDuration = millis() - testStartTime;
+    int forwardSpeed = params->avoidSpeed;
+    
+    // 获取当前编码器距离
+    float currentLeft = motor->getLeftDistance();
+    float currentRight = motor->getRightDistance();
+    
+    switch (currentTestState) {
+        case TEST_TURN_90:
+            // 速度曲线起步/减速, 停在目标角度 (原地转, 单轮弧长 turn90Dist)
+            if (updateMove()) {
+                Serial.printf("TEST: Turn 90 done. L:%.1f R:%.1f Heading:%.1f°\n", currentLeft, currentRight,
+                              (odometry.getPose().heading - moveStartHeading) * 180.0f / PI);
+                currentState = STATE_IDLE;
+                currentTestState = TEST_NONE;
+                systemRunning = false;
+                // sensors->beep(200);
+            }
+            break;
+            
+        case TEST_STRAIGHT_1M:
+            {
+                // 简单的P控制保持直线
+                float error = currentLeft - currentRight;
+                float adjustment = encoderPid->compute(error);
+                
+                int leftSpd = forwardSpeed - adjustment;
+                int rightSpd = forwardSpeed + adjustment;
+                
+                motor->setLeftSpeed(leftSpd);
+                motor->setRightSpeed(rightSpd);
+                
+                float avgDist = (currentLeft + currentRight) / 2.0;
+                if (avgDist >= 1000) { // 测试走1米
+                    motor->stop();
+                    Serial.printf("TEST: Straight 1m done. Err:%.1f\n", error);
+                    currentState = STATE_IDLE;
+                    currentTestState = TEST_NONE;
+                    systemRunning = false;
+                    // sensors->beep(200);
+                }
+            }
+            break;
+            
+        case TEST_LINE_CALIBRATION:
+            handleLineCalibration();
+            break;
+            
+        default:
+            motor->stop();
+            currentState = STATE_IDLE;
+            break;
+    }
+    
+    // 超时保护 (10秒)
+    if (stepDuration > 10000) {
+        Serial.println("⚠ Test timeout");
+        if (lineSensor->isCalibrating()) {
+            finishLineCalibration();
+        }
+        motor->stop();
+        currentState = STATE_IDLE;
+        currentTestState = TEST_NONE;
+        systemRunning = false;
+        // sensors->beep(500);
+    }
+}
+
+// 循迹校准: 原地右摆 -> 左摆 -> 回中, 摆角由编码器差值换算 (探头阵列在轴前方, 摆动即横扫黑线)
+void CarController::handleLineCalibration() {
+    // 转角取里程计航向 (与原地转向同一来源: 陀螺仪可用时为融合航向, 否则按 ODOM_TRACK_MM 差速)
+    float sweep = LINE_CAL_SWEEP_DEG * PI / 180.0f;
+    float turned = calibrationStartHeading - odometry.getPose().heading;   // >0 为右转
+    int speed = params->speedSlow;
+    
+    // 一直摆不到位 (打滑/被卡住) 时中止, 保留原校准
+    if (millis() - testStartTime > LINE_CAL_TIMEOUT_MS) {
+        motor->stop();
+        lineSensor->cancelCalibration();
+        postDisplayMessage("LINE CAL TIMEOUT");
+        currentState = STATE_IDLE;
+        currentTestState = TEST_NONE;
+        systemRunning = false;
+        return;
+    }
+    
+    switch (calibrationPhase) {
+        case 0:
+            motor->setLeftSpeed(speed);
+            motor->setRightSpeed(-speed);
+            if (turned >= sweep) calibrationPhase = 1;
+            break;
+        case 1:
+            motor->setLeftSpeed(-speed);
+            motor->setRightSpeed(speed);
+            if (turned <= -sweep) calibrationPhase = 2;
+            break;
+        default:
+            motor->setLeftSpeed(speed);
+            motor->setRightSpeed(-speed);
+            if (turned >= 0) {
+                motor->stop();
+                finishLineCalibration();
+                currentState = STATE_IDLE;
+                currentTestState = TEST_NONE;
+                systemRunning = false;
+            }
+            break;
+    }
+}
+
+// 成功才写入参数并保存到NVS, 失败保留原校准
+void CarController::finishLineCalibration() {
+    uint16_t calMin[LINE_SENSOR_COUNT];
+    uint16_t calMax[LINE_SENSOR_COUNT];
+    if (lineSensor->finishCalibration(calMin, calMax)) {
+        memcpy(params->lineCalMin, calMin, sizeof(calMin));
+        memcpy(params->lineCalMax, calMax, sizeof(calMax));
+        params->save();
+        postDisplayMessage("LINE CAL OK");
+    } else {
+        postDisplayMessage("LINE CAL FAILED\nCheck analog mode");
+    }
+}
+
+// 按键状态机 - 改进的防抖和切换逻辑
+void CarController::handleButton() {
+    bool buttonNow = sensors->isButtonPressed();
+    
+    if (buttonNow && !buttonWasPressed && !buttonProcessed) {
+        // 按钮刚按下
+        buttonPressStart = millis();
+        buttonWasPressed = true;
+    } else if (!buttonNow && buttonWasPressed && !buttonProcessed) {
+        // 按钮刚释放
+        unsigned long pressDuration = millis() - buttonPressStart;
+        
+        if (pressDuration >= 50 && pressDuration < 2000) {
+            // 有效短按：切换运行状态
+            systemRunning = !systemRunning;
+            buttonProcessed = true;
+            
+            if (systemRunning) {
+                currentState = STATE_LINE_FOLLOW;
+                lineFollowStartTime = millis();
+                motor->resetEncoders();
+                pidController->reset();  // 重置PID状态
+                
+                // 重置避障后状态
+                avoidanceFinishTime = 0;
+                postAvoidanceStable = false;
+                
+                // 重置圈计时与特征识别
+                lapCount = 0;
+                lapStartMs = 0;
+                trackFeatures.reset();
+                trackMap.reset();
+                
+                // 自动启动物块检测
+                currentState = STATE_LINE_FOLLOW;
+                lineFollowStartTime = millis();
+                motor->resetEncoders();
+                pidController->reset();  // 重置PID状态
+                
+                // 自动启动物块检测
+                objectDetector->setFilterSize(params->objectFilterSize);
+                objectDetector->setCorrection(params->objectLengthScale, params->objectLengthOffset);
+                objectDetector->startDetection(0, params->objectDetectDist);
+                
+                // 重置障碍物检测状态
+                obstacleDetectCount = 0;
+                obstacleDetectionEnabled = false;  // 等物块测量完成后再启用
+                
+                postDisplayMessage("RUNNING\nPress to stop");
+            } else {
+                // 停止
+                Serial.println("\n=== SYSTEM STOP ===");
+                // sensors->beep(200);
+                
+                motor->stop();
+                currentState = STATE_IDLE;
+                
+                // 停止检测
+                if (objectDetector->isDetecting()) {
+                    objectDetector->stopDetection();
+                }
+                
+                totalLineFollowTime += millis() - lineFollowStartTime;
+                
+                Serial.printf("✓ Total run time: %lu seconds\n", totalLineFollowTime / 1000);
+                postDisplayMessage("STOPPED\nPress to start");
+            }
+        } else if (pressDuration >= 2000) {
+            // 长按：重置统计
+            totalLineFollowTime = 0;
+            motor->resetEncoders();
+            Serial.println("✓ Statistics reset");
+            // sensors->beep(50);
+            // delay(100);
+            // sensors->beep(50);
+            // delay(100);
+            // sensors->beep(50);
+            buttonProcessed = true;
+        }
+    } else if (!buttonNow && buttonProcessed) {
+        // 按钮完全释放后重置处理标志
+        buttonProcessed = false;
+        buttonWasPressed = false;
+    }
+}
+
+// 传感 -> 控制 -> 电机输出
+void CarController::cycle() {
+    // 处理Web挂起的命令
+    processPendingCommands();
+
+    // 更新传感器数据
+    updateSensors();
+    
+    handleButton();
+    
+    // 手动控制模式处理
+    if (manualControlActive) {
+        if (millis() >= manualControlEndTime) {
+            motor->stop();
+            manualControlActive = false;
+            Serial.println("✓ Manual control completed");
+        }
+        return;  // 手动模式下不执行自动逻辑
+    }
+    
+    // 更新任务管理器 (任务执行器会直接切换状态和驱动电机, 必须与状态机同线程)
+    {
+        PerfScope scope(profiler, PERF_TASK_MANAGER);
+        taskManager->update();
+    }
+    
+    // 状态机
+    PerfScope scope(profiler, PERF_STATE_MACHINE);
+    switch (currentState) {
+        case STATE_IDLE:
+            motor->stop();
+            break;
+            
+        case STATE_LINE_FOLLOW:
+            if (systemRunning) {
+                lineFollowControl();
+            } else {
+                motor->stop();
+            }
+            break;
+            
+        case STATE_OBSTACLE_AVOID:
+            handleObstacleAvoidance();
+            break;
+            
+        case STATE_PARKING:
+            handleParking();
+            break;
+            
+        case STATE_FINISHED:
+            motor->stop();
+            break;
+
+        case STATE_TESTING:
+            handleTestMode();
+            break;
+    }
+}
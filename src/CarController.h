@@ -0,0 +1,272 @@
+#ifndef CAR_CONTROLLER_H
+#define CAR_CONTROLLER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "LineSensor.h"
+#include "MotorControl.h"
+#include "PIDController.h"
+#include "ParameterManager.h"
+#include "ObjectDetector.h"
+#include "TaskManager.h"
+#include "CarSensors.h"
+#include "Profiler.h"
+#include "TrackFeatures.h"
+#include "LineEstimator.h"
+#include "GainScheduler.h"
+#include "Odometry.h"
+#include "HeadingEstimator.h"
+#include "MotionProfile.h"
+#include "AvoidPath.h"
+#include "TrackMap.h"
+
+// 避障子状态
+enum AvoidanceSubState {
+    AVOID_NONE,
+    AVOID_BRAKE,          // 0. 刹停 (AVOID_BRAKE_MS 后开始绕行)
+    AVOID_TURN_LEFT,      // 1. 左转离开赛道
+    AVOID_FORWARD_OUT,    // 2. 直行离开赛道 (距离可调)
+    AVOID_TURN_RIGHT_1,   // 3. 右转 (平行于赛道)
+    AVOID_FORWARD_PARALLEL, // 4. 直行 (平行移动)
+    AVOID_TURN_RIGHT_2,   // 5. 右转 (面向赛道)
+    AVOID_FORWARD_IN,     // 6. 直行寻找黑线
+    AVOID_TURN_LEFT_ALIGN, // 7. 左转对齐赛道
+    AVOID_PATH            // 圆弧模式: 沿规划路径不停车绕行, 识线后直接接回循迹
+};
+
+// 离散动作 (按速度曲线执行): 直行, 或原地转 (目标为单轮弧长, 正为左转)
+enum MoveKind {
+    MOVE_STRAIGHT,
+    MOVE_SPIN
+};
+
+// 停车子状态
+enum ParkingSubState {
+    PARK_APPROACH,      // 接近 (减速)
+    PARK_VERY_SLOW,     // 极慢速
+    PARK_STOP,          // 刹车 (PARKING_BRAKE_MS)
+    PARK_ALARM          // 报警
+};
+
+// 测试模式状态
+enum TestSubState {
+    TEST_NONE,
+    TEST_TURN_90,
+    TEST_STRAIGHT_1M,
+    TEST_LINE_CALIBRATION   // 原地左右摆动扫线, 记录循迹每路极值
+};
+
+// 手动控制命令
+enum ManualCommand { CMD_NONE, CMD_STOP, CMD_FORWARD, CMD_BACKWARD, CMD_LEFT, CMD_RIGHT, CMD_TURN_180 };
+
+// 网页任务列表命令 (由控制任务执行)
+enum TaskCommand { TASK_CMD_NONE, TASK_CMD_LOAD, TASK_CMD_START, TASK_CMD_STOP, TASK_CMD_CLEAR };
+
+// 整车状态机: 循迹 / 物块测量 / 避障 / 入库 / 测试 / 任务执行
+// 所有状态都是成员变量, 板上只有一个实例 (控制任务), 仿真器可以同时运行多个
+class CarController {
+public:
+    CarController(LineSensor* lineSensor, MotorControl* motor, CarSensors* sensors,
+                  PIDController* pidController, PIDController* encoderPid,
+                  ObjectDetector* objectDetector, TaskManager* taskManager,
+                  ParameterManager* params);
+
+    // 按当前参数配置PID/电机/传感器权重 (外设初始化之后调用)
+    void begin();
+    // 陀螺仪数据来源 (读取任务写入); 不设置时航向只用编码器
+    void setGyroSource(GyroRing* ring) { headingEstimator.setSource(ring); }
+
+    // 单个控制周期: 传感 -> 控制 -> 电机输出 (只能在控制线程调用)
+    void cycle();
+
+    // 跨任务命令: 只设置标志, 由下一个控制周期执行
+    void requestMotion(String action, float value);
+    void requestTestTurn() { pendingTestTurn = true; }
+    void requestTestStraight() { pendingTestStraight = true; }
+    void requestTestAvoid() { pendingTestAvoid = true; }
+    void requestTestParking() { pendingTestParking = true; }
+    void requestLineCalibration() { pendingLineCalibration = true; }
+    // 网页启停物块检测: 检测器的复位和激光队列清空都必须在控制线程 (激光队列的唯一消费者) 执行
+    void requestDetectionStart(uint16_t baseline, uint16_t threshold) {
+        pendingDetectBaseline = baseline;
+        pendingDetectThreshold = threshold;
+        pendingDetectStart = true;
+    }
+    void requestDetectionStop() { pendingDetectStop = true; }
+    // 网页改了 params->sensorWeights: 位置查找表由控制线程重建 (循迹每帧都在查表)
+    void requestWeightsUpdate() { pendingWeights = true; }
+    // 任务列表只在控制线程修改 (update() 同时在遍历): 上一条未执行完时返回false
+    bool requestTaskCommand(TaskCommand cmd, const String& json = "");
+    // 任务列表JSON由下一个控制周期生成, 调用方最多等待 timeoutMs (超时返回空串)
+    String queryTasksJson(uint32_t timeoutMs);
+
+    // TaskManager回调
+    bool executeTask(Task* task);
+    bool checkTaskCompletion(Task* task);
+
+    // 状态查询 (其他任务只读)
+    SystemState getState() { return currentState; }
+    bool isRunning() { return systemRunning; }
+    int16_t getLinePosition() { return controlLinePosition; }
+    uint32_t getLoopFrequency() { return loopFrequency; }
+    unsigned long getLineFollowStartTime() { return lineFollowStartTime; }
+    unsigned long getTotalLineFollowTime() { return totalLineFollowTime; }
+    int getObstacleDetectCount() { return obstacleDetectCount; }
+    AvoidanceSubState getAvoidSubState() { return avoidSubState; }
+    
+    // 赛道特征与圈计时 (起/终点横条作为圈标记)
+    TrackFeatures& getTrackFeatures() { return trackFeatures; }
+    // 线状态估计 (滤波位置/横向速度/置信度)
+    LineEstimator& getLineEstimator() { return lineEstimator; }
+    Odometry& getOdometry() { return odometry; }
+    HeadingEstimator& getHeadingEstimator() { return headingEstimator; }
+    TrackMap& getTrackMap() { return trackMap; }
+    uint32_t getLapCount() { return lapCount; }
+    unsigned long getLastLapMs() { return lastLapMs; }
+
+    // 提示信息 (由显示任务取走绘制, 控制线程不直接操作OLED)
+    const char* takeDisplayMessage();
+
+    // 分阶段耗时统计
+    Profiler& getProfiler() { return profiler; }
+
+private:
+    LineSensor* lineSensor;
+    MotorControl* motor;
+    CarSensors* sensors;
+    PIDController* pidController;
+    PIDController* encoderPid;
+    ObjectDetector* objectDetector;
+    TaskManager* taskManager;
+    ParameterManager* params;
+    Profiler profiler;
+    TrackFeatures trackFeatures;
+    LineEstimator lineEstimator;
+    GainScheduler gainScheduler;  // 循迹PID增益调度 (调度表在 ParameterManager)
+    Odometry odometry;            // 上电起的全局位姿, 不随 resetEncoders() 清零
+    HeadingEstimator headingEstimator;  // 里程计航向增量 (陀螺仪融合)
+    MotionProfile moveProfile;    // 当前离散动作的速度曲线 (前进任务/测试/避障各步)
+    TrackMap trackMap;            // 赛道学习: 第一圈的曲率地图与之后各圈的速度曲线 (PSRAM)
+
+    // 状态变量
+    SystemState currentState;
+    bool systemRunning;  // 系统运行标志
+
+    // 跨任务通信标志 (解决并发崩溃问题)
+    volatile bool pendingTestTurn;
+    volatile bool pendingTestStraight;
+    volatile bool pendingTestAvoid;
+    volatile bool pendingTestParking;
+    volatile bool pendingLineCalibration;
+    volatile bool pendingDetectStart;
+    volatile bool pendingDetectStop;
+    volatile uint16_t pendingDetectBaseline;
+    volatile uint16_t pendingDetectThreshold;
+    volatile bool pendingWeights;
+    volatile TaskCommand pendingTaskCmd;
+    String pendingTaskJson;        // 只在 pendingTaskCmd 为空时由网页写入
+    volatile bool pendingTaskQuery;
+    String taskQueryReply;         // 只在 pendingTaskQuery 置位时由控制任务写入
+    volatile ManualCommand pendingManualCmd;
+    volatile float pendingManualValue;
+
+    // 障碍物检测计数器
+    int obstacleDetectCount;  // 检测到的障碍物次数
+    bool obstacleDetectionEnabled;  // 是否启用障碍物检测
+
+    // 避障状态
+    AvoidanceSubState avoidSubState;
+    unsigned long avoidStateStartTime;
+    float avoidStateStartDistance;
+    AvoidanceSubState avoidMoveState;     // 已启动速度曲线的子状态
+    bool avoidLineFound;                  // 第6步已识到线 (曲线正在停车)
+    AvoidPath avoidPath;                  // 圆弧模式的绕行路径 (规划坐标系原点为 avoidOrigin)
+    Pose avoidOrigin;
+    float avoidPathSpeed;                 // 圆弧模式当前目标车速 (mm/s)
+
+    // 避障后状态变量
+    unsigned long avoidanceFinishTime; // 避障完成时间
+    bool postAvoidanceStable;          // 避障后是否已稳定(持续1秒识线)
+
+    // 停车状态
+    ParkingSubState parkingSubState;
+    unsigned long parkingStateStartTime;
+    unsigned long lastParkingDebug;
+
+    // 测试模式状态
+    TestSubState currentTestState;
+    unsigned long testStartTime;
+    int calibrationPhase;   // 0=右摆 1=左摆 2=回中
+    float calibrationStartHeading;   // 开始扫线时的里程计航向 (陀螺仪可用时为融合航向)
+
+    // 离散动作状态 (startMove/updateMove)
+    MoveKind moveKind;
+    float moveStartLeft, moveStartRight;  // 开始时两轮行程 (mm)
+    float moveStartHeading;
+    float moveLeftScale, moveRightScale;  // 两轮速度系数 (避障各步的 avoidS*)
+    float moveHeadingKp;                  // 直行时两轮行程差修正
+    uint32_t lastMoveUs;
+    unsigned long moveDoneTime;           // 曲线走完的时刻, 0=未走完
+
+    // 按键状态机变量
+    unsigned long buttonPressStart;
+    bool buttonWasPressed;
+    bool buttonProcessed;  // 防止重复触发
+
+    // 手动控制变量
+    bool manualControlActive;
+    unsigned long manualControlEndTime;
+
+    // 循迹状态
+    bool wasLost;                 // 上次是否丢线
+    int appliedLineMode;          // 已下发给循迹传感器的 params->lineMode
+    int appliedLineStream;        // 已下发的 params->lineStream
+    uint32_t appliedLineCalRevision;  // 已下发给循迹传感器的 params->lineCalRevision
+    unsigned long lastPidDebug;
+
+    // 循迹统计变量
+    unsigned long lineFollowStartTime;
+    unsigned long totalLineFollowTime;
+    uint32_t loopCounter;
+    uint32_t loopFrequency;   // 上一秒的控制周期数
+    unsigned long lastStatsTime;
+
+    // 赛道特征
+    uint32_t lastLineSeq;         // 已送入 trackFeatures 的帧序号
+    uint32_t lastEstimateSeq;     // 已送入 lineEstimator 的帧序号
+    uint32_t taskTriggerBase;     // 当前循迹任务开始时该特征的计数
+    uint32_t lapCount;
+    unsigned long lapStartMs;     // 0 = 还未经过第一条横条
+    unsigned long lastLapMs;
+    
+    // 每周期缓存的线位置, 供状态/显示任务只读使用
+    volatile int16_t controlLinePosition;
+
+    const char* volatile pendingDisplayMessage;
+    void postDisplayMessage(const char* msg) { pendingDisplayMessage = msg; }
+
+    void processPendingCommands();
+    void updateSensors();
+    void applyLineMode();
+    void onTrackFeature(TrackFeature feature);
+    void handleButton();
+    void lineFollowControl();
+    int plannedBaseSpeed(int minSpeed, int maxSpeed);
+    void driveWheels(int leftSpeed, int rightSpeed);
+    float turnProgress(float deltaLeft, float deltaRight, float startHeading);
+    void startMove(MoveKind kind, float target, float maxSpeed, float leftScale = 1.0f, float rightScale = 1.0f,
+                   float headingKp = MOTION_HEADING_KP);
+    bool updateMove();
+    float moveProgress();
+    float takeMoveDt();
+    bool startAvoidPath(float obstacleCm);
+    void followAvoidPath();
+    void finishAvoidance();
+    void handleObstacleAvoidance();
+    void handleParking();
+    void handleTestMode();
+    void handleLineCalibration();
+    void finishLineCalibration();
+};
+
+#endif
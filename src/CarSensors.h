@@ -0,0 +1,18 @@
+#ifndef CAR_SENSORS_H
+#define CAR_SENSORS_H
+
+#include <Arduino.h>
+
+// 状态机使用的车身传感器 (超声波/按键/报警)
+// 板上由Sensors实现, 仿真器提供虚拟实现
+class CarSensors {
+public:
+    virtual ~CarSensors() {}
+    virtual void update() = 0;                     // 每个控制周期调用一次
+    virtual float getUltrasonicDistance() = 0;     // cm
+    virtual bool isUltrasonicValid() = 0;          // 最近读数是否足够新
+    virtual bool isButtonPressed() = 0;
+    virtual void setAlarm(bool on) = 0;
+};
+
+#endif
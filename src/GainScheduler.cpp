@@ -0,0 +1,135 @@
+#include "GainScheduler.h"
+
+static const char* const PHASE_NAMES[GAIN_PHASE_COUNT] = {"pre", "measure", "post"};
+
+const char* gainPhaseName(GainPhase phase) {
+    return PHASE_NAMES[phase];
+}
+
+void GainSchedule::setDefaults() {
+    const float defaultSpeeds[GAIN_SPEED_POINTS] = GAIN_DEFAULT_SPEEDS;
+    for (int s = 0; s < GAIN_SPEED_POINTS; s++) {
+        speeds[s] = defaultSpeeds[s];
+    }
+    setStraightScale(PID_SMALL_ERROR_THRES, PID_KP_SMALL_SCALE, PID_KD_SMALL_SCALE);
+
+    // 测量中全程高刚性, 不做直线缩放
+    for (int s = 0; s < GAIN_SPEED_POINTS; s++) {
+        for (int e = 0; e < GAIN_ERROR_POINTS; e++) {
+            scales[GAIN_PHASE_MEASURE][s][e] = {GAIN_MEASURE_KP_SCALE, 1.0f, GAIN_MEASURE_KD_SCALE};
+        }
+    }
+}
+
+void GainSchedule::setStraightScale(int threshold, float kpScale, float kdScale) {
+    // 最后一个断点在阈值处 (阈值以上与旧版一致, 不缩放), 其余断点从0到阈值的2/3均分
+    float lo = threshold * 2.0f / 3.0f;
+    for (int e = 0; e < GAIN_ERROR_POINTS - 1; e++) {
+        errors[e] = GAIN_ERROR_POINTS > 2 ? lo * e / (GAIN_ERROR_POINTS - 2) : 0;
+    }
+    errors[GAIN_ERROR_POINTS - 1] = max((float)threshold, errors[GAIN_ERROR_POINTS - 2] + 1.0f);
+
+    for (int s = 0; s < GAIN_SPEED_POINTS; s++) {
+        for (int e = 0; e < GAIN_ERROR_POINTS; e++) {
+            bool straight = e < GAIN_ERROR_POINTS - 1;
+            GainScale scale = {straight ? kpScale : 1.0f, 1.0f, straight ? kdScale : 1.0f};
+            scales[GAIN_PHASE_PRE][s][e] = scale;
+            scales[GAIN_PHASE_POST][s][e] = scale;
+        }
+    }
+}
+
+bool GainSchedule::isValid() const {
+    for (int s = 1; s < GAIN_SPEED_POINTS; s++) {
+        if (!(speeds[s] > speeds[s - 1])) return false;
+    }
+    for (int e = 1; e < GAIN_ERROR_POINTS; e++) {
+        if (!(errors[e] > errors[e - 1])) return false;
+    }
+    for (int p = 0; p < GAIN_PHASE_COUNT; p++) {
+        for (int s = 0; s < GAIN_SPEED_POINTS; s++) {
+            for (int e = 0; e < GAIN_ERROR_POINTS; e++) {
+                const GainScale& c = scales[p][s][e];
+                if (!(c.kp >= 0 && c.ki >= 0 && c.kd >= 0)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 在升序断点中定位 x: 返回左断点下标, t 为区间内比例 (超出两端时取边界)
+static int locate(const float* points, int count, float x, float& t) {
+    if (x <= points[0]) {
+        t = 0;
+        return 0;
+    }
+    for (int i = 0; i < count - 1; i++) {
+        if (x < points[i + 1]) {
+            t = (x - points[i]) / (points[i + 1] - points[i]);
+            return i;
+        }
+    }
+    t = 1;
+    return count - 2;
+}
+
+GainScale GainSchedule::lookup(GainPhase phase, float speed, float error) const {
+    float ts, te;
+    int s = locate(speeds, GAIN_SPEED_POINTS, speed, ts);
+    int e = locate(errors, GAIN_ERROR_POINTS, error, te);
+    const GainScale& a = scales[phase][s][e];
+    const GainScale& b = scales[phase][s][e + 1];
+    const GainScale& c = scales[phase][s + 1][e];
+    const GainScale& d = scales[phase][s + 1][e + 1];
+
+    float wa = (1 - ts) * (1 - te);
+    float wb = (1 - ts) * te;
+    float wc = ts * (1 - te);
+    float wd = ts * te;
+    GainScale out;
+    out.kp = wa * a.kp + wb * b.kp + wc * c.kp + wd * d.kp;
+    out.ki = wa * a.ki + wb * b.ki + wc * c.ki + wd * d.ki;
+    out.kd = wa * a.kd + wb * b.kd + wc * c.kd + wd * d.kd;
+    return out;
+}
+
+// ==================== GainScheduler ====================
+
+GainScheduler::GainScheduler() {
+    reset();
+    scale = {1.0f, 1.0f, 1.0f};
+    kp = ki = kd = 0;
+}
+
+void GainScheduler::reset() {
+    valid = false;
+}
+
+GainChange GainScheduler::update(const GainSchedule& schedule, uint32_t revision, GainPhase phase,
+                           float speed, float error, float baseKp, float baseKi, float baseKd) {
+    // 先限制在表的范围内再量化: 超出断点后输入继续变化也不会触发重算
+    speed = constrain(fabsf(speed), schedule.speeds[0], schedule.speeds[GAIN_SPEED_POINTS - 1]);
+    error = constrain(fabsf(error), schedule.errors[0], schedule.errors[GAIN_ERROR_POINTS - 1]);
+    int newSpeedKey = (int)(speed / GAIN_SPEED_STEP + 0.5f);
+    int newErrorKey = (int)(error / GAIN_ERROR_STEP + 0.5f);
+
+    bool configSame = valid && revision == lastRevision && phase == lastPhase &&
+                      baseKp == lastBase[0] && baseKi == lastBase[1] && baseKd == lastBase[2];
+    if (configSame && newSpeedKey == speedKey && newErrorKey == errorKey) {
+        return GAIN_UNCHANGED;
+    }
+    valid = true;
+    lastRevision = revision;
+    lastPhase = phase;
+    speedKey = newSpeedKey;
+    errorKey = newErrorKey;
+    lastBase[0] = baseKp;
+    lastBase[1] = baseKi;
+    lastBase[2] = baseKd;
+
+    scale = schedule.lookup(phase, speedKey * GAIN_SPEED_STEP, errorKey * GAIN_ERROR_STEP);
+    kp = baseKp * scale.kp;
+    ki = baseKi * scale.ki;
+    kd = baseKd * scale.kd;
+    return configSame ? GAIN_CHANGED_INPUT : GAIN_CHANGED_CONFIG;
+}
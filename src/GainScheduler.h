@@ -0,0 +1,69 @@
+#ifndef GAIN_SCHEDULER_H
+#define GAIN_SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// 任务阶段: 测距前 / 物块测量中 / 测距完成后
+enum GainPhase {
+    GAIN_PHASE_PRE,
+    GAIN_PHASE_MEASURE,
+    GAIN_PHASE_POST,
+    GAIN_PHASE_COUNT
+};
+
+// PID系数 (乘在阶段基础增益上: 测距前/测量中用 kp/ki/kd, 测距后用 kpPost/kiPost/kdPost)
+struct GainScale {
+    float kp, ki, kd;
+};
+
+// 增益调度表: 每个阶段一张 速度×误差 的系数网格, 断点严格升序, 断点之外取边界值
+struct GainSchedule {
+    float speeds[GAIN_SPEED_POINTS];   // 两轮平均实测轮速 mm/s
+    float errors[GAIN_ERROR_POINTS];   // |线位置|
+    GainScale scales[GAIN_PHASE_COUNT][GAIN_SPEED_POINTS][GAIN_ERROR_POINTS];
+
+    void setDefaults();
+    // 由旧版"直线缩放"参数生成误差轴: 阈值的 2/3 以下取缩放系数, 阈值以上为1, 其间线性过渡
+    void setStraightScale(int threshold, float kpScale, float kdScale);
+    bool isValid() const;   // 断点升序且系数非负
+    GainScale lookup(GainPhase phase, float speed, float error) const;
+};
+
+const char* gainPhaseName(GainPhase phase);   // JSON键: pre/measure/post
+
+// update() 的结果: 增益为何变化 (决定调用方是否无扰切换)
+enum GainChange {
+    GAIN_UNCHANGED,
+    GAIN_CHANGED_INPUT,    // 只有量化后的轮速/误差变了: 调度本身, 随输入连续变化
+    GAIN_CHANGED_CONFIG    // 阶段、基础增益或调度表版本变了 (或首次计算): 跳变
+};
+
+// 调度器: 每个控制周期给出输入, 量化后的输入、基础增益或调度表版本变化时才重新插值
+class GainScheduler {
+public:
+    GainScheduler();
+    void reset();   // 下次 update() 必定重算
+
+    // 输入变化时调用方直接 setGains, 配置变化时 setGainsBumpless
+    GainChange update(const GainSchedule& schedule, uint32_t revision, GainPhase phase,
+                float speed, float error, float baseKp, float baseKi, float baseKd);
+
+    float getKp() { return kp; }
+    float getKi() { return ki; }
+    float getKd() { return kd; }
+    const GainScale& getScale() { return scale; }
+
+private:
+    bool valid;
+    uint32_t lastRevision;
+    GainPhase lastPhase;
+    int speedKey;
+    int errorKey;
+    float lastBase[3];
+
+    GainScale scale;
+    float kp, ki, kd;
+};
+
+#endif
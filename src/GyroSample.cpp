@@ -0,0 +1,32 @@
+#include "GyroSample.h"
+
+GyroPublisher::GyroPublisher(GyroRing* ring) {
+    this->ring = ring;
+    pending = {0, 0, 0};
+}
+
+void GyroPublisher::publish(const int16_t* gyroZ, int frames, uint32_t nowUs) {
+    int32_t sum = 0;
+    for (int i = 0; i < frames; i++) {
+        sum += gyroZ[i];
+    }
+    publishSum(sum, frames, nowUs);
+}
+
+void GyroPublisher::publishSum(int32_t sumRaw, int frames, uint32_t nowUs) {
+    if (frames <= 0) {
+        return;
+    }
+    // 控制任务长时间不取 (帧数计满) 时旧数据已无意义, 从头累计
+    if (pending.frames + frames > UINT16_MAX) {
+        pending.frames = 0;
+        pending.sumRaw = 0;
+    }
+    pending.timestampUs = nowUs;
+    pending.frames += frames;
+    pending.sumRaw += sumRaw;
+    if (ring->push(pending)) {
+        pending.frames = 0;
+        pending.sumRaw = 0;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef GYRO_SAMPLE_H
+#define GYRO_SAMPLE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "SpscRing.h"
+
+// 一次FIFO读取的陀螺仪Z轴数据 (帧间隔固定为 1/IMU_GYRO_ODR_HZ, 只需帧数与总和即可积分)
+struct GyroBatch {
+    uint32_t timestampUs;   // 读出时刻 (us)
+    uint16_t frames;        // 帧数
+    int32_t sumRaw;         // Z轴原始值之和 (未乘符号与量程)
+};
+
+// 单消费者: 控制任务中的HeadingEstimator
+typedef SpscRing<GyroBatch, IMU_RING_SIZE> GyroRing;
+
+// 生产者侧 (读取任务与仿真器共用): 队列满时把新数据并入待发批次, 下次再发, 积分不丢帧
+class GyroPublisher {
+public:
+    GyroPublisher(GyroRing* ring);
+    void publish(const int16_t* gyroZ, int frames, uint32_t nowUs);
+    void publishSum(int32_t sumRaw, int frames, uint32_t nowUs);
+
+private:
+    GyroRing* ring;
+    GyroBatch pending;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "HeadingEstimator.h"
+
+static const float GYRO_DPS_PER_LSB = IMU_GYRO_Z_SIGN * IMU_GYRO_RANGE_DPS / 32768.0f;
+static const float FRAME_S = 1.0f / IMU_GYRO_ODR_HZ;
+static const float DEG_PER_RAD = 180.0f / (float)PI;
+
+HeadingEstimator::HeadingEstimator() {
+    ring = nullptr;
+    reset();
+}
+
+void HeadingEstimator::reset() {
+    calibrated = false;
+    gyroActive = false;
+    biasDps = 0;
+    rateDps = 0;
+    lastDataMs = 0;
+    stillSinceMs = 0;
+    calibrationSum = 0;
+    calibrationFrames = 0;
+}
+
+float HeadingEstimator::update(float wheelTurn, bool still) {
+    // 取走读取任务送来的全部批次
+    int32_t sumRaw = 0;
+    uint32_t frames = 0;
+    GyroBatch batch;
+    while (ring && ring->pop(batch)) {
+        sumRaw += batch.sumRaw;
+        frames += batch.frames;
+    }
+    unsigned long now = millis();
+    if (frames > 0) {
+        lastDataMs = now;
+    }
+    float sumDps = sumRaw * GYRO_DPS_PER_LSB;   // 各帧角速度之和
+    if (frames > 0) {
+        rateDps = sumDps / frames - biasDps;
+    }
+
+    // 静止标定: 刹车余振消散后开始累计, 每满 IMU_BIAS_FRAMES 帧更新一次零偏; 起步即丢弃未满的部分
+    bool settled = false;
+    if (still) {
+        if (stillSinceMs == 0) {
+            stillSinceMs = now;
+        }
+        settled = now - stillSinceMs >= IMU_STILL_MS;
+    } else {
+        stillSinceMs = 0;
+        calibrationSum = 0;
+        calibrationFrames = 0;
+    }
+    if (settled && frames > 0) {
+        calibrationSum += sumDps;
+        calibrationFrames += frames;
+        if (calibrationFrames >= IMU_BIAS_FRAMES) {
+            biasDps = calibrationSum / calibrationFrames;
+            calibrationSum = 0;
+            calibrationFrames = 0;
+            if (!calibrated) {
+                calibrated = true;
+                Serial.printf("✓ Gyro bias calibrated: %.3f dps\n", biasDps);
+            }
+        }
+    }
+
+    gyroActive = calibrated && lastDataMs != 0 && now - lastDataMs <= IMU_TIMEOUT_MS;
+    if (!gyroActive) {
+        return wheelTurn;
+    }
+    if (settled) {
+        return 0;   // 静止时航向不变, 不积分残余噪声
+    }
+
+    float gyroTurnDeg = (sumDps - biasDps * frames) * FRAME_S;
+    // 行驶中修正零偏: 只在角速度小 (不打滑) 时与编码器比较, 时间常数远长于一次转弯
+    if (!still && fabsf(rateDps) < IMU_FUSION_MAX_DPS) {
+        biasDps += (gyroTurnDeg - wheelTurn * DEG_PER_RAD) / IMU_FUSION_TAU_S;
+    }
+    return gyroTurnDeg / DEG_PER_RAD;
+}
@@ -0,0 +1,42 @@
+#ifndef HEADING_ESTIMATOR_H
+#define HEADING_ESTIMATOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "GyroSample.h"
+
+// 航向融合: 陀螺仪积分给出转角 (原地快转时轮子打滑, 编码器差速不可信), 编码器修正陀螺仪零偏
+// - 静止 (两轮速度为0持续 IMU_STILL_MS) 时平均陀螺仪读数作为零偏, 此期间航向不变
+// - 直道/缓弯行驶时 (轮子不打滑) 用 "陀螺仪角速度 - 编码器角速度" 以 IMU_FUSION_TAU_S 慢慢修正零偏,
+//   即互补滤波: 高频取陀螺仪, 低频 (零偏) 取编码器
+// - 尚未标定过或数据中断时退回编码器差速
+// 每个控制周期调用一次, 返回值交给 Odometry::integrate() 积分位姿
+class HeadingEstimator {
+public:
+    HeadingEstimator();
+    void setSource(GyroRing* ring) { this->ring = ring; }
+    void reset();   // 清除零偏与标定状态
+
+    // wheelTurn: 本周期编码器差速给出的转角 (rad); still: 两轮实测静止
+    // 返回本周期航向增量 (rad, 逆时针为正)
+    float update(float wheelTurn, bool still);
+
+    bool isGyroActive() { return gyroActive; }   // 本周期航向取自陀螺仪
+    bool isCalibrated() { return calibrated; }
+    float getRateDps() { return rateDps; }       // 去零偏后的角速度 (最近一批)
+    float getBiasDps() { return biasDps; }
+
+private:
+    GyroRing* ring;
+    bool calibrated;
+    bool gyroActive;
+    float biasDps;
+    float rateDps;
+    unsigned long lastDataMs;
+
+    unsigned long stillSinceMs;   // 0=未静止
+    float calibrationSum;         // °/s × 帧
+    uint32_t calibrationFrames;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "LaserSample.h"
+#include <stdlib.h>
+
+LaserFilter::LaserFilter() {
+    reset();
+}
+
+void LaserFilter::reset() {
+    distance = 0;
+    lastReading = 0;
+    jumpCount = 0;
+}
+
+uint16_t LaserFilter::update(uint16_t newReading) {
+    // 检查是否为错误值 (8190/8191通常表示超时或超出量程)
+    if (newReading >= 8190) {
+        // 这是一个有效状态，表示"超出量程"或"无物体"
+        // 我们应该更新距离为最大值，以便上层逻辑知道当前没有物体
+        distance = 8190;
+        
+        // 不更新lastReading, 避免下次检测到近距离物体时误判为突变
+        return distance;
+    }
+    
+    // 简单的一阶滤波，平滑激光读数
+    if (lastReading == 0) lastReading = newReading;
+    if (abs((int)newReading - (int)lastReading) < 300 || lastReading >= 8190) {
+        // 正常变化，使用加权平均
+        distance = (lastReading * 3 + newReading * 7) / 10;  // 70%新值，30%旧值
+        lastReading = distance;
+    } else {
+        // 突变，可能是噪声，保持上次值
+        jumpCount++;
+        if (jumpCount > 2) {
+            // 连续3次突变，接受新值
+            distance = newReading;
+            lastReading = newReading;
+            jumpCount = 0;
+        }
+    }
+    return distance;
+}
@@ -0,0 +1,32 @@
+#ifndef LASER_SAMPLE_H
+#define LASER_SAMPLE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "SpscRing.h"
+
+// 激光采样 (由读取任务写入环形缓冲区)
+struct LaserSample {
+    uint32_t timestampUs;   // 数据就绪时刻 (us)
+    uint16_t raw;           // 原始读数 (mm), >=8190 表示无目标
+    uint16_t filtered;      // 一阶滤波后读数 (mm)
+};
+
+// 单消费者: 控制任务中的ObjectDetector
+typedef SpscRing<LaserSample, LASER_RING_SIZE> LaserRing;
+
+// 激光读数滤波: 一阶平滑 + 突变抑制 (读取任务与仿真器共用)
+class LaserFilter {
+public:
+    LaserFilter();
+    uint16_t update(uint16_t newReading);   // 返回滤波后距离
+    uint16_t getDistance() const { return distance; }
+    void reset();
+
+private:
+    uint16_t distance;
+    uint16_t lastReading;
+    int jumpCount;
+};
+
+#endif
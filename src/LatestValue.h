@@ -0,0 +1,50 @@
+#ifndef LATEST_VALUE_H
+#define LATEST_VALUE_H
+
+#include <atomic>
+#include <stdint.h>
+
+#define LATEST_VALUE_RETRIES 8   // 读者撞上写入时的重试次数 (写入只需几微秒, 实际很少重试)
+
+// 单写者"最新值"槽 (seqlock): 写者每次直接覆盖, 序号为奇数表示写入中, 读者前后序号一致才算读到完整的一份
+// 与 SpscRing 不同, 读者不出队, 也不需要有人读取: 无论环形缓冲区是否已满, 这里总是最新的一份
+template <typename T>
+class LatestValue {
+public:
+    LatestValue() : seq(0) {}
+
+    // ---- 写者 (唯一) ----
+    void write(const T& value) {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        data = value;
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // ---- 读者 (任意个) ----
+    // 尚未写入, 或连续重试都撞上写入时返回 false
+    bool read(T& out) const {
+        for (int attempt = 0; attempt < LATEST_VALUE_RETRIES; attempt++) {
+            uint32_t before = seq.load(std::memory_order_acquire);
+            if (before == 0) {
+                return false;
+            }
+            if (before & 1) {
+                continue;
+            }
+            out = data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    T data;
+    std::atomic<uint32_t> seq;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "LineEstimator.h"
+
+LineEstimator::LineEstimator() {
+    r = LINE_EST_DIGITAL_SIGMA * LINE_EST_DIGITAL_SIGMA;
+    reset();
+}
+
+void LineEstimator::reset() {
+    initialized = false;
+    p00 = p01 = p11 = 0;
+    lastUs = 0;
+    estimate.position = 0;
+    estimate.rate = 0;
+    estimate.confidence = 0;
+    estimate.timestampUs = 0;
+}
+
+void LineEstimator::setMeasurementNoise(float sigma) {
+    r = sigma * sigma;
+}
+
+// 首帧或长时间无数据: 以量测为位置, 速度未知 (方差取一次满量程横移/帧间隔量级)
+void LineEstimator::initialize(float position, uint32_t timestampUs) {
+    initialized = true;
+    estimate.position = position;
+    estimate.rate = 0;
+    p00 = r;
+    p01 = 0;
+    p11 = LINE_EST_RATE_SIGMA0 * LINE_EST_RATE_SIGMA0;
+    lastUs = timestampUs;
+}
+
+// 离散白噪声加速度模型: Q = σa² [dt⁴/4, dt³/2; dt³/2, dt²]
+void LineEstimator::predict(float dt) {
+    float q = LINE_EST_ACCEL_SIGMA * LINE_EST_ACCEL_SIGMA;
+    float dt2 = dt * dt;
+    estimate.position += estimate.rate * dt;
+    p00 += dt * (2 * p01 + dt * p11) + q * dt2 * dt2 / 4;
+    p01 += dt * p11 + q * dt2 * dt / 2;
+    p11 += q * dt2;
+}
+
+void LineEstimator::update(const LineSnapshot& snapshot) {
+    uint32_t now = snapshot.timestampUs;
+    bool stale = !initialized || (uint32_t)(now - lastUs) > LINE_EST_RESET_MS * 1000UL;
+
+    if (!snapshot.found) {
+        // 丢线: 只预测, 超时后不再外推
+        if (!stale) {
+            predict((now - lastUs) * 1e-6f);
+            lastUs = now;
+        }
+    } else if (stale) {
+        initialize(snapshot.position, now);
+    } else {
+        predict((now - lastUs) * 1e-6f);
+        lastUs = now;
+
+        float innovation = snapshot.position - estimate.position;
+        float s = p00 + r;
+        // 新息超出门限: 线的运动超出模型 (进弯/找回线), 按比例放大协方差以加快跟踪
+        float nis = innovation * innovation / s;
+        if (nis > LINE_EST_GATE) {
+            float inflate = nis / LINE_EST_GATE;
+            p00 *= inflate;
+            p01 *= inflate;
+            p11 *= inflate;
+            s = p00 + r;
+        }
+
+        float k0 = p00 / s;
+        float k1 = p01 / s;
+        estimate.position += k0 * innovation;
+        estimate.rate += k1 * innovation;
+        p11 -= k1 * p01;
+        p01 -= k0 * p01;
+        p00 -= k0 * p00;
+    }
+
+    estimate.timestampUs = now;
+    estimate.confidence = initialized ? constrain(1.0f - sqrtf(p00) / LINE_EST_SIGMA_MAX, 0.0f, 1.0f) : 0.0f;
+    if (stale && !snapshot.found) {
+        estimate.confidence = 0;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef LINE_ESTIMATOR_H
+#define LINE_ESTIMATOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "LineSensor.h"
+
+// 线状态估计结果 (位置单位与 LineSensor 相同: -1000..+1000)
+struct LineEstimate {
+    float position;        // 滤波后位置
+    float rate;            // 横向速度 (位置单位/秒), 正值表示线向右移
+    float confidence;      // 0..1: 估计不确定度小且量测一致时接近1, 丢线预测期间逐渐降到0
+    uint32_t timestampUs;  // 最近一次更新对应的帧时刻
+};
+
+// 匀速模型的二维卡尔曼滤波 (稳态时即 alpha-beta 滤波), 每个新帧按帧时间戳更新一次:
+// 预测步长取相邻两帧的实际间隔, 控制周期与帧周期不同步时也不会把量化台阶放大成微分尖峰
+// 新息异常大 (进弯/找回线) 时放大协方差, 让估计快速跟上并同时降低置信度
+class LineEstimator {
+public:
+    LineEstimator();
+    void reset();
+
+    // 量测噪声 (位置单位, 1σ): 数字模式量化台阶大, 模拟量模式小
+    void setMeasurementNoise(float sigma);
+
+    // 每个新帧调用一次 (snapshot.seq 变化时); 丢线帧只做预测
+    void update(const LineSnapshot& snapshot);
+
+    const LineEstimate& getEstimate() { return estimate; }
+    float getPosition() { return estimate.position; }
+    float getRate() { return estimate.rate; }
+    float getConfidence() { return estimate.confidence; }
+
+private:
+    LineEstimate estimate;
+    bool initialized;
+    float r;                   // 量测方差
+    float p00, p01, p11;       // 协方差 [位置, 速度]
+    uint32_t lastUs;
+
+    void initialize(float position, uint32_t timestampUs);
+    void predict(float dt);
+};
+
+#endif
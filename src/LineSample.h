@@ -0,0 +1,20 @@
+#ifndef LINE_SAMPLE_H
+#define LINE_SAMPLE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "SpscRing.h"
+
+// 循迹采样 (一帧数字状态或模拟量)
+struct LineSample {
+    uint32_t timestampUs;                 // 帧接收完成时刻 (us)
+    uint32_t seq;                         // 帧序号, 用于统计丢帧
+    uint16_t values[LINE_SENSOR_COUNT];   // 模拟量 (仅 analog 为 true 时有效)
+    uint8_t states;                       // 8位数字状态 (模拟帧由阈值派生)
+    bool analog;
+};
+
+// 生产者: 串口接收回调 (或无回调时的 LineSensor::update), 消费者: 控制任务
+typedef SpscRing<LineSample, LINE_RING_SIZE> LineRing;
+
+#endif
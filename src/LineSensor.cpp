@@ -1,12 +1,12 @@
 #include "LineSensor.h"
 
-LineSensor::LineSensor() {
-    uart = new HardwareSerial(1);
+LineSensor::LineSensor(HalUart* uart) {
+    this->uart = uart;
     states = 0;
     dataReady = false;
     memset(analogValues, 0, sizeof(analogValues));
     lastValidPosition = 0;
-    lostLineCount = 0;
+    memset(&snapshot, 0, sizeof(snapshot));
     // 默认权重 - 优化为非线性权重
     // 中间平缓(稳直线)，两边陡峭(快转弯)
     weights[0] = -1000;
@@ -17,14 +17,49 @@ LineSensor::LineSensor() {
     weights[5] = 400;
     weights[6] = 700;
     weights[7] = 1000;
+    rebuildPositionLut();
     
     lastRequestTime = 0;
     waitingResponse = false;
+    
+    mode = LINE_MODE_DIGITAL;
+    positionMethod = LINE_POS_CENTROID;
+    analogPosition = 0;
+    analogLineFound = false;
+    analogFailCount = 0;
+    frameErrors = 0;
+    
+    calibrating = false;
+    calibrated = false;
+    modeBeforeCalibration = LINE_MODE_DIGITAL;
+    calSamples = 0;
+    memset(calMin, 0, sizeof(calMin));
+    memset(calMax, 0, sizeof(calMax));
+    memset(calScale, 0, sizeof(calScale));
+    memset(sweepMin, 0, sizeof(sweepMin));
+    memset(sweepMax, 0, sizeof(sweepMax));
+    
+    streaming = false;
+    streamCommand = 0;
+    streamSettling = false;
+    streamSwitchUs = 0;
+    parserCommand = 0;
+    frameLen = 0;
+    frameSeq = 0;
+    streamErrors = 0;
+    resyncBytes = 0;
+    hasReceiveCallback = false;
+    receiveCallbackChecked = false;
+    sampleTimeUs = 0;
+    lastSampleMs = 0;
+    sampleRate = 0;
+    rateCount = 0;
+    rateWindowStart = 0;
 }
 
 void LineSensor::begin() {
     // 初始化串口
-    uart->begin(LINE_UART_BAUD, SERIAL_8N1, PIN_LINE_RX, PIN_LINE_TX);
+    uart->begin(LINE_UART_BAUD);
     delay(100);
     
     // 清空缓冲区
@@ -33,10 +68,15 @@ void LineSensor::begin() {
     }
     
     // 设置为手动模式 (模式0：手动请求，主动控制)
-    uart->write(0);
+    uart->write(LINE_CMD_MANUAL);
     delay(50);  // 等待模块响应
     
-    Serial.println("✓ Line sensor initialized (Manual mode)");
+    // 丢弃模式切换的应答
+    while(uart->available()) {
+        uart->read();
+    }
+    
+    Serial.printf("✓ Line sensor initialized (Manual mode, %s)\n", mode == LINE_MODE_ANALOG ? "analog" : "digital");
 }
 
 uint8_t LineSensor::calculateCheckCode(uint8_t* buf) {
@@ -50,6 +90,11 @@ uint8_t LineSensor::calculateCheckCode(uint8_t* buf) {
 }
 
 void LineSensor::update() {
+    if (streaming) {
+        updateStream();
+        return;
+    }
+    
     // 非阻塞通信状态机
     if (!waitingResponse) {
         // 限制请求频率 (每4ms一次 = 250Hz)
@@ -58,18 +103,34 @@ void LineSensor::update() {
                 // 发送前清空缓冲区，防止读取到旧数据
                 while(uart->available()) uart->read();
                 
-                uart->write(1); // 发送读取状态指令
+                uart->write(mode == LINE_MODE_ANALOG ? LINE_CMD_ANALOG : LINE_CMD_DIGITAL);
                 waitingResponse = true;
                 lastRequestTime = millis();
             }
         }
     } else {
-        // 等待响应
-        if (uart->available()) {
-            uint8_t temp;
-            uart->readBytes(&temp, 1);
-            states = temp;
-            dataReady = true;
+        // 等待响应 (模拟量模式等整帧到齐再解析)
+        int needed = (mode == LINE_MODE_ANALOG) ? LINE_ANALOG_FRAME_SIZE : 1;
+        if (uart->available() >= needed) {
+            LineSample sample;
+            if (mode == LINE_MODE_ANALOG) {
+                uint8_t frame[LINE_ANALOG_FRAME_SIZE];
+                uart->readBytes(frame, LINE_ANALOG_FRAME_SIZE);
+                if (decodeAnalogFrame(frame, sample)) {
+                    sample.timestampUs = micros();
+                    sample.seq = frameSeq++;
+                    applySample(sample);
+                    analogFailCount = 0;
+                } else {
+                    analogFrameFailed();
+                }
+            } else {
+                uart->readBytes(&sample.states, 1);
+                sample.timestampUs = micros();
+                sample.seq = frameSeq++;
+                sample.analog = false;
+                applySample(sample);
+            }
             waitingResponse = false;
             
 #if DEBUG_LINE_SENSOR
@@ -82,6 +143,9 @@ void LineSensor::update() {
             if (millis() - lastRequestTime > 8) {
                 waitingResponse = false;
                 // dataReady = false; // 可选：超时是否认为数据无效？暂时保持旧值
+                if (mode == LINE_MODE_ANALOG) {
+                    analogFrameFailed();
+                }
 #if DEBUG_LINE_SENSOR
                 // Serial.println("⚠ Line sensor timeout!"); // 减少串口刷屏
 #endif
@@ -90,66 +154,365 @@ void LineSensor::update() {
     }
 }
 
-uint8_t LineSensor::getState(uint8_t index) {
-    if (index >= LINE_SENSOR_COUNT) return 0;
-    return (states >> index) & 0x01;
+// 校验并解码模拟量帧, 同时由阈值派生8位数字状态 (不修改传感器状态, 两种模式共用)
+bool LineSensor::decodeAnalogFrame(uint8_t* buf, LineSample& sample) {
+    if (buf[0] != LINE_FRAME_HEAD || buf[1] != LINE_FRAME_HEAD || buf[3] != LINE_ANALOG_DATA_LEN) {
+        return false;
+    }
+    if (buf[LINE_ANALOG_FRAME_SIZE - 1] != calculateCheckCode(buf)) {
+        return false;
+    }
+    
+    uint8_t digital = 0;
+    for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
+        uint16_t value = ((uint16_t)buf[4 + i * 2] << 8) | buf[5 + i * 2];
+        sample.values[i] = min(value, (uint16_t)LINE_ANALOG_MAX);
+        if (sample.values[i] > LINE_ANALOG_THRESHOLD) {
+            digital |= 1 << i;
+        }
+    }
+    sample.states = digital;
+    sample.analog = true;
+    return true;
 }
 
-uint8_t LineSensor::getRawStates() {
-    return states;
+// 采用一帧数据 (控制任务中调用): 计算位置并更新快照, 丢线计数按帧累加
+void LineSensor::applySample(LineSample& sample) {
+    if (sample.analog && (calibrating || calibrated)) {
+        normalize(sample);
+    }
+    states = sample.states;
+    int16_t position;
+    bool found;
+    if (sample.analog) {
+        memcpy(analogValues, sample.values, sizeof(analogValues));
+        analogPosition = computeAnalogPosition(analogLineFound);
+        position = analogPosition;
+        found = analogLineFound;
+    } else {
+        position = positionLut[states];
+        found = states != 0;
+    }
+    
+    if (found) {
+        // 找到线,重置计数并记录有效位置
+        snapshot.lostFrames = 0;
+        lastValidPosition = position;
+    } else {
+        // 完全丢线,增加计数; 返回上次位置的1.2倍(加速搜索)
+        if (snapshot.lostFrames < 255) snapshot.lostFrames++;
+        position = constrain(lastValidPosition * 1.2, -1000, 1000);
+    }
+    snapshot.position = position;
+    snapshot.states = states;
+    snapshot.activeCount = __builtin_popcount(states);
+    snapshot.found = found;
+    snapshot.lost = snapshot.lostFrames >= LINE_LOST_FRAMES;
+    snapshot.seq = sample.seq;
+    snapshot.timestampUs = sample.timestampUs;
+    
+    sampleTimeUs = sample.timestampUs;
+    dataReady = true;
+    
+    rateCount++;
+    if (millis() - rateWindowStart >= 1000) {
+        sampleRate = rateCount;
+        rateCount = 0;
+        rateWindowStart = millis();
+    }
 }
 
-uint16_t LineSensor::getAnalog(uint8_t index) {
-    if (index >= LINE_SENSOR_COUNT) return 0;
-    return analogValues[index];
+// 校准期间累计每路极值; 已校准时按 (v-min)/(max-min) 拉伸并重新派生数字状态
+void LineSensor::normalize(LineSample& sample) {
+    if (calibrating) {
+        for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
+            if (calSamples == 0 || sample.values[i] < sweepMin[i]) sweepMin[i] = sample.values[i];
+            if (calSamples == 0 || sample.values[i] > sweepMax[i]) sweepMax[i] = sample.values[i];
+        }
+        calSamples++;
+        return;
+    }
+    
+    uint8_t digital = 0;
+    for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
+        uint32_t v = sample.values[i] > calMin[i] ? sample.values[i] - calMin[i] : 0;
+        sample.values[i] = min((v * calScale[i]) >> 12, (uint32_t)LINE_ANALOG_MAX);
+        if (sample.values[i] > LINE_ANALOG_THRESHOLD) {
+            digital |= 1 << i;
+        }
+    }
+    sample.states = digital;
 }
 
-int16_t LineSensor::getLinePosition() {
-    // 电赛标准算法: 加权平均法
-    // 传感器排列: [0][1][2][3][4][5][6][7]
-    // 使用可配置的权重
+void LineSensor::startCalibration() {
+    if (calibrating) return;
+    modeBeforeCalibration = mode;
+    calSamples = 0;
+    calibrating = true;
+    setMode(LINE_MODE_ANALOG);
+    Serial.println("Line sensor calibration started");
+}
+
+bool LineSensor::finishCalibration(uint16_t outMin[LINE_SENSOR_COUNT], uint16_t outMax[LINE_SENSOR_COUNT]) {
+    if (!calibrating) return false;
+    calibrating = false;
+    setMode(modeBeforeCalibration);
     
-    int32_t weightedSum = 0;
-    int32_t activeSum = 0;
+    bool valid = calSamples > 0;
+    for (int i = 0; i < LINE_SENSOR_COUNT && valid; i++) {
+        if (sweepMax[i] < sweepMin[i] + LINE_CAL_MIN_SPAN) valid = false;
+    }
+    Serial.printf("Line sensor calibration %s (%u frames)\n", valid ? "done" : "FAILED", calSamples);
+    for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
+        Serial.printf("  [%d]: %u..%u\n", i, sweepMin[i], sweepMax[i]);
+    }
     
+    // 失败时保留原来的校准值
+    if (!valid) return false;
+    memcpy(outMin, sweepMin, sizeof(sweepMin));
+    memcpy(outMax, sweepMax, sizeof(sweepMax));
+    setCalibration(sweepMin, sweepMax);
+    return true;
+}
+
+void LineSensor::cancelCalibration() {
+    if (!calibrating) return;
+    calibrating = false;
+    setMode(modeBeforeCalibration);
+    Serial.println("⚠ Line sensor calibration aborted");
+}
+
+// max <= min 的通道视为未校准, 此时整体关闭归一化
+void LineSensor::setCalibration(const uint16_t newMin[LINE_SENSOR_COUNT], const uint16_t newMax[LINE_SENSOR_COUNT]) {
+    calibrated = true;
     for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
-        if (getState(i) == 1) {  // 检测到黑线
-            weightedSum += weights[i];
-            activeSum += 1000;  // 权重基数
+        calMin[i] = newMin[i];
+        calMax[i] = newMax[i];
+        if (newMax[i] <= newMin[i]) {
+            calibrated = false;
+            continue;
         }
+        calScale[i] = ((uint32_t)LINE_ANALOG_MAX << 12) / (newMax[i] - newMin[i]);
+    }
+}
+
+// 连续多帧失败 (模块不支持模拟量或接线问题) 时退回数字模式, 保证仍能循迹
+void LineSensor::analogFrameFailed() {
+    frameErrors++;
+    if (++analogFailCount >= LINE_ANALOG_FAIL_LIMIT) {
+        Serial.println("⚠ Line sensor: no valid analog frames, falling back to digital mode");
+        setMode(LINE_MODE_DIGITAL);
     }
+}
+
+void LineSensor::setMode(LineSensorMode mode) {
+    if (mode == this->mode) return;
+    this->mode = mode;
+    analogFailCount = 0;
+    waitingResponse = false;
     
-    if (activeSum == 0) {
-        // 完全丢线,增加计数
-        lostLineCount++;
-        // 返回上次位置的1.2倍(加速搜索)
-        return constrain(lastValidPosition * 1.2, -1000, 1000);
+    // 连续输出中切换: 让模块改发另一种帧
+    // 串口里还有旧格式的字节 (模拟量帧的 0xFF 帧头按数字帧解析就是全黑, 会被当成横条), 
+    // 清空已收到的采样, 并在 LINE_STREAM_SETTLE_MS 内丢弃收到的字节
+    if (streaming) {
+        streamSwitchUs = micros();
+        streamSettling = true;
+        ring.clear();
+        lastSampleMs = millis();
+        streamCommand = (mode == LINE_MODE_ANALOG) ? LINE_CMD_STREAM_ANALOG : LINE_CMD_STREAM_DIGITAL;
+        uart->write(streamCommand);
     }
+}
+
+// ==================== 连续输出模式 ====================
+
+void LineSensor::setStreaming(bool enable) {
+    if (enable == streaming) return;
     
-    // 找到线,重置计数
-    lostLineCount = 0;
+    if (enable) {
+        // 串口支持接收回调时, 解析在串口事件任务中完成, 控制任务只取结果
+        if (!receiveCallbackChecked) {
+            hasReceiveCallback = uart->setReceiveCallback(onReceive, this);
+            receiveCallbackChecked = true;
+        }
+        ring.clear();
+        waitingResponse = false;
+        lastSampleMs = millis();
+        streamCommand = (mode == LINE_MODE_ANALOG) ? LINE_CMD_STREAM_ANALOG : LINE_CMD_STREAM_DIGITAL;
+        streaming = true;   // 先置位, 保证回调能处理指令发出后的第一帧
+        uart->write(streamCommand);
+        Serial.printf("✓ Line sensor: streaming (%s)\n", hasReceiveCallback ? "rx callback" : "polled");
+    } else {
+        streaming = false;
+        uart->write(LINE_CMD_MANUAL);
+    }
+}
+
+void LineSensor::onReceive(void* arg) {
+    LineSensor* sensor = (LineSensor*)arg;
+    if (sensor->streaming) {
+        sensor->pumpStream();
+    }
+}
+
+// 切换帧类型后的稳定期内 (只有控制任务清除 streamSettling)
+bool LineSensor::inStreamSettle(uint32_t timestampUs) {
+    return streamSettling && (int32_t)(timestampUs - streamSwitchUs) < LINE_STREAM_SETTLE_MS * 1000;
+}
+
+// 生产者: 读出串口中所有字节, 完整帧推入环形缓冲区
+void LineSensor::pumpStream() {
+    uint8_t buf[LINE_ANALOG_FRAME_SIZE];
+    LineSample sample;
+    int count;
+    while ((count = uart->available()) > 0) {
+        count = uart->readBytes(buf, min(count, (int)sizeof(buf)));
+        if (count <= 0) break;
+        uint32_t now = micros();
+        if (inStreamSettle(now)) {
+            frameLen = 0;   // 丢弃旧格式字节, 稳定期后从帧头重新对齐
+            continue;
+        }
+        int i = 0;
+        while (i < count) {
+            // 快速路径: 已对齐且整帧在缓冲区中, 原地解码
+            bool decoded;
+            if (frameLen == 0 && parserCommand == LINE_CMD_STREAM_ANALOG && streamCommand == parserCommand &&
+                count - i >= LINE_ANALOG_FRAME_SIZE && decodeAnalogFrame(buf + i, sample)) {
+                decoded = true;
+                i += LINE_ANALOG_FRAME_SIZE;
+            } else {
+                decoded = feedStreamByte(buf[i++], sample);
+            }
+            if (decoded) {
+                sample.timestampUs = now;
+                sample.seq = frameSeq++;
+                ring.push(sample);
+            }
+        }
+    }
+}
+
+// 逐字节解析; 帧头/长度/校验任一不符就丢弃首字节, 从下一个 0xFF 重新对齐
+bool LineSensor::feedStreamByte(uint8_t byte, LineSample& sample) {
+    uint8_t command = streamCommand;
+    if (command != parserCommand) {
+        parserCommand = command;
+        frameLen = 0;
+    }
     
-    // 计算位置
-    int16_t position = (int16_t)(weightedSum / (activeSum / 1000));
-    position = constrain(position, -1000, 1000);
+    if (command == LINE_CMD_STREAM_DIGITAL) {
+        sample.states = byte;
+        sample.analog = false;
+        return true;
+    }
     
-    // 记录有效位置
-    lastValidPosition = position;
+    frameBuf[frameLen++] = byte;
+    while (frameLen > 0) {
+        bool headerOk = frameBuf[0] == LINE_FRAME_HEAD &&
+                        (frameLen < 2 || frameBuf[1] == LINE_FRAME_HEAD) &&
+                        (frameLen < 4 || frameBuf[3] == LINE_ANALOG_DATA_LEN);
+        if (headerOk && frameLen < LINE_ANALOG_FRAME_SIZE) {
+            return false;   // 等待更多字节
+        }
+        if (headerOk) {
+            if (decodeAnalogFrame(frameBuf, sample)) {
+                frameLen = 0;
+                return true;
+            }
+            streamErrors++;
+        }
+        frameLen--;
+        memmove(frameBuf, frameBuf + 1, frameLen);
+        resyncBytes++;
+    }
+    return false;
+}
+
+// 消费者: 取出本周期收到的所有帧, 采用最新一帧
+void LineSensor::updateStream() {
+    if (!hasReceiveCallback) {
+        pumpStream();
+    }
     
-    return position;
+    LineSample sample;
+    LineSample latest;
+    bool received = false;
+    while (ring.pop(sample)) {
+        // 切换前读出、切换后才入队的旧格式帧
+        if (inStreamSettle(sample.timestampUs)) continue;
+        latest = sample;
+        received = true;
+    }
+    if (streamSettling && !inStreamSettle(micros())) {
+        streamSettling = false;
+    }
+    
+    if (received) {
+        applySample(latest);
+        lastSampleMs = millis();
+    } else if (millis() - lastSampleMs > LINE_STREAM_TIMEOUT_MS) {
+        // 模块不支持连续输出或已复位: 回到请求/应答模式继续循迹
+        Serial.println("⚠ Line sensor: stream timeout, back to request mode");
+        setStreaming(false);
+    }
 }
 
-uint8_t LineSensor::getActiveCount() {
-    uint8_t count = 0;
+// 通道中心线性排布在 -1000..+1000, 返回值与数字模式同一坐标
+int16_t LineSensor::computeAnalogPosition(bool& found) {
+    const float pitch = 2000.0f / (LINE_SENSOR_COUNT - 1);
+    uint16_t low = LINE_ANALOG_MAX;
+    uint16_t high = 0;
+    int peak = 0;
     for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
-        if (getState(i) == 1) count++;
+        if (analogValues[i] < low) low = analogValues[i];
+        if (analogValues[i] > high) {
+            high = analogValues[i];
+            peak = i;
+        }
+    }
+    
+    found = high > LINE_ANALOG_THRESHOLD;
+    if (!found) return 0;
+    
+    float index;
+    if (positionMethod == LINE_POS_QUADRATIC && peak > 0 && peak < LINE_SENSOR_COUNT - 1) {
+        // 过峰值及左右两点的抛物线顶点
+        float a = analogValues[peak - 1];
+        float b = analogValues[peak];
+        float c = analogValues[peak + 1];
+        float denom = a - 2 * b + c;
+        float offset = denom < 0 ? 0.5f * (a - c) / denom : 0;
+        index = peak + constrain(offset, -0.5f, 0.5f);
+    } else {
+        // 去掉本帧最低值 (地面底色), 只统计高于峰值对比度1/4的通道, 抑制远处通道的底噪
+        uint16_t floorLevel = low + (high - low) / 4;
+        uint32_t sum = 0;
+        uint32_t weighted = 0;
+        for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
+            if (analogValues[i] <= floorLevel) continue;
+            uint32_t v = analogValues[i] - low;
+            sum += v;
+            weighted += v * i;
+        }
+        index = sum ? (float)weighted / sum : peak;
     }
-    return count;
+    
+    return (int16_t)constrain(index * pitch - 1000.0f, -1000.0f, 1000.0f);
 }
 
-bool LineSensor::isLostLine() {
-    // 连续3次以上丢线才算真正丢线
-    return (lostLineCount >= 3);
+uint8_t LineSensor::getState(uint8_t index) {
+    if (index >= LINE_SENSOR_COUNT) return 0;
+    return (states >> index) & 0x01;
+}
+
+uint8_t LineSensor::getRawStates() {
+    return states;
+}
+
+uint16_t LineSensor::getAnalog(uint8_t index) {
+    if (index >= LINE_SENSOR_COUNT) return 0;
+    return analogValues[index];
 }
 
 bool LineSensor::isAllWhite() {
@@ -164,6 +527,7 @@ void LineSensor::setWeights(int16_t newWeights[8]) {
     for (int i = 0; i < 8; i++) {
         weights[i] = newWeights[i];
     }
+    rebuildPositionLut();
     Serial.println("Sensor weights updated:");
     for (int i = 0; i < 8; i++) {
         Serial.printf("  [%d]: %d\n", i, weights[i]);
@@ -175,3 +539,20 @@ void LineSensor::getWeights(int16_t outWeights[8]) {
         outWeights[i] = weights[i];
     }
 }
+
+// 电赛标准算法: 加权平均法, 按8位状态的全部256种组合预先计算
+// 传感器排列: [0][1][2][3][4][5][6][7]
+void LineSensor::rebuildPositionLut() {
+    positionLut[0] = 0;
+    for (int pattern = 1; pattern < 256; pattern++) {
+        int32_t weightedSum = 0;
+        int32_t active = 0;
+        for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
+            if (pattern & (1 << i)) {  // 检测到黑线
+                weightedSum += weights[i];
+                active++;
+            }
+        }
+        positionLut[pattern] = constrain(weightedSum / active, -1000, 1000);
+    }
+}
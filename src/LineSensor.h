@@ -3,10 +3,36 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "hal/Hal.h"
+#include "LineSample.h"
+
+// 采集模式: 数字 (1字节/帧, 位置由权重表组合) 或 模拟 (8路12位值, 位置连续)
+enum LineSensorMode {
+    LINE_MODE_DIGITAL,
+    LINE_MODE_ANALOG
+};
+
+// 模拟量位置算法
+enum LinePositionMethod {
+    LINE_POS_CENTROID,   // 去底加权质心: 线宽覆盖2~3路时最稳
+    LINE_POS_QUADRATIC   // 峰值及相邻两路二次拟合: 对底噪不敏感, 线窄时分辨率更高
+};
+
+// 每收到一帧计算一次的结果, 读取方 (控制/状态/显示) 只读不改
+struct LineSnapshot {
+    int16_t position;      // -1000..+1000; 丢线时为上次有效位置的1.2倍 (加速搜索)
+    uint8_t states;        // 8位数字状态
+    uint8_t activeCount;   // 压线通道数
+    bool found;            // 本帧检测到线
+    bool lost;             // 连续 LINE_LOST_FRAMES 帧无线
+    uint8_t lostFrames;    // 连续无线帧数
+    uint32_t seq;          // 帧序号
+    uint32_t timestampUs;  // 帧接收时刻
+};
 
 class LineSensor {
 public:
-    LineSensor();
+    LineSensor(HalUart* uart);
     void begin();
     void update();
     
@@ -17,39 +43,117 @@ public:
     // 获取模拟值 (0-4095, 越大越黑)
     uint16_t getAnalog(uint8_t index);
     
-    // 计算线位置 (-1000 到 +1000, 0=中心, 电赛标准)
-    int16_t getLinePosition();
+    // 最新一帧的快照 (位置/压线数/丢线/序号/时间戳), 只在收到新帧时更新
+    const LineSnapshot& getSnapshot() { return snapshot; }
+    
+    // 线位置 (-1000 到 +1000, 0=中心, 电赛标准)
+    int16_t getLinePosition() { return snapshot.position; }
     
     // 获取检测到的传感器数量
-    uint8_t getActiveCount();
+    uint8_t getActiveCount() { return snapshot.activeCount; }
     
     // 检测特殊情况
     bool isAllWhite();  // 全白(丢线)
     bool isAllBlack();  // 全黑(可能是起点/终点标记)
-    bool isLostLine();  // 判断是否丢线(需要搜索)
+    bool isLostLine() { return snapshot.lost; }  // 判断是否丢线(需要搜索)
     
     bool isDataReady() { return dataReady; }
     
     // 获取上次有效位置
     int16_t getLastPosition() { return lastValidPosition; }
     
-    // 设置/获取传感器权重
+    // 设置/获取传感器权重 (仅数字模式使用, 设置时重建位置查找表)
     void setWeights(int16_t newWeights[8]);
     void getWeights(int16_t outWeights[8]);
+    
+    // 采集模式与模拟量位置算法
+    void setMode(LineSensorMode mode);
+    LineSensorMode getMode() { return mode; }
+    void setPositionMethod(LinePositionMethod method) { positionMethod = method; }
+    uint32_t getFrameErrors() { return frameErrors + streamErrors; }  // 校验失败/超时的帧
+    
+    // 连续输出模式: 模块主动发帧, 串口接收回调中解析 (无回调时在update()中解析)
+    void setStreaming(bool enable);
+    bool isStreaming() { return streaming; }
+    uint32_t getSampleTimeUs() { return sampleTimeUs; }   // 当前数据的帧接收时刻
+    uint32_t getSampleRate() { return sampleRate; }       // 上一秒收到的帧数
+    uint32_t getResyncBytes() { return resyncBytes; }     // 重新对齐帧头丢弃的字节
+    
+    // 逐路校准: 扫线期间记录每路模拟量最小/最大值, 之后每帧归一化到 0..LINE_ANALOG_MAX
+    // 校准期间临时切到模拟量模式; 结束时恢复原模式, 每路对比度都够才返回true
+    void startCalibration();
+    bool finishCalibration(uint16_t outMin[LINE_SENSOR_COUNT], uint16_t outMax[LINE_SENSOR_COUNT]);
+    void cancelCalibration();   // 放弃本次扫线 (恢复原模式, 原校准不变)
+    bool isCalibrating() { return calibrating; }
+    void setCalibration(const uint16_t calMin[LINE_SENSOR_COUNT], const uint16_t calMax[LINE_SENSOR_COUNT]);
+    bool isCalibrated() { return calibrated; }
 
 private:
-    HardwareSerial* uart;
+    friend class LineSensorBench;   // tools/bench 跳过请求限频, 每次都测完整一问一答
+
+    HalUart* uart;
     uint8_t states;              // 8位状态数据
     uint16_t analogValues[LINE_SENSOR_COUNT];
     bool dataReady;
     
     int16_t lastValidPosition;   // 上次有效位置
-    uint8_t lostLineCount;       // 丢线计数
     int16_t weights[8];          // 传感器权重(可调)
+    int16_t positionLut[256];    // 数字状态 -> 位置 (按权重预先计算)
+    LineSnapshot snapshot;
+    
+    // 模拟量模式
+    LineSensorMode mode;
+    LinePositionMethod positionMethod;
+    int16_t analogPosition;      // 最新一帧计算出的位置
+    bool analogLineFound;
+    uint8_t analogFailCount;     // 连续失败次数
+    uint32_t frameErrors;
+    
+    // 校准 (归一化系数为12位定点)
+    bool calibrating;
+    bool calibrated;
+    LineSensorMode modeBeforeCalibration;
+    uint16_t calMin[LINE_SENSOR_COUNT];
+    uint16_t calMax[LINE_SENSOR_COUNT];
+    uint32_t calScale[LINE_SENSOR_COUNT];
+    uint16_t sweepMin[LINE_SENSOR_COUNT];   // 本次扫线的极值 (成功后才替换 calMin/calMax)
+    uint16_t sweepMax[LINE_SENSOR_COUNT];
+    uint32_t calSamples;
+    void normalize(LineSample& sample);
     
     uint8_t calculateCheckCode(uint8_t* buf);
-    void requestStates();
-    void requestAnalog();
+    bool decodeAnalogFrame(uint8_t* buf, LineSample& sample);
+    void applySample(LineSample& sample);
+    void rebuildPositionLut();
+    void analogFrameFailed();
+    int16_t computeAnalogPosition(bool& found);
+    
+    // 连续输出模式 (解析状态只由生产者访问)
+    volatile bool streaming;
+    volatile uint8_t streamCommand;   // 当前连续输出指令, 生产者据此选择解析方式
+    volatile bool streamSettling;     // 刚切换帧类型: 生产者丢弃 streamSwitchUs 起 LINE_STREAM_SETTLE_MS 内的字节
+    volatile uint32_t streamSwitchUs;
+    uint8_t parserCommand;
+    uint8_t frameBuf[LINE_ANALOG_FRAME_SIZE];
+    uint8_t frameLen;
+    uint32_t frameSeq;
+    volatile uint32_t streamErrors;
+    volatile uint32_t resyncBytes;
+    bool hasReceiveCallback;
+    bool receiveCallbackChecked;
+    LineRing ring;
+    
+    uint32_t sampleTimeUs;
+    unsigned long lastSampleMs;
+    uint32_t sampleRate;
+    uint32_t rateCount;
+    unsigned long rateWindowStart;
+    
+    static void onReceive(void* arg);
+    void pumpStream();
+    bool feedStreamByte(uint8_t byte, LineSample& sample);
+    void updateStream();
+    bool inStreamSettle(uint32_t timestampUs);
     
     // 非阻塞通信变量
     unsigned long lastRequestTime;
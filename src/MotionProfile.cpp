@@ -0,0 +1,107 @@
+#include "MotionProfile.h"
+
+MotionProfile::MotionProfile() {
+    maxVel = 500;
+    maxAcc = MOTION_ACCEL_DEFAULT;
+    maxJerk = MOTION_JERK_DEFAULT;
+    target = 0;
+    state = {0, 0, 0};
+    done = true;
+}
+
+void MotionProfile::setLimits(float maxVel, float maxAcc, float maxJerk) {
+    this->maxVel = maxVel;
+    this->maxAcc = max(maxAcc, 1.0f);
+    this->maxJerk = max(maxJerk, 1.0f);
+}
+
+void MotionProfile::start(float target, float vel) {
+    this->target = target;
+    state = {0, vel, 0};
+    done = false;
+}
+
+void MotionProfile::retarget(float target) {
+    this->target = target;
+    done = false;
+}
+
+void MotionProfile::stop() {
+    float s = state.vel >= 0 ? 1.0f : -1.0f;
+    retarget(state.pos + s * brakingDistance(state.vel * s, state.acc * s));
+}
+
+// 刹车三段: 加速度以 -J 降到 -Ap, 保持 -Ap, 再以 +J 回到0, 速度恰好到0.
+// 由 v + (a² - Ap²)/2J - Ap²/2J - Ap·t2 = 0 解出峰值减速度 Ap (不超过 A) 与保持时长 t2
+float MotionProfile::brakingDistance(float v, float a) const {
+    float J = maxJerk;
+    float A = maxAcc;
+    float energy = v + a * a / (2 * J);
+    if (energy <= 0) {
+        return 0;
+    }
+    float peak = sqrtf(J * energy);
+    float hold = 0;
+    if (peak > A) {
+        peak = A;
+        hold = (energy - A * A / J) / A;
+    }
+
+    float t1 = (a + peak) / J;
+    if (t1 < 0) {
+        // 当前减速度已大于所需: 加速度直接回到0, 提前停下
+        float t3 = -a / J;
+        return v * t3 + a * t3 * t3 / 2 + J * t3 * t3 * t3 / 6;
+    }
+    float p1 = v * t1 + a * t1 * t1 / 2 - J * t1 * t1 * t1 / 6;
+    float v1 = v + a * t1 - J * t1 * t1 / 2;
+    float p2 = v1 * hold - peak * hold * hold / 2;
+    float v2 = v1 - peak * hold;
+    float t3 = peak / J;
+    float p3 = v2 * t3 - peak * t3 * t3 / 2 + J * t3 * t3 * t3 / 6;
+    return p1 + p2 + p3;
+}
+
+const MotionState& MotionProfile::step(float dt) {
+    if (done || dt <= 0) {
+        return state;
+    }
+
+    // 方向归一化: 朝终点为正
+    float s = target >= state.pos ? 1.0f : -1.0f;
+    float dist = (target - state.pos) * s;
+    float v = state.vel * s;
+    float a = state.acc * s;
+
+    // 到位: 剩余距离与速度都在一个周期的量级内
+    if (dist < MOTION_POS_EPS && fabsf(v) < maxAcc * dt) {
+        state = {target, 0, 0};
+        done = true;
+        return state;
+    }
+
+    // 期望: 速度向限速逼近 (考虑加速度回零期间速度还会继续变化)
+    float vAhead = v + a * fabsf(a) / (2 * maxJerk);
+    float aWanted = vAhead < maxVel ? maxAcc : (vAhead > maxVel + maxAcc * dt ? -maxAcc : 0);
+    float jWanted = constrain((aWanted - a) / dt, -maxJerk, maxJerk);
+
+    // 依次尝试 期望 / 保持 / 全力减速, 取第一档走完本周期后仍刹得住的
+    const float candidates[3] = {jWanted, min(jWanted, 0.0f), -maxJerk};
+    float jerk = -maxJerk;
+    for (int i = 0; i < 3; i++) {
+        float aNext = constrain(a + candidates[i] * dt, -maxAcc, maxAcc);
+        float vNext = v + (a + aNext) / 2 * dt;
+        float travel = (v + vNext) / 2 * dt;
+        if (vNext <= 0 || dist - travel >= brakingDistance(vNext, aNext)) {
+            jerk = candidates[i];
+            break;
+        }
+    }
+
+    float aNext = constrain(a + jerk * dt, -maxAcc, maxAcc);
+    float vNext = v + (a + aNext) / 2 * dt;
+    state.pos += (v + vNext) / 2 * dt * s;
+    state.vel = vNext * s;
+    state.acc = aNext * s;
+    return state;
+}
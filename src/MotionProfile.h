@@ -0,0 +1,42 @@
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// 速度曲线上的一点 (单位由调用方决定: 直行为mm, 原地转为单轮弧长mm)
+struct MotionState {
+    float pos;
+    float vel;
+    float acc;
+};
+
+// 加加速度限幅的S曲线 (jerk限幅 -> 加速度梯形 -> 速度S形), 在线逐周期生成:
+// 每个周期在 "加速/保持/减速" 三档加加速度中选最激进、且走完本周期后仍能按限幅刹停在终点的一档,
+// 因此运动中可以随时改终点或限速 (retarget/setMaxVelocity), 曲线连续不跳变
+class MotionProfile {
+public:
+    MotionProfile();
+    void setLimits(float maxVel, float maxAcc, float maxJerk);
+    void setMaxVelocity(float maxVel) { this->maxVel = maxVel; }
+
+    void start(float target, float vel = 0);   // 从位置0出发, vel 为当前速度 (衔接上一段)
+    void retarget(float target);               // 运动中改终点
+    void stop();                               // 按限幅尽快停下 (终点改为刹车距离处)
+
+    const MotionState& step(float dt);         // 推进一个控制周期 (s)
+    const MotionState& getState() { return state; }
+    float getTarget() { return target; }
+    bool isDone() { return done; }
+
+    // (vel, acc) 为初态时按限幅刹停所需的距离 (vel 朝终点为正)
+    float brakingDistance(float vel, float acc) const;
+
+private:
+    float maxVel, maxAcc, maxJerk;
+    float target;
+    MotionState state;
+    bool done;
+};
+
+#endif
@@ -1,31 +1,32 @@
 #include "MotorControl.h"
 
-MotorControl::MotorControl() {
-    lastLeftCount = 0;
-    lastRightCount = 0;
-    lastUpdateTime = 0;
-    leftSpeed = 0;
-    rightSpeed = 0;
+MotorControl::MotorControl(HalPwm* pwm, HalEncoder* leftEncoder, HalEncoder* rightEncoder)
+    : leftEstimator(leftEncoder), rightEstimator(rightEncoder) {
+    this->pwm = pwm;
+    this->leftEncoder = leftEncoder;
+    this->rightEncoder = rightEncoder;
+    leftCountBase = 0;
+    rightCountBase = 0;
+    updated = false;
+    lastUpdateUs = 0;
     leftCalib = 1.0;
     rightCalib = 1.0;
     deadband = 0;
+    
+    driveMode = MOTOR_MODE_PWM;
+    leftTarget = rightTarget = 0;
+    leftIntegral = rightIntegral = 0;
+    velKp = VELOCITY_KP;
+    velKi = VELOCITY_KI;
+    velKff = VELOCITY_KFF;
 }
 
 void MotorControl::begin() {
-    // 配置电机控制引脚
-    pinMode(PIN_MOTOR_L_I1, OUTPUT);
-    pinMode(PIN_MOTOR_L_I2, OUTPUT);
-    pinMode(PIN_MOTOR_R_I1, OUTPUT);
-    pinMode(PIN_MOTOR_R_I2, OUTPUT);
-    
-    // 初始化编码器
-    ESP32Encoder::useInternalWeakPullResistors = puType::up;
-    leftEncoder.attachFullQuad(PIN_ENCODER_L_A, PIN_ENCODER_L_B);
-    rightEncoder.attachFullQuad(PIN_ENCODER_R_A, PIN_ENCODER_R_B);
-    leftEncoder.clearCount();
-    rightEncoder.clearCount();
+    // 初始化编码器 (上拉与清零由HAL完成)
+    leftEncoder->attach(PIN_ENCODER_L_A, PIN_ENCODER_L_B);
+    rightEncoder->attach(PIN_ENCODER_R_A, PIN_ENCODER_R_B);
     
-    // 设置PWM
+    // 设置PWM (同时把电机控制引脚配置为输出)
     setupPWM();
     
     stop();
@@ -33,15 +34,10 @@ void MotorControl::begin() {
 }
 
 void MotorControl::setupPWM() {
-    ledcSetup(PWM_CHANNEL_L1, PWM_FREQ, PWM_RESOLUTION);
-    ledcSetup(PWM_CHANNEL_L2, PWM_FREQ, PWM_RESOLUTION);
-    ledcSetup(PWM_CHANNEL_R1, PWM_FREQ, PWM_RESOLUTION);
-    ledcSetup(PWM_CHANNEL_R2, PWM_FREQ, PWM_RESOLUTION);
-    
-    ledcAttachPin(PIN_MOTOR_L_I1, PWM_CHANNEL_L1);
-    ledcAttachPin(PIN_MOTOR_L_I2, PWM_CHANNEL_L2);
-    ledcAttachPin(PIN_MOTOR_R_I1, PWM_CHANNEL_R1);
-    ledcAttachPin(PIN_MOTOR_R_I2, PWM_CHANNEL_R2);
+    pwm->setup(PWM_CHANNEL_L1, PIN_MOTOR_L_I1, PWM_FREQ, PWM_RESOLUTION);
+    pwm->setup(PWM_CHANNEL_L2, PIN_MOTOR_L_I2, PWM_FREQ, PWM_RESOLUTION);
+    pwm->setup(PWM_CHANNEL_R1, PIN_MOTOR_R_I1, PWM_FREQ, PWM_RESOLUTION);
+    pwm->setup(PWM_CHANNEL_R2, PIN_MOTOR_R_I2, PWM_FREQ, PWM_RESOLUTION);
 }
 
 void MotorControl::setPWM(uint8_t channel1, uint8_t channel2, int speed) {
@@ -51,25 +47,27 @@ void MotorControl::setPWM(uint8_t channel1, uint8_t channel2, int speed) {
     if (speed > 0) {
         // 死区补偿映射
         outputPWM = map(speed, 1, 255, deadband, 255);
-        ledcWrite(channel1, outputPWM);
-        ledcWrite(channel2, 0);
+        pwm->write(channel1, outputPWM);
+        pwm->write(channel2, 0);
     } else if (speed < 0) {
         outputPWM = map(-speed, 1, 255, deadband, 255);
-        ledcWrite(channel1, 0);
-        ledcWrite(channel2, outputPWM);
+        pwm->write(channel1, 0);
+        pwm->write(channel2, outputPWM);
     } else {
         // 同时低电平滑行
-        ledcWrite(channel1, 0);
-        ledcWrite(channel2, 0);
+        pwm->write(channel1, 0);
+        pwm->write(channel2, 0);
     }
 }
 
 void MotorControl::setLeftSpeed(int speed) {
+    driveMode = MOTOR_MODE_PWM;
     int calibratedSpeed = (int)(speed * leftCalib);
     setPWM(PWM_CHANNEL_L1, PWM_CHANNEL_L2, calibratedSpeed);
 }
 
 void MotorControl::setRightSpeed(int speed) {
+    driveMode = MOTOR_MODE_PWM;
     int calibratedSpeed = (int)(speed * rightCalib);
     setPWM(PWM_CHANNEL_R1, PWM_CHANNEL_R2, calibratedSpeed);
 }
@@ -88,42 +86,66 @@ void MotorControl::setDifferentialSpeed(int baseSpeed, int turnAdjust) {
     setRightSpeed(rightSpeed);
 }
 
+void MotorControl::setVelocity(float leftMmS, float rightMmS) {
+    if (driveMode != MOTOR_MODE_VELOCITY) {
+        // 从开环切入: 积分从0开始, 由前馈给出初始占空比
+        driveMode = MOTOR_MODE_VELOCITY;
+        leftIntegral = 0;
+        rightIntegral = 0;
+    }
+    leftTarget = leftMmS;
+    rightTarget = rightMmS;
+}
+
+void MotorControl::setVelocityGains(float kp, float ki, float kff) {
+    velKp = kp;
+    velKi = ki;
+    velKff = kff;
+}
+
 void MotorControl::stop() {
-    ledcWrite(PWM_CHANNEL_L1, 0);
-    ledcWrite(PWM_CHANNEL_L2, 0);
-    ledcWrite(PWM_CHANNEL_R1, 0);
-    ledcWrite(PWM_CHANNEL_R2, 0);
+    driveMode = MOTOR_MODE_PWM;
+    pwm->write(PWM_CHANNEL_L1, 0);
+    pwm->write(PWM_CHANNEL_L2, 0);
+    pwm->write(PWM_CHANNEL_R1, 0);
+    pwm->write(PWM_CHANNEL_R2, 0);
 }
 
 void MotorControl::brake() {
+    driveMode = MOTOR_MODE_PWM;
     // 同时高电平刹车
-    ledcWrite(PWM_CHANNEL_L1, 255);
-    ledcWrite(PWM_CHANNEL_L2, 255);
-    ledcWrite(PWM_CHANNEL_R1, 255);
-    ledcWrite(PWM_CHANNEL_R2, 255);
+    pwm->write(PWM_CHANNEL_L1, 255);
+    pwm->write(PWM_CHANNEL_L2, 255);
+    pwm->write(PWM_CHANNEL_R1, 255);
+    pwm->write(PWM_CHANNEL_R2, 255);
 }
 
 long MotorControl::getLeftEncoder() {
-    return leftEncoder.getCount();
+    return leftEncoder->getCount();
 }
 
 long MotorControl::getRightEncoder() {
-    return rightEncoder.getCount();
+    return rightEncoder->getCount();
 }
 
 void MotorControl::resetEncoders() {
-    leftEncoder.clearCount();
-    rightEncoder.clearCount();
-    lastLeftCount = 0;
-    lastRightCount = 0;
+    // 测速窗口整体平移、累计计数加上清零前的值, 清零前后速度与里程计连续
+    long leftOffset = leftEncoder->getCount();
+    long rightOffset = rightEncoder->getCount();
+    leftEncoder->clearCount();
+    rightEncoder->clearCount();
+    leftEstimator.shiftCount(leftOffset);
+    rightEstimator.shiftCount(rightOffset);
+    leftCountBase += leftOffset;
+    rightCountBase += rightOffset;
 }
 
 float MotorControl::getLeftDistance() {
-    return leftEncoder.getCount() * MM_PER_PULSE;
+    return leftEncoder->getCount() * MM_PER_PULSE;
 }
 
 float MotorControl::getRightDistance() {
-    return rightEncoder.getCount() * MM_PER_PULSE;
+    return rightEncoder->getCount() * MM_PER_PULSE;
 }
 
 float MotorControl::getAverageDistance() {
@@ -131,35 +153,54 @@ float MotorControl::getAverageDistance() {
 }
 
 void MotorControl::update() {
-    unsigned long currentTime = millis();
-    float deltaTime = (currentTime - lastUpdateTime) / 1000.0;  // 转换为秒
+    update(micros());
+}
+
+void MotorControl::update(uint32_t now) {
+    float dt = updated ? (now - lastUpdateUs) * 1e-6f : 0;
+    updated = true;
+    lastUpdateUs = now;
+    
+    leftEstimator.update(now);
+    rightEstimator.update(now);
+    float leftSpeed = leftEstimator.getSpeed();
+    float rightSpeed = rightEstimator.getSpeed();
+    
+    if (driveMode == MOTOR_MODE_VELOCITY && dt > 0) {
+        setPWM(PWM_CHANNEL_L1, PWM_CHANNEL_L2, wheelVelocityStep(leftTarget, leftSpeed, leftIntegral, dt));
+        setPWM(PWM_CHANNEL_R1, PWM_CHANNEL_R2, wheelVelocityStep(rightTarget, rightSpeed, rightIntegral, dt));
+    }
     
-    if (deltaTime >= 0.05) {  // 每50ms更新一次
-        long currentLeftCount = leftEncoder.getCount();
-        long currentRightCount = rightEncoder.getCount();
-        
-        long deltaLeft = currentLeftCount - lastLeftCount;
-        long deltaRight = currentRightCount - lastRightCount;
-        
-        leftSpeed = (deltaLeft * MM_PER_PULSE) / deltaTime;
-        rightSpeed = (deltaRight * MM_PER_PULSE) / deltaTime;
-        
-        lastLeftCount = currentLeftCount;
-        lastRightCount = currentRightCount;
-        lastUpdateTime = currentTime;
-        
 #if DEBUG_ENCODER
+    static unsigned long lastPrint = 0;
+    if (millis() - lastPrint >= 50) {
+        lastPrint = millis();
         Serial.printf("Speed L:%.1f R:%.1f mm/s\n", leftSpeed, rightSpeed);
+    }
 #endif
+}
+
+// 单轮: 前馈 (kff * 目标) + PI; 输出饱和且误差同向时停止积分
+int MotorControl::wheelVelocityStep(float target, float measured, float& integral, float dt) {
+    if (target == 0) {
+        integral = 0;
+        return 0;   // 目标为0时滑行, 不在死区附近来回抖
+    }
+    float error = target - measured;
+    float output = velKff * target + velKp * error + integral;
+    bool saturated = (output >= 255 && error > 0) || (output <= -255 && error < 0);
+    if (!saturated) {
+        integral = constrain(integral + velKi * error * dt, -VELOCITY_INTEGRAL_MAX, VELOCITY_INTEGRAL_MAX);
     }
+    return (int)constrain(output, -255.0f, 255.0f);
 }
 
 float MotorControl::getLeftSpeed() {
-    return leftSpeed;
+    return leftEstimator.getSpeed();
 }
 
 float MotorControl::getRightSpeed() {
-    return rightSpeed;
+    return rightEstimator.getSpeed();
 }
 
 void MotorControl::setCalibration(float leftCalib, float rightCalib) {
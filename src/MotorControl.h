@@ -2,12 +2,19 @@
 #define MOTOR_CONTROL_H
 
 #include <Arduino.h>
-#include <ESP32Encoder.h>
 #include "config.h"
+#include "hal/Hal.h"
+#include "WheelSpeedEstimator.h"
+
+// 驱动模式: 开环PWM, 或 mm/s 轮速闭环 (前馈 + 每轮PI, 在 update() 中按控制周期运行)
+enum MotorDriveMode {
+    MOTOR_MODE_PWM,
+    MOTOR_MODE_VELOCITY
+};
 
 class MotorControl {
 public:
-    MotorControl();
+    MotorControl(HalPwm* pwm, HalEncoder* leftEncoder, HalEncoder* rightEncoder);
     void begin();
     
     // 设置电机速度 (-255 到 +255, 负数为反转)
@@ -16,6 +23,13 @@ public:
     void setBothSpeed(int speed);
     void setDifferentialSpeed(int baseSpeed, int turnAdjust);
     
+    // 速度模式: 目标轮速 mm/s, 进入闭环; 之后调用 setLeftSpeed/stop/brake 等回到开环PWM
+    void setVelocity(float leftMmS, float rightMmS);
+    void setVelocityGains(float kp, float ki, float kff);
+    MotorDriveMode getDriveMode() { return driveMode; }
+    float getLeftTarget() { return leftTarget; }
+    float getRightTarget() { return rightTarget; }
+    
     // 停止
     void stop();
     void brake();  // 刹车(短接)
@@ -25,14 +39,19 @@ public:
     long getRightEncoder();
     void resetEncoders();
     
+    // 累计计数: 不受 resetEncoders() 影响 (里程计使用)
+    int64_t getLeftTotalCount() { return leftCountBase + leftEncoder->getCount(); }
+    int64_t getRightTotalCount() { return rightCountBase + rightEncoder->getCount(); }
+    
     // 里程计算
     float getLeftDistance();   // mm
     float getRightDistance();  // mm
     float getAverageDistance(); // mm
     
-    // 速度计算 (需要定期调用update)
+    // 速度计算 (每个控制周期调用update, 速度模式下同时运行轮速PI)
     void update();
-    float getLeftSpeed();      // mm/s
+    void update(uint32_t nowUs);   // 显式时间戳 (基准测试按控制周期给时间)
+    float getLeftSpeed();      // mm/s (低速用沿间隔, 高速用窗口计数, 见 WheelSpeedEstimator)
     float getRightSpeed();     // mm/s
     
     // 电机校准系数
@@ -40,17 +59,27 @@ public:
     void setDeadband(int deadband); // 设置死区
     
 private:
-    ESP32Encoder leftEncoder;
-    ESP32Encoder rightEncoder;
+    HalPwm* pwm;
+    HalEncoder* leftEncoder;
+    HalEncoder* rightEncoder;
     
     int deadband; // 死区值
     
-    long lastLeftCount;
-    long lastRightCount;
-    unsigned long lastUpdateTime;
+    int64_t leftCountBase;    // 历次清零前的计数之和
+    int64_t rightCountBase;
+    
+    WheelSpeedEstimator leftEstimator;
+    WheelSpeedEstimator rightEstimator;
+    bool updated;
+    uint32_t lastUpdateUs;
+    
+    // 速度模式
+    MotorDriveMode driveMode;
+    float leftTarget, rightTarget;     // mm/s
+    float leftIntegral, rightIntegral; // PWM
+    float velKp, velKi, velKff;
     
-    float leftSpeed;   // mm/s
-    float rightSpeed;  // mm/s
+    int wheelVelocityStep(float target, float measured, float& integral, float dt);
     
     float leftCalib;   // 左电机校准系数
     float rightCalib;  // 右电机校准系数
@@ -1,10 +1,11 @@
 #include "ObjectDetector.h"
-#include "WebServerManager.h"
+#include "SensorRecorder.h"
 
-ObjectDetector::ObjectDetector(Sensors* sensors, MotorControl* motor) {
-    this->sensors = sensors;
+ObjectDetector::ObjectDetector(LaserRing* laser, MotorControl* motor) {
+    this->laser = laser;
     this->motor = motor;
-    this->webServer = nullptr;
+    this->recorder = nullptr;
+    this->logCallback = nullptr;
     
     state = DETECT_IDLE;
     stableCountThreshold = 5;      // 提高到5次稳定读数，确保可靠性
@@ -29,8 +30,8 @@ ObjectDetector::ObjectDetector(Sensors* sensors, MotorControl* motor) {
     reset();
 }
 
-void ObjectDetector::setWebServer(WebServerManager* server) {
-    this->webServer = server;
+void ObjectDetector::setLogCallback(void (*callback)(String message)) {
+    logCallback = callback;
 }
 
 void ObjectDetector::reset() {
@@ -40,7 +41,10 @@ void ObjectDetector::reset() {
     endEncoderPos = 0;
     accumulatedDistance = 0;
     lastEncoderPos = 0;
+    nowMs = 0;
     startTime = 0;
+    lastSampleTime = 0;
+    laserLogged = false;
     sampleCount = 0;
     
     // 重置全局路径积分（简化版）
@@ -59,6 +63,13 @@ void ObjectDetector::reset() {
     filterIndex = 0;
     filterCount = 0;
     memset(filterBuffer, 0, sizeof(filterBuffer));
+    lastRaw = 0;
+    outlierCount = 0;
+    lastFilteredDist = 0;
+    jumpCount = 0;
+    jumpFilterPrimed = false;
+    lastWarn = 0;
+    lastDebug = 0;
     
     result.length = 0;
     result.avgDistance = 0;
@@ -82,6 +93,12 @@ void ObjectDetector::startDetection(uint16_t baselineDistance, uint16_t threshol
     
     state = DETECT_WAITING;
     startTime = millis();
+    nowMs = startTime;
+    lastSampleTime = startTime;
+    
+    // 丢弃检测开始前积压的激光采样
+    laser->clear();
+    laserLogged = false;
     
     // 初始化编码器基准
     // lastGlobalEncoderPos = getAverageEncoderDistance();
@@ -93,17 +110,33 @@ void ObjectDetector::startDetection(uint16_t baselineDistance, uint16_t threshol
     serpentineCorrection = 0;
     enableSerpentineCorrection = false;  // 禁用蛇形修正
     
+    if (recorder) {
+        SensorRecordingHeader config;
+        memset(&config, 0, sizeof(config));
+        config.startMs = startTime;
+        config.threshold = detectThreshold;
+        config.filterSize = filterSize;
+        config.stableCount = stableCountThreshold;
+        config.timeoutMs = timeoutMs;
+        config.lengthScale = lengthScale;
+        config.lengthOffset = lengthOffset;
+        config.deviationCorrection = deviationCorrectionRatio;
+        config.mmPerPulse = MM_PER_PULSE;
+        recorder->start(config);
+    }
+    
     log("\n=== Object Detection Started ===");
     log("⚙️ Range: <" + String(threshold) + "mm");
     log("⚙️ Stable: " + String(stableCountThreshold) + " readings");
     log("⚙️ Filter: " + String(filterSize) + " points");
     log("⚙️ Scale: " + String(lengthScale, 3) + " Offset: " + String(lengthOffset, 1));
-    log("⚙️ Laser: " + String(sensors->getLaserDistance()) + "mm");
     log("⚙️ Encoder: " + String(lastGlobalEncoderPos, 1) + "mm");
     log("➡ Waiting...");
 }
 
 void ObjectDetector::stopDetection() {
+    if (recorder) recorder->stop();
+    
     if (state == DETECT_IN_OBJECT) {
         // 如果正在检测物块，记录结束位置
         endEncoderPos = getAverageEncoderDistance();
@@ -137,28 +170,81 @@ void ObjectDetector::stopDetection() {
 }
 
 void ObjectDetector::update(int16_t linePosition) {
+    update(linePosition, millis());
+}
+
+void ObjectDetector::update(int16_t linePosition, unsigned long nowMs) {
     if (state == DETECT_IDLE || state == DETECT_COMPLETED || state == DETECT_FAILED) {
         return;
     }
+    this->nowMs = nowMs;
     
     // 检查超时
-    if (millis() - startTime > timeoutMs) {
+    if (nowMs - startTime > timeoutMs) {
+        recordCycle(nullptr, 0, linePosition);
         state = DETECT_FAILED;
         log("✗ Detection timeout!");
+        if (recorder) recorder->stop();
         return;
     }
     
-    // 检查传感器是否就绪
-    if (!sensors->isLaserReady()) {
-        static unsigned long lastWarn = 0;
-        if (millis() - lastWarn > 2000) {  // 减少警告频率
+    // 批量取出读取任务推送的激光采样, 逐个送入检测状态机
+    LaserSample batch[LASER_BATCH_SIZE];
+    size_t count = laser->popBatch(batch, LASER_BATCH_SIZE);
+    recordCycle(batch, count, linePosition);
+    
+    // 长时间没有采样: 传感器未就绪或已掉线
+    if (count == 0) {
+        if (nowMs - lastSampleTime > 2000 && nowMs - lastWarn > 2000) {  // 减少警告频率
             log("⚠ Laser sensor not ready!");
-            lastWarn = millis();
+            lastWarn = nowMs;
         }
         return;
     }
+    lastSampleTime = nowMs;
+    if (!laserLogged) {
+        log("⚙️ Laser: " + String(batch[0].filtered) + "mm");
+        laserLogged = true;
+    }
     
-    uint16_t rawDistance = sensors->getLaserDistance();
+    for (size_t i = 0; i < count; i++) {
+        processSample(batch[i]);
+        if (!isDetecting()) break;  // 本批次中已完成检测
+    }
+    
+    if (!isDetecting() && recorder) {
+        recorder->stop();
+    }
+}
+
+// 录制本周期: 先写本批激光采样, 再写周期记录 (回放时按同样顺序入队再调用update)
+void ObjectDetector::recordCycle(const LaserSample* batch, size_t count, int16_t linePosition) {
+    if (!recorder || !recorder->isRecording()) return;
+    
+    SensorRecord rec;
+    rec.encLeft = (int32_t)motor->getLeftEncoder();
+    rec.encRight = (int32_t)motor->getRightEncoder();
+    rec.linePosition = linePosition;
+    rec.reserved = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        rec.timeUs = batch[i].timestampUs - startTime * 1000;
+        rec.laserRaw = batch[i].raw;
+        rec.laserFiltered = batch[i].filtered;
+        rec.flags = REC_LASER;
+        recorder->record(rec);
+    }
+    
+    rec.timeUs = (nowMs - startTime) * 1000;
+    rec.laserRaw = 0;
+    rec.laserFiltered = 0;
+    rec.flags = REC_CYCLE;
+    recorder->record(rec);
+}
+
+void ObjectDetector::processSample(const LaserSample& sample) {
+    uint16_t rawDistance = sample.filtered;
+    unsigned long sampleTimeMs = sample.timestampUs / 1000;
     
     // 1. 无效值处理：将无效值(>2000或<10)视为"无穷远"(2000mm)
     // 这样可以确保在物块结束时(后面是空的)，状态机能正确跳转
@@ -171,8 +257,10 @@ void ObjectDetector::update(int16_t linePosition) {
     uint16_t filteredDistance = getFilteredDistance(processedDistance);
     
     // 3. 连续性检查：确保激光读数连续稳定（避免跳变）
-    static uint16_t lastFilteredDist = filteredDistance;
-    static int jumpCount = 0;
+    if (!jumpFilterPrimed) {
+        lastFilteredDist = filteredDistance;
+        jumpFilterPrimed = true;
+    }
     if (abs((int)filteredDistance - (int)lastFilteredDist) > 200) {
         jumpCount++;
         if (jumpCount < 3) {
@@ -192,19 +280,18 @@ void ObjectDetector::update(int16_t linePosition) {
     // 移除复杂的蛇形补偿，直接输出原始平均距离
     globalPathDistance = getAverageEncoderDistance();
     
-    // 存入历史缓冲区
-    pushHistory(filteredDistance, globalPathDistance);
+    // 存入历史缓冲区 (使用采样时刻而非处理时刻)
+    pushHistory(filteredDistance, globalPathDistance, sampleTimeMs);
     // ----------------------------------
     
     // 调试输出（每500ms一次，便于问题诊断）
-    static unsigned long lastDebug = 0;
-    if (millis() - lastDebug > 500) {
+    if (nowMs - lastDebug > 500) {
         const char* stateStr[] = {"IDLE", "WAITING", "IN_OBJECT", "COMPLETED", "FAILED"};
         log("[Detect] State:" + String(stateStr[state]) + 
             " Raw:" + String(rawDistance) + 
             " Filt:" + String(filteredDistance) + 
             "mm | GlobalDist:" + String(globalPathDistance, 1) + "mm");
-        lastDebug = millis();
+        lastDebug = nowMs;
     }
     
     // 新逻辑：小于阈值=物块在范围内，大于阈值=无物块
@@ -222,7 +309,7 @@ void ObjectDetector::update(int16_t linePosition) {
                 if (stableCount >= stableCountThreshold) {
                     // 确认物块进入范围
                     state = DETECT_IN_OBJECT;
-                    objectEnterTime = millis(); // 记录进入时间
+                    objectEnterTime = nowMs; // 记录进入时间
                     
                     // --- 精确边缘检测 ---
                     // 回溯历史找到精确的进入点
@@ -307,7 +394,7 @@ void ObjectDetector::update(int16_t linePosition) {
                     if (result.length > 1000.0) result.length = 1000.0;
                     
                     // 计算持续时间
-                    result.duration = millis() - objectEnterTime;
+                    result.duration = nowMs - objectEnterTime;
                     
                     // 计算统计数据
                     if (sampleCount > 5) {  // 至少5个样本
@@ -322,7 +409,7 @@ void ObjectDetector::update(int16_t linePosition) {
                     // 有效性检查 - 更新为匹配新的范围 (500-1000mm)
                     // 只要原始长度在合理范围内(10-1200)，且有足够的样本，就认为是有效的
                     result.valid = (rawLength > 10 && rawLength < 1200 && sampleCount > 5);
-                    result.timestamp = millis();
+                    result.timestamp = nowMs;
                     
                     state = DETECT_COMPLETED;
                     
@@ -349,8 +436,8 @@ void ObjectDetector::update(int16_t linePosition) {
     }
 }
 
-void ObjectDetector::pushHistory(uint16_t dist, float globalDist) {
-    historyBuffer[historyIndex].timestamp = millis();
+void ObjectDetector::pushHistory(uint16_t dist, float globalDist, unsigned long timestamp) {
+    historyBuffer[historyIndex].timestamp = timestamp;
     historyBuffer[historyIndex].laserDist = dist;
     historyBuffer[historyIndex].globalDist = globalDist;
     
@@ -441,8 +528,6 @@ uint16_t ObjectDetector::getFilteredDistance(uint16_t rawDistance) {
     if (filterSize <= 1) return rawDistance;
     
     // 异常值检测：如果与上次差距过大，先记录但暂不使用
-    static uint16_t lastRaw = rawDistance;
-    static int outlierCount = 0;
     if (abs((int)rawDistance - (int)lastRaw) > 500 && lastRaw != 0) {
         outlierCount++;
         if (outlierCount < 2) {
@@ -554,8 +639,8 @@ bool ObjectDetector::isDistanceStable(uint16_t distance, uint16_t baseline, uint
 }
 
 void ObjectDetector::log(String message) {
-    if (webServer != nullptr) {
-        webServer->addLog(message);
+    if (logCallback != nullptr) {
+        logCallback(message);
     } else {
         Serial.println(message);
     }
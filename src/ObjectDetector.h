@@ -2,11 +2,10 @@
 #define OBJECT_DETECTOR_H
 
 #include <Arduino.h>
-#include "Sensors.h"
+#include "LaserSample.h"
 #include "MotorControl.h"
 
-// 前向声明
-class WebServerManager;
+class SensorRecorder;
 
 // 物块检测状态
 enum DetectionState {
@@ -38,16 +37,21 @@ struct HistorySample {
 
 class ObjectDetector {
 public:
-    ObjectDetector(Sensors* sensors, MotorControl* motor);
+    ObjectDetector(LaserRing* laser, MotorControl* motor);
     
-    // 设置WebServer用于日志输出
-    void setWebServer(WebServerManager* server);
+    // 设置日志输出 (未设置时输出到串口)
+    void setLogCallback(void (*callback)(String message));
     
     // 开始检测
     void startDetection(uint16_t baselineDistance = 800, uint16_t threshold = 100);
     
     // 更新检测（需要在主循环中调用）
     void update(int16_t linePosition = 0);
+    // 指定当前时刻 (回放时使用录制的时间, 保证结果可复现)
+    void update(int16_t linePosition, unsigned long nowMs);
+    
+    // 检测期间把激光/编码器/线位置写入录制器 (nullptr 关闭)
+    void setRecorder(SensorRecorder* recorder) { this->recorder = recorder; }
     
     // 停止检测
     void stopDetection();
@@ -59,6 +63,7 @@ public:
     
     // 获取测量结果
     ObjectMeasurement getResult() { return result; }
+    unsigned long getStartTime() { return startTime; }
     
     // 重置检测器
     void reset();
@@ -71,9 +76,12 @@ public:
     void setDeviationCorrection(float ratio) { deviationCorrectionRatio = ratio; }
 
 private:
-    Sensors* sensors;
+    friend class ObjectDetectorBench;   // tools/bench 直接测量内部算法
+
+    LaserRing* laser;             // 激光采样 (本类为唯一消费者)
     MotorControl* motor;
-    WebServerManager* webServer;  // 用于日志输出
+    SensorRecorder* recorder;
+    void (*logCallback)(String message);
     
     DetectionState state;
     ObjectMeasurement result;
@@ -97,7 +105,10 @@ private:
     float accumulatedDistance;    // 累积的有效距离
     float lastEncoderPos;         // 上一次的编码器读数
 
+    unsigned long nowMs;          // 当前 update() 的时刻
     unsigned long startTime;      // 开始时间 (整个检测任务)
+    unsigned long lastSampleTime; // 最近一次收到激光采样的时间
+    bool laserLogged;             // 已打印检测开始后的第一个激光读数
     unsigned long objectEnterTime; // 物块进入时间
 
     
@@ -106,6 +117,16 @@ private:
     uint16_t filterBuffer[MAX_FILTER_SIZE];
     int filterIndex;
     int filterCount;
+    uint16_t lastRaw;             // 异常值检测
+    int outlierCount;
+    
+    // 连续性检查 (跳变抑制)
+    uint16_t lastFilteredDist;
+    int jumpCount;
+    bool jumpFilterPrimed;
+    
+    unsigned long lastWarn;
+    unsigned long lastDebug;
     
     // 距离采样（用于滤波和统计）
     static const int MAX_SAMPLES = 100;
@@ -120,6 +141,11 @@ private:
     bool isDistanceStable(uint16_t distance, uint16_t baseline, uint16_t threshold);
     void log(String message);            // 日志输出（同时到串口和网页）
     
+    // 处理单个激光采样
+    static const size_t LASER_BATCH_SIZE = 16;
+    void processSample(const LaserSample& sample);
+    void recordCycle(const LaserSample* batch, size_t count, int16_t linePosition);
+    
     // 新增：滑动窗口滤波
     uint16_t getFilteredDistance(uint16_t rawDistance);
 
@@ -138,7 +164,7 @@ private:
     float serpentineCorrection;    // 累积的蛇形修正量
     bool enableSerpentineCorrection; // 是否启用蛇形修正
 
-    void pushHistory(uint16_t dist, float globalDist);
+    void pushHistory(uint16_t dist, float globalDist, unsigned long timestamp);
     float findPreciseCrossingPoint(bool entering, uint16_t threshold);
     float calculateSerpentineCorrection(float leftDelta, float rightDelta);
 };
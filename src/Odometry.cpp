@@ -0,0 +1,57 @@
+#include "Odometry.h"
+
+Odometry::Odometry() {
+    trackMm = ODOM_TRACK_MM;
+    started = false;
+    lastLeft = lastRight = 0;
+    reset();
+}
+
+void Odometry::reset() {
+    pose.x = 0;
+    pose.y = 0;
+    pose.heading = 0;
+    pose.distance = 0;
+}
+
+void Odometry::update(int64_t leftCount, int64_t rightCount) {
+    WheelStep step = takeStep(leftCount, rightCount);
+    integrate(step, wheelTurn(step));
+}
+
+WheelStep Odometry::takeStep(int64_t leftCount, int64_t rightCount) {
+    WheelStep step = {0, 0};
+    if (!started) {
+        // 首次调用只记计数基准
+        started = true;
+    } else {
+        step.left = (leftCount - lastLeft) * MM_PER_PULSE;
+        step.right = (rightCount - lastRight) * MM_PER_PULSE;
+    }
+    lastLeft = leftCount;
+    lastRight = rightCount;
+    return step;
+}
+
+void Odometry::integrate(const WheelStep& step, float dHeading) {
+    // 中点积分: 一个控制周期内转角很小, 与精确圆弧解的差别远小于一个脉冲
+    float ds = (step.left + step.right) / 2;
+    float midHeading = pose.heading + dHeading / 2;
+    pose.x += ds * cosf(midHeading);
+    pose.y += ds * sinf(midHeading);
+    pose.heading += dHeading;
+    pose.distance += ds;
+}
+
+Pose Odometry::relativeTo(const Pose& origin) {
+    float dx = pose.x - origin.x;
+    float dy = pose.y - origin.y;
+    float c = cosf(origin.heading);
+    float s = sinf(origin.heading);
+    Pose rel;
+    rel.x = dx * c + dy * s;
+    rel.y = -dx * s + dy * c;
+    rel.heading = pose.heading - origin.heading;
+    rel.distance = pose.distance - origin.distance;
+    return rel;
+}
@@ -0,0 +1,48 @@
+#ifndef ODOMETRY_H
+#define ODOMETRY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// 位姿: 起点坐标系 (上电/reset 时车的位置为原点, 朝向为 +x), 逆时针为正
+struct Pose {
+    float x, y;        // mm
+    float heading;     // rad, 连续累加不回绕 (转两圈为 4π)
+    float distance;    // mm, 沿路径累计里程 (后退为负)
+};
+
+// 一个控制周期的两轮位移 (mm)
+struct WheelStep {
+    float left, right;
+};
+
+// 差速里程计: 每个控制周期送入两轮累计计数 (MotorControl::getLeftTotalCount), 积分出位姿
+// 避障/入库/任务中的 resetEncoders() 不影响位姿; 各动作需要"从某处起走了多少"时先 getPose() 记下起点,
+// 再用 relativeTo() 取相对位移
+class Odometry {
+public:
+    Odometry();
+    void setTrackWidth(float mm) { trackMm = mm; }
+    void reset();                       // 位姿归零 (不影响计数基准)
+
+    // 航向增量取编码器差速
+    void update(int64_t leftCount, int64_t rightCount);
+    // 航向增量由外部给出 (陀螺仪融合, 见 HeadingEstimator): 先 takeStep() 取出位移, 再 integrate()
+    WheelStep takeStep(int64_t leftCount, int64_t rightCount);
+    float wheelTurn(const WheelStep& step) { return (step.right - step.left) / trackMm; }
+    void integrate(const WheelStep& step, float dHeading);
+
+    const Pose& getPose() { return pose; }
+    float getHeadingDeg() { return pose.heading * 180.0f / (float)PI; }
+
+    // 当前位姿在 origin 坐标系下的表示: x 为沿 origin 朝向前进, y 为向左, heading 为转过的角度, distance 为走过的里程
+    Pose relativeTo(const Pose& origin);
+
+private:
+    Pose pose;
+    float trackMm;
+    bool started;
+    int64_t lastLeft, lastRight;
+};
+
+#endif
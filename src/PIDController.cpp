@@ -12,6 +12,9 @@ PIDController::PIDController(float kp, float ki, float kd) {
     lastTime = 0;
     integralRange = 10000; // 默认不分离
     pTerm = iTerm = dTerm = 0;
+    derivativeCutoffHz = PID_D_CUTOFF_HZ;
+    antiWindupGain = PID_ANTIWINDUP_GAIN;
+    reset();
 }
 
 void PIDController::setGains(float kp, float ki, float kd) {
@@ -34,6 +37,14 @@ void PIDController::setIntegralRange(float range) {
 }
 
 float PIDController::compute(float input) {
+    return computeInternal(input, 0, false);
+}
+
+float PIDController::compute(float input, float inputRate) {
+    return computeInternal(input, inputRate, true);
+}
+
+float PIDController::computeInternal(float input, float inputRate, bool hasRate) {
     unsigned long currentTime = millis();
     float deltaTime = (currentTime - lastTime) / 1000.0;  // 转换为秒
     
@@ -51,8 +62,8 @@ float PIDController::compute(float input) {
         return constrain(pTerm, outputMin, outputMax);
     }
     
-    // 限制计算频率,避免deltaTime太小导致微分爆炸
-    if (deltaTime < 0.01) {  // 小于10ms不计算
+    // 限制计算频率,避免deltaTime太小导致微分爆炸 (外部给出变化率时不需要)
+    if (!hasRate && deltaTime < 0.01) {  // 小于10ms不计算
         return constrain(pTerm + iTerm + dTerm, outputMin, outputMax);
     }
     
@@ -75,7 +86,7 @@ float PIDController::compute(float input) {
             integral = 0; // 误差过大时清除积分
         }
         
-        integral = constrain(integral, -500, 500);  // 积分限幅
+        integral = constrain(integral, -PID_INTEGRAL_LIMIT, PID_INTEGRAL_LIMIT);  // 积分限幅
         iTerm = ki * integral;
     } else {
         integral = 0;
@@ -83,7 +94,7 @@ float PIDController::compute(float input) {
     }
     
     // D项(微分先行,对输入微分而不是误差)
-    float derivative = -(input - (setpoint - lastError)) / deltaTime;
+    float derivative = hasRate ? -inputRate : -(input - (setpoint - lastError)) / deltaTime;
     dTerm = kd * derivative;
     
     // 计算输出
@@ -101,4 +112,95 @@ void PIDController::reset() {
     integral = 0;
     lastTime = 0;
     pTerm = iTerm = dTerm = 0;
+    
+    sampleStarted = false;
+    lastSampleUs = 0;
+    lastInput = 0;
+    integralTerm = 0;
+    filteredDerivative = 0;
+    bumpOffset = 0;
+    lastOutput = 0;
+}
+
+void PIDController::setGainsBumpless(float kp, float ki, float kd) {
+    if (kp == this->kp && ki == this->ki && kd == this->kd) {
+        return;
+    }
+    // 积分项已按输出单位累积, 只有P/D会在切换瞬间跳变
+    if (sampleStarted) {
+        bumpOffset += (this->kp - kp) * lastError + (this->kd - kd) * filteredDerivative;
+    }
+    setGains(kp, ki, kd);
+}
+
+float PIDController::computeAt(float input, uint32_t timestampUs) {
+    return computeAtInternal(input, 0, false, timestampUs);
+}
+
+float PIDController::computeAt(float input, float inputRate, uint32_t timestampUs) {
+    return computeAtInternal(input, inputRate, true, timestampUs);
+}
+
+float PIDController::computeAtInternal(float input, float inputRate, bool hasRate, uint32_t timestampUs) {
+    float error = setpoint - input;
+    uint32_t elapsedUs = timestampUs - lastSampleUs;
+    
+    if (sampleStarted && elapsedUs == 0) {
+        return lastOutput;  // 同一帧, 没有新信息
+    }
+    
+    // 首帧或空档过长: 微分从这一帧重新起步, 积分保留 (只有 reset() 清零)
+    if (!sampleStarted || elapsedUs > PID_MAX_GAP_MS * 1000UL) {
+        sampleStarted = true;
+        lastSampleUs = timestampUs;
+        lastInput = input;
+        lastError = error;
+        filteredDerivative = hasRate ? -inputRate : 0;
+        bumpOffset = 0;
+        
+        pTerm = kp * error;
+        iTerm = integralTerm;
+        dTerm = kd * filteredDerivative;
+        lastOutput = constrain(pTerm + iTerm + dTerm, outputMin, outputMax);
+        return lastOutput;
+    }
+    
+    float dt = elapsedUs * 1e-6f;
+    
+    // D项: 微分先行 (对输入), 一阶低通 alpha = dt / (dt + 1/(2*pi*fc))
+    float derivative = hasRate ? -inputRate : -(input - lastInput) / dt;
+    if (derivativeCutoffHz > 0) {
+        float alpha = dt / (dt + 1.0f / (2.0f * (float)PI * derivativeCutoffHz));
+        filteredDerivative += alpha * (derivative - filteredDerivative);
+    } else {
+        filteredDerivative = derivative;
+    }
+    
+    pTerm = kp * error;
+    dTerm = kd * filteredDerivative;
+    bumpOffset -= bumpOffset * min(1.0f, dt * 1000.0f / PID_BUMPLESS_MS);
+    
+    float unsaturated = pTerm + integralTerm + dTerm + bumpOffset;
+    float output = constrain(unsaturated, outputMin, outputMax);
+    
+    // I项: 积分分离 + 反算抗饱和 (输出被限幅时按差值把积分拉回)
+    // 回拉只让积分向0收敛: 仅P项就超出限幅时, 不能把积分推到反方向
+    if (ki > 0 && fabsf(error) < integralRange) {
+        integralTerm += ki * error * dt;
+        float backCalc = antiWindupGain * (output - unsaturated) * dt;
+        if (integralTerm * backCalc < 0) {
+            integralTerm = fabsf(backCalc) > fabsf(integralTerm) ? 0 : integralTerm + backCalc;
+        }
+        float limit = ki * PID_INTEGRAL_LIMIT;
+        integralTerm = constrain(integralTerm, -limit, limit);
+    } else {
+        integralTerm = 0;
+    }
+    iTerm = integralTerm;
+    
+    lastInput = input;
+    lastError = error;
+    lastSampleUs = timestampUs;
+    lastOutput = output;
+    return output;
 }
@@ -2,6 +2,7 @@
 #define PID_CONTROLLER_H
 
 #include <Arduino.h>
+#include "config.h"
 
 class PIDController {
 public:
@@ -13,6 +14,19 @@ public:
     void setIntegralRange(float range); // 设置积分分离范围
     
     float compute(float input);
+    // 由外部估计器提供输入变化率 (单位/秒) 时, 微分项直接使用它, 不再对输入差分
+    float compute(float input, float inputRate);
+    
+    // 微秒时基: 按量测时刻计算 (同一帧重复调用直接返回上次输出), 不受10ms最小间隔限制
+    // 微分一阶低通, 积分反算抗饱和, 空档超过 PID_MAX_GAP_MS 只重新起步微分、不清积分
+    float computeAt(float input, uint32_t timestampUs);
+    float computeAt(float input, float inputRate, uint32_t timestampUs);
+    void setDerivativeCutoff(float hz) { derivativeCutoffHz = hz; }   // 0 = 不滤波
+    void setAntiWindupGain(float gain) { antiWindupGain = gain; }     // 反算增益 (1/s)
+    
+    // 无扰切换增益组: 切换瞬间的输出差值并入补偿量, 按 PID_BUMPLESS_MS 指数衰减 (仅 computeAt 使用)
+    void setGainsBumpless(float kp, float ki, float kd);
+    
     void reset();
     
     // 调试信息
@@ -31,6 +45,21 @@ private:
     unsigned long lastTime;
     
     float pTerm, iTerm, dTerm;  // 用于调试
+    
+    float computeInternal(float input, float inputRate, bool hasRate);
+    
+    // computeAt 状态 (积分以输出单位累积, 改变Ki时输出不跳变)
+    bool sampleStarted;
+    uint32_t lastSampleUs;
+    float lastInput;
+    float integralTerm;
+    float filteredDerivative;
+    float bumpOffset;
+    float lastOutput;
+    float derivativeCutoffHz;
+    float antiWindupGain;
+    
+    float computeAtInternal(float input, float inputRate, bool hasRate, uint32_t timestampUs);
 };
 
 #endif
@@ -11,6 +11,7 @@ ParameterManager::ParameterManager() {
     kpPost = KP_LINE;
     kiPost = KI_LINE;
     kdPost = KD_LINE;
+    pidGainsOutdated = false;
     
     speedSlow = SPEED_SLOW;
     speedNormal = SPEED_NORMAL;
@@ -35,6 +36,9 @@ ParameterManager::ParameterManager() {
     avoidTurn2Dist = 118.0;
     avoidTurn3Dist = 118.0;
     avoidSearchDist = 800;
+    avoidMode = AVOID_MODE_DEFAULT;
+    avoidRadius = AVOID_RADIUS_MM;
+    avoidMargin = AVOID_MARGIN_MM;
     
     parkingDistSlow = 60;
     parkingDistVerySlow = 30;
@@ -48,9 +52,13 @@ ParameterManager::ParameterManager() {
     // 高级PID默认值
     pidIntegralRange = PID_INTEGRAL_RANGE;
     motorDeadband = MOTOR_DEADBAND;
-    pidSmallErrorThres = PID_SMALL_ERROR_THRES;
-    pidKpSmallScale = PID_KP_SMALL_SCALE;
-    pidKdSmallScale = PID_KD_SMALL_SCALE;
+    pidDCutoff = PID_D_CUTOFF_HZ;
+    lineMode = LINE_MODE_DEFAULT;
+    lineStream = LINE_STREAM_DEFAULT;
+    lineEstimator = LINE_EST_DEFAULT;
+    imuTurns = IMU_TURNS_DEFAULT;
+    trackLearn = TRACK_LEARN_DEFAULT;
+    trackLatAccel = TRACK_LAT_ACCEL;
     
     // 物体测量默认值（优先保证稳定性）
     objectFilterSize = 5;          // 5点滤波，平衡稳定性与响应
@@ -64,6 +72,13 @@ ParameterManager::ParameterManager() {
     encKd = 0.0;
     // 轮距15cm，原地旋转90度，单轮行程 = pi * 150 * (90/360) ≈ 117.8mm
     turn90Dist = 118.0; 
+    
+    velocityMode = VELOCITY_MODE_DEFAULT;
+    velKp = VELOCITY_KP;
+    velKi = VELOCITY_KI;
+    velKff = VELOCITY_KFF;
+    moveAccel = MOTION_ACCEL_DEFAULT;
+    moveJerk = MOTION_JERK_DEFAULT;
 
     // 避障步骤系数默认值
     avoidS1_L = 1.0; avoidS1_R = 1.0;
@@ -82,6 +97,14 @@ ParameterManager::ParameterManager() {
     sensorWeights[5] = 400;
     sensorWeights[6] = 700;
     sensorWeights[7] = 1000;
+    
+    // 循迹校准 (min=max=0 表示未校准)
+    memset(lineCalMin, 0, sizeof(lineCalMin));
+    memset(lineCalMax, 0, sizeof(lineCalMax));
+    lineCalRevision = 0;
+    
+    gainSchedule.setDefaults();
+    gainRevision = 0;
 }
 
 void ParameterManager::begin() {
@@ -90,6 +113,10 @@ void ParameterManager::begin() {
 }
 
 void ParameterManager::save() {
+    // 旧版增益未经确认前不更新版本号, 下次启动仍然提示
+    if (!pidGainsOutdated) {
+        preferences.putInt("pidVer", PID_GAIN_VERSION);
+    }
     preferences.putFloat("kp", kp);
     preferences.putFloat("ki", ki);
     preferences.putFloat("kd", kd);
@@ -121,6 +148,9 @@ void ParameterManager::save() {
     preferences.putFloat("avoidTurn2", avoidTurn2Dist);
     preferences.putFloat("avoidTurn3", avoidTurn3Dist);
     preferences.putInt("avoidSearch", avoidSearchDist);
+    preferences.putInt("avoidMode", avoidMode);
+    preferences.putInt("avoidRadius", avoidRadius);
+    preferences.putInt("avoidMargin", avoidMargin);
     
     preferences.putFloat("avS1L", avoidS1_L); preferences.putFloat("avS1R", avoidS1_R);
     preferences.putFloat("avS2L", avoidS2_L); preferences.putFloat("avS2R", avoidS2_R);
@@ -140,9 +170,13 @@ void ParameterManager::save() {
     
     preferences.putInt("pidIntRange", pidIntegralRange);
     preferences.putInt("deadband", motorDeadband);
-    preferences.putInt("smallErr", pidSmallErrorThres);
-    preferences.putFloat("kpScale", pidKpSmallScale);
-    preferences.putFloat("kdScale", pidKdSmallScale);
+    preferences.putFloat("dCutoff", pidDCutoff);
+    preferences.putInt("lineMode", lineMode);
+    preferences.putInt("lineStream", lineStream);
+    preferences.putInt("lineEst", lineEstimator);
+    preferences.putInt("imuTurns", imuTurns);
+    preferences.putInt("trackLearn", trackLearn);
+    preferences.putFloat("trackLat", trackLatAccel);
     
     preferences.putInt("objFilter", objectFilterSize);
     preferences.putFloat("objScale", objectLengthScale);
@@ -154,11 +188,27 @@ void ParameterManager::save() {
     preferences.putFloat("encKd", encKd);
     preferences.putFloat("turn90", turn90Dist);
     
+    preferences.putInt("velMode", velocityMode);
+    preferences.putFloat("velKp", velKp);
+    preferences.putFloat("velKi", velKi);
+    preferences.putFloat("velKff", velKff);
+    preferences.putFloat("moveAcc", moveAccel);
+    preferences.putFloat("moveJerk", moveJerk);
+    
     // 保存传感器权重
     for (int i = 0; i < 8; i++) {
         String key = "w" + String(i);
         preferences.putInt(key.c_str(), sensorWeights[i]);
     }
+    
+    // 保存循迹校准
+    for (int i = 0; i < 8; i++) {
+        preferences.putInt(("cmin" + String(i)).c_str(), lineCalMin[i]);
+        preferences.putInt(("cmax" + String(i)).c_str(), lineCalMax[i]);
+    }
+    
+    // 增益调度表整体存为一个二进制块 (尺寸变化即视为无效)
+    preferences.putBytes("gainTab", &gainSchedule, sizeof(gainSchedule));
 
     Serial.println("Parameters saved!");
 }
@@ -172,6 +222,13 @@ void ParameterManager::load() {
     kiPost = preferences.getFloat("kiPost", KI_LINE);
     kdPost = preferences.getFloat("kdPost", KD_LINE);
     
+    // 旧固件保存的Kp/Kd按10ms差分整定, 放到微秒时基PID上会严重过阻尼; 不静默覆盖, 由网页提示后确认
+    pidGainsOutdated = preferences.isKey("kp") && preferences.getInt("pidVer", 1) < PID_GAIN_VERSION;
+    if (pidGainsOutdated) {
+        Serial.printf("⚠ PID gains saved by older firmware (Kp=%.3f Kd=%.3f), kept; defaults are Kp=%.3f Kd=%.3f, "
+                      "reset them from the web page\n", kp, kd, KP_LINE, KD_LINE);
+    }
+    
     speedSlow = preferences.getInt("speedSlow", SPEED_SLOW);
     speedNormal = preferences.getInt("speedNormal", SPEED_NORMAL);
     speedFast = preferences.getInt("speedFast", SPEED_FAST);
@@ -195,6 +252,9 @@ void ParameterManager::load() {
     avoidTurn2Dist = preferences.getFloat("avoidTurn2", 118.0);
     avoidTurn3Dist = preferences.getFloat("avoidTurn3", 118.0);
     avoidSearchDist = preferences.getInt("avoidSearch", 800);
+    avoidMode = preferences.getInt("avoidMode", AVOID_MODE_DEFAULT);
+    avoidRadius = preferences.getInt("avoidRadius", AVOID_RADIUS_MM);
+    avoidMargin = preferences.getInt("avoidMargin", AVOID_MARGIN_MM);
     
     avoidS1_L = preferences.getFloat("avS1L", 1.0); avoidS1_R = preferences.getFloat("avS1R", 1.0);
     avoidS2_L = preferences.getFloat("avS2L", 1.0); avoidS2_R = preferences.getFloat("avS2R", 1.0);
@@ -214,9 +274,13 @@ void ParameterManager::load() {
     
     pidIntegralRange = preferences.getInt("pidIntRange", PID_INTEGRAL_RANGE);
     motorDeadband = preferences.getInt("deadband", MOTOR_DEADBAND);
-    pidSmallErrorThres = preferences.getInt("smallErr", PID_SMALL_ERROR_THRES);
-    pidKpSmallScale = preferences.getFloat("kpScale", PID_KP_SMALL_SCALE);
-    pidKdSmallScale = preferences.getFloat("kdScale", PID_KD_SMALL_SCALE);
+    pidDCutoff = preferences.getFloat("dCutoff", PID_D_CUTOFF_HZ);
+    lineMode = preferences.getInt("lineMode", LINE_MODE_DEFAULT);
+    lineStream = preferences.getInt("lineStream", LINE_STREAM_DEFAULT);
+    lineEstimator = preferences.getInt("lineEst", LINE_EST_DEFAULT);
+    imuTurns = preferences.getInt("imuTurns", IMU_TURNS_DEFAULT);
+    trackLearn = preferences.getInt("trackLearn", TRACK_LEARN_DEFAULT);
+    trackLatAccel = preferences.getFloat("trackLat", TRACK_LAT_ACCEL);
     
     objectFilterSize = preferences.getInt("objFilter", 5);
     objectLengthScale = preferences.getFloat("objScale", OBJECT_LENGTH_SCALE);
@@ -228,17 +292,47 @@ void ParameterManager::load() {
     encKd = preferences.getFloat("encKd", 0.0);
     turn90Dist = preferences.getFloat("turn90", 118.0);
     
+    velocityMode = preferences.getInt("velMode", VELOCITY_MODE_DEFAULT);
+    velKp = preferences.getFloat("velKp", VELOCITY_KP);
+    velKi = preferences.getFloat("velKi", VELOCITY_KI);
+    velKff = preferences.getFloat("velKff", VELOCITY_KFF);
+    moveAccel = preferences.getFloat("moveAcc", MOTION_ACCEL_DEFAULT);
+    moveJerk = preferences.getFloat("moveJerk", MOTION_JERK_DEFAULT);
+    
     // 加载传感器权重
     int16_t defaultWeights[] = {-1000, -700, -400, -100, 100, 400, 700, 1000};
     for (int i = 0; i < 8; i++) {
         String key = "w" + String(i);
         sensorWeights[i] = preferences.getInt(key.c_str(), defaultWeights[i]);
     }
+    
+    // 加载循迹校准
+    for (int i = 0; i < 8; i++) {
+        lineCalMin[i] = preferences.getInt(("cmin" + String(i)).c_str(), 0);
+        lineCalMax[i] = preferences.getInt(("cmax" + String(i)).c_str(), 0);
+    }
+    lineCalRevision++;
+    
+    // 加载增益调度表; 没有时由旧版"直线缩放"参数生成
+    if (preferences.getBytesLength("gainTab") != sizeof(gainSchedule) ||
+        preferences.getBytes("gainTab", &gainSchedule, sizeof(gainSchedule)) != sizeof(gainSchedule) ||
+        !gainSchedule.isValid()) {
+        gainSchedule.setDefaults();
+        if (preferences.isKey("smallErr")) {
+            gainSchedule.setStraightScale(preferences.getInt("smallErr", PID_SMALL_ERROR_THRES),
+                                          preferences.getFloat("kpScale", PID_KP_SMALL_SCALE),
+                                          preferences.getFloat("kdScale", PID_KD_SMALL_SCALE));
+        }
+    }
+    gainRevision++;
 
     // 安全检查：防止非法参数导致电机不转
     if (motorLeftCalib < 0.1 || motorLeftCalib > 2.0) motorLeftCalib = 1.0;
     if (motorRightCalib < 0.1 || motorRightCalib > 2.0) motorRightCalib = 1.0;
     if (motorDeadband < 0 || motorDeadband > 100) motorDeadband = 30;
+    if (moveAccel < 100) moveAccel = MOTION_ACCEL_DEFAULT;
+    if (moveJerk < 1000) moveJerk = MOTION_JERK_DEFAULT;
+    if (trackLatAccel < 100) trackLatAccel = TRACK_LAT_ACCEL;
     
     // 检查避障系数
     if (avoidS1_L < 0.1) avoidS1_L = 1.0; if (avoidS1_R < 0.1) avoidS1_R = 1.0;
@@ -262,6 +356,7 @@ void ParameterManager::reset() {
     kpPost = KP_LINE;
     kiPost = KI_LINE;
     kdPost = KD_LINE;
+    pidGainsOutdated = false;
     
     speedSlow = SPEED_SLOW;
     speedNormal = SPEED_NORMAL;
@@ -286,6 +381,9 @@ void ParameterManager::reset() {
     avoidTurn2Dist = 118.0;
     avoidTurn3Dist = 118.0;
     avoidSearchDist = 800;
+    avoidMode = AVOID_MODE_DEFAULT;
+    avoidRadius = AVOID_RADIUS_MM;
+    avoidMargin = AVOID_MARGIN_MM;
     
     parkingDistSlow = 60;
     parkingDistVerySlow = 30;
@@ -298,9 +396,13 @@ void ParameterManager::reset() {
     
     pidIntegralRange = PID_INTEGRAL_RANGE;
     motorDeadband = MOTOR_DEADBAND;
-    pidSmallErrorThres = PID_SMALL_ERROR_THRES;
-    pidKpSmallScale = PID_KP_SMALL_SCALE;
-    pidKdSmallScale = PID_KD_SMALL_SCALE;
+    pidDCutoff = PID_D_CUTOFF_HZ;
+    lineMode = LINE_MODE_DEFAULT;
+    lineStream = LINE_STREAM_DEFAULT;
+    lineEstimator = LINE_EST_DEFAULT;
+    imuTurns = IMU_TURNS_DEFAULT;
+    trackLearn = TRACK_LEARN_DEFAULT;
+    trackLatAccel = TRACK_LAT_ACCEL;
     
     objectFilterSize = 5;
     objectLengthScale = OBJECT_LENGTH_SCALE;
@@ -311,6 +413,13 @@ void ParameterManager::reset() {
     encKi = 0.0;
     encKd = 0.0;
     turn90Dist = 118.0;
+    
+    velocityMode = VELOCITY_MODE_DEFAULT;
+    velKp = VELOCITY_KP;
+    velKi = VELOCITY_KI;
+    velKff = VELOCITY_KFF;
+    moveAccel = MOTION_ACCEL_DEFAULT;
+    moveJerk = MOTION_JERK_DEFAULT;
 
     // 避障步骤系数默认值
     avoidS1_L = 1.0; avoidS1_R = 1.0;
@@ -329,11 +438,27 @@ void ParameterManager::reset() {
     sensorWeights[5] = 400;
     sensorWeights[6] = 700;
     sensorWeights[7] = 1000;
+    
+    // 循迹校准 (min=max=0 表示未校准)
+    memset(lineCalMin, 0, sizeof(lineCalMin));
+    memset(lineCalMax, 0, sizeof(lineCalMax));
+    lineCalRevision++;
+    
+    gainSchedule.setDefaults();
+    gainRevision++;
 
     save();
     Serial.println("Parameters reset to default!");
 }
 
+void ParameterManager::resetPidGains() {
+    kp = kpPost = KP_LINE;
+    kd = kdPost = KD_LINE;
+    pidGainsOutdated = false;
+    save();
+    Serial.println("✓ PID Kp/Kd reset to defaults");
+}
+
 String ParameterManager::toJson() {
     JsonDocument doc;
     
@@ -344,6 +469,7 @@ String ParameterManager::toJson() {
     pid["kpPost"] = kpPost;
     pid["kiPost"] = kiPost;
     pid["kdPost"] = kdPost;
+    pid["outdated"] = pidGainsOutdated;
     
     JsonObject speed = doc["speed"].to<JsonObject>();
     speed["slow"] = speedSlow;
@@ -370,6 +496,9 @@ String ParameterManager::toJson() {
     avoid["turn2"] = avoidTurn2Dist;
     avoid["turn3"] = avoidTurn3Dist;
     avoid["search"] = avoidSearchDist;
+    avoid["mode"] = avoidMode;
+    avoid["radius"] = avoidRadius;
+    avoid["margin"] = avoidMargin;
     
     JsonObject avSteps = doc["avoidSteps"].to<JsonObject>();
     avSteps["s1l"] = avoidS1_L; avSteps["s1r"] = avoidS1_R;
@@ -393,9 +522,13 @@ String ParameterManager::toJson() {
     JsonObject adv = doc["advanced"].to<JsonObject>();
     adv["intRange"] = pidIntegralRange;
     adv["deadband"] = motorDeadband;
-    adv["smallErr"] = pidSmallErrorThres;
-    adv["kpScale"] = pidKpSmallScale;
-    adv["kdScale"] = pidKdSmallScale;
+    adv["dCutoff"] = pidDCutoff;
+    adv["lineMode"] = lineMode;
+    adv["lineStream"] = lineStream;
+    adv["lineEst"] = lineEstimator;
+    adv["imuTurns"] = imuTurns;
+    adv["trackLearn"] = trackLearn;
+    adv["trackLat"] = trackLatAccel;
     
     JsonObject obj = doc["object"].to<JsonObject>();
     obj["filter"] = objectFilterSize;
@@ -410,11 +543,46 @@ String ParameterManager::toJson() {
     enc["kd"] = encKd;
     enc["turn90"] = turn90Dist;
     
+    JsonObject vel = doc["velocity"].to<JsonObject>();
+    vel["mode"] = velocityMode;
+    vel["kp"] = velKp;
+    vel["ki"] = velKi;
+    vel["kff"] = velKff;
+    vel["accel"] = moveAccel;
+    vel["jerk"] = moveJerk;
+    
     // 添加传感器权重
     JsonArray w = doc["weights"].to<JsonArray>();
     for (int i = 0; i < 8; i++) {
         w.add(sensorWeights[i]);
     }
+    
+    JsonObject cal = doc["lineCal"].to<JsonObject>();
+    JsonArray calMin = cal["min"].to<JsonArray>();
+    JsonArray calMax = cal["max"].to<JsonArray>();
+    for (int i = 0; i < 8; i++) {
+        calMin.add(lineCalMin[i]);
+        calMax.add(lineCalMax[i]);
+    }
+    
+    // 增益调度表: 每个阶段按 速度断点 × 误差断点 逐行展开, 每格 [kp, ki, kd] 系数
+    JsonObject gains = doc["gains"].to<JsonObject>();
+    JsonArray gainSpeeds = gains["speeds"].to<JsonArray>();
+    JsonArray gainErrors = gains["errors"].to<JsonArray>();
+    for (int s = 0; s < GAIN_SPEED_POINTS; s++) gainSpeeds.add(gainSchedule.speeds[s]);
+    for (int e = 0; e < GAIN_ERROR_POINTS; e++) gainErrors.add(gainSchedule.errors[e]);
+    for (int p = 0; p < GAIN_PHASE_COUNT; p++) {
+        JsonArray cells = gains[gainPhaseName((GainPhase)p)].to<JsonArray>();
+        for (int s = 0; s < GAIN_SPEED_POINTS; s++) {
+            for (int e = 0; e < GAIN_ERROR_POINTS; e++) {
+                const GainScale& c = gainSchedule.scales[p][s][e];
+                JsonArray cell = cells.add<JsonArray>();
+                cell.add(c.kp);
+                cell.add(c.ki);
+                cell.add(c.kd);
+            }
+        }
+    }
 
     String output;
     serializeJson(doc, output);
@@ -422,22 +590,33 @@ String ParameterManager::toJson() {
 }
 
 void ParameterManager::fromJson(String json) {
+    if (applyJson(json)) {
+        save();
+    }
+}
+
+bool ParameterManager::applyJson(String json) {
     JsonDocument doc;
     DeserializationError error = deserializeJson(doc, json);
     
     if (error) {
         Serial.print("JSON parse error: ");
         Serial.println(error.c_str());
-        return;
+        return false;
     }
     
     if (doc["pid"].is<JsonObject>()) {
+        float oldGains[4] = {kp, kd, kpPost, kdPost};
         kp = doc["pid"]["kp"] | kp;
         ki = doc["pid"]["ki"] | ki;
         kd = doc["pid"]["kd"] | kd;
         kpPost = doc["pid"]["kpPost"] | kpPost;
         kiPost = doc["pid"]["kiPost"] | kiPost;
         kdPost = doc["pid"]["kdPost"] | kdPost;
+        // 改过Kp/Kd视为已按新时基重新整定
+        if (kp != oldGains[0] || kd != oldGains[1] || kpPost != oldGains[2] || kdPost != oldGains[3]) {
+            pidGainsOutdated = false;
+        }
     }
     
     if (doc["speed"].is<JsonObject>()) {
@@ -461,6 +640,51 @@ void ParameterManager::fromJson(String json) {
         }
     }
     
+    // 全0表示未校准 (如自动整定输出的参数文件): 保留本机已有的校准
+    if (doc["lineCal"].is<JsonObject>()) {
+        uint16_t calMin[8], calMax[8];
+        bool empty = true;
+        for (int i = 0; i < 8; i++) {
+            calMin[i] = constrain(doc["lineCal"]["min"][i] | (int)lineCalMin[i], 0, LINE_ANALOG_MAX);
+            calMax[i] = constrain(doc["lineCal"]["max"][i] | (int)lineCalMax[i], 0, LINE_ANALOG_MAX);
+            if (calMin[i] != 0 || calMax[i] != 0) empty = false;
+        }
+        if (!empty) {
+            memcpy(lineCalMin, calMin, sizeof(calMin));
+            memcpy(lineCalMax, calMax, sizeof(calMax));
+            lineCalRevision++;
+        }
+    }
+    
+    if (doc["gains"].is<JsonObject>()) {
+        // 先在副本上修改, 断点不升序或系数为负时整表放弃
+        GainSchedule schedule = gainSchedule;
+        for (int s = 0; s < GAIN_SPEED_POINTS; s++) {
+            schedule.speeds[s] = doc["gains"]["speeds"][s] | schedule.speeds[s];
+        }
+        for (int e = 0; e < GAIN_ERROR_POINTS; e++) {
+            schedule.errors[e] = doc["gains"]["errors"][e] | schedule.errors[e];
+        }
+        for (int p = 0; p < GAIN_PHASE_COUNT; p++) {
+            JsonArray cells = doc["gains"][gainPhaseName((GainPhase)p)];
+            for (int s = 0; s < GAIN_SPEED_POINTS; s++) {
+                for (int e = 0; e < GAIN_ERROR_POINTS; e++) {
+                    GainScale& c = schedule.scales[p][s][e];
+                    JsonArray cell = cells[s * GAIN_ERROR_POINTS + e];
+                    c.kp = cell[0] | c.kp;
+                    c.ki = cell[1] | c.ki;
+                    c.kd = cell[2] | c.kd;
+                }
+            }
+        }
+        if (schedule.isValid()) {
+            gainSchedule = schedule;
+            gainRevision++;
+        } else {
+            Serial.println("⚠ Gain schedule rejected: breakpoints must increase, scales must be >= 0");
+        }
+    }
+    
     if (doc["avoid"].is<JsonObject>()) {
         avoidTurnDist = doc["avoid"]["turn"] | avoidTurnDist;
         avoidForwardDist = doc["avoid"]["forward"] | avoidForwardDist;
@@ -473,6 +697,9 @@ void ParameterManager::fromJson(String json) {
         avoidTurn2Dist = doc["avoid"]["turn2"] | avoidTurn2Dist;
         avoidTurn3Dist = doc["avoid"]["turn3"] | avoidTurn3Dist;
         avoidSearchDist = doc["avoid"]["search"] | avoidSearchDist;
+        avoidMode = constrain(doc["avoid"]["mode"] | avoidMode, 0, 1);
+        avoidRadius = constrain(doc["avoid"]["radius"] | avoidRadius, AVOID_ARC_MIN_RADIUS_MM, 1000);
+        avoidMargin = constrain(doc["avoid"]["margin"] | avoidMargin, 0, 300);
     }
     
     if (doc["avoidSteps"].is<JsonObject>()) {
@@ -506,9 +733,21 @@ void ParameterManager::fromJson(String json) {
     if (doc["advanced"].is<JsonObject>()) {
         pidIntegralRange = doc["advanced"]["intRange"] | pidIntegralRange;
         motorDeadband = doc["advanced"]["deadband"] | motorDeadband;
-        pidSmallErrorThres = doc["advanced"]["smallErr"] | pidSmallErrorThres;
-        pidKpSmallScale = doc["advanced"]["kpScale"] | pidKpSmallScale;
-        pidKdSmallScale = doc["advanced"]["kdScale"] | pidKdSmallScale;
+        // 旧版"直线缩放"参数 (旧参数文件/自动整定): 转换为测距前/后两张表的误差轴
+        if (!doc["advanced"]["smallErr"].isNull() || !doc["advanced"]["kpScale"].isNull() ||
+            !doc["advanced"]["kdScale"].isNull()) {
+            gainSchedule.setStraightScale(doc["advanced"]["smallErr"] | PID_SMALL_ERROR_THRES,
+                                          doc["advanced"]["kpScale"] | PID_KP_SMALL_SCALE,
+                                          doc["advanced"]["kdScale"] | PID_KD_SMALL_SCALE);
+            gainRevision++;
+        }
+        pidDCutoff = constrain(doc["advanced"]["dCutoff"] | pidDCutoff, 0.0f, 250.0f);
+        lineMode = constrain(doc["advanced"]["lineMode"] | lineMode, 0, 2);
+        lineStream = constrain(doc["advanced"]["lineStream"] | lineStream, 0, 1);
+        lineEstimator = constrain(doc["advanced"]["lineEst"] | lineEstimator, 0, 1);
+        imuTurns = constrain(doc["advanced"]["imuTurns"] | imuTurns, 0, 1);
+        trackLearn = constrain(doc["advanced"]["trackLearn"] | trackLearn, 0, 1);
+        trackLatAccel = constrain(doc["advanced"]["trackLat"] | trackLatAccel, 100.0f, 10000.0f);
     }
     
     if (doc["object"].is<JsonObject>()) {
@@ -525,8 +764,17 @@ void ParameterManager::fromJson(String json) {
         encKd = doc["encoder"]["kd"] | encKd;
         turn90Dist = doc["encoder"]["turn90"] | turn90Dist;
     }
+    
+    if (doc["velocity"].is<JsonObject>()) {
+        velocityMode = constrain(doc["velocity"]["mode"] | velocityMode, 0, 1);
+        velKp = doc["velocity"]["kp"] | velKp;
+        velKi = doc["velocity"]["ki"] | velKi;
+        velKff = doc["velocity"]["kff"] | velKff;
+        moveAccel = constrain(doc["velocity"]["accel"] | moveAccel, 100.0f, 10000.0f);
+        moveJerk = constrain(doc["velocity"]["jerk"] | moveJerk, 1000.0f, 200000.0f);
+    }
 
-    save();
+    return true;
 }
 
 // POWERED BY DDG
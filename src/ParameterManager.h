@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <Preferences.h>
 #include "config.h"
+#include "GainScheduler.h"
 
 class ParameterManager {
 public:
@@ -15,6 +16,8 @@ public:
     
     // PID参数 (Phase 2: After Measurement)
     float kpPost, kiPost, kdPost;
+    // NVS中的Kp/Kd由旧版时基保存 (pidVer < PID_GAIN_VERSION): 保留原值, 在网页提示, 由用户确认恢复默认
+    bool pidGainsOutdated;
     
     // 速度参数 (Phase 1)
     int speedSlow;
@@ -43,6 +46,9 @@ public:
     float avoidTurn2Dist;  // 避障第3步右转行程
     float avoidTurn3Dist;  // 避障第5步右转行程
     int avoidSearchDist;   // 避障第6步直行搜索最大距离
+    int avoidMode;         // 0=分步, 1=圆弧路径
+    int avoidRadius;       // 圆弧绕行期望转弯半径 (mm)
+    int avoidMargin;       // 圆弧绕行与障碍物的余量 (mm)
     
     // 避障步骤速度系数 (Step 1-6)
     // S1: 左转, S2: 直行Out, S3: 右转1, S4: 直行Parallel, S5: 右转2, S6: 直行In
@@ -67,9 +73,13 @@ public:
     // 高级PID参数
     int pidIntegralRange;      // 积分分离阈值
     int motorDeadband;         // 电机死区
-    int pidSmallErrorThres;    // 直线判定阈值
-    float pidKpSmallScale;     // 直线Kp缩放
-    float pidKdSmallScale;     // 直线Kd缩放
+    float pidDCutoff;          // 微分低通截止频率 (Hz, 0=不滤波)
+    int lineMode;              // 循迹采集: 0=数字, 1=模拟量质心, 2=模拟量二次插值
+    int lineStream;            // 循迹传输: 0=请求/应答, 1=模块连续输出
+    int lineEstimator;         // PID微分: 0=位置差分, 1=线状态估计的横向速度
+    int imuTurns;              // 原地转向判定: 0=单轮行程, 1=陀螺仪航向 (陀螺仪不可用时仍按行程)
+    int trackLearn;            // 赛道学习: 0=按线位置调速, 1=第一圈录制地图, 之后按速度曲线调速
+    float trackLatAccel;       // 速度曲线的弯道横向加速度上限 (mm/s²)
     
     // 物体测量参数
     int objectFilterSize;      // 滤波窗口大小
@@ -81,17 +91,33 @@ public:
     float encKp, encKi, encKd; // 编码器直线保持PID
     float turn90Dist;          // 90度转向对应的单轮行程(mm)
     
+    // 轮速闭环 (循迹/前进任务按 mm/s 指令轮速)
+    int velocityMode;          // 0=开环PWM, 1=轮速闭环
+    float velKp, velKi, velKff;
+    float moveAccel, moveJerk;  // 离散动作速度曲线的加速度 (mm/s²) / 加加速度 (mm/s³) 限幅
+    
     // 传感器权重
     int16_t sensorWeights[8];
+    
+    // 循迹逐路校准 (模拟量最小/最大值, 全0表示未校准)
+    uint16_t lineCalMin[8];
+    uint16_t lineCalMax[8];
+    uint32_t lineCalRevision;  // 校准值每次加载/导入/恢复默认后+1, 控制任务据此重新下发 (不保存)
+
+    // 循迹PID增益调度表 (阶段 × 轮速 × 误差 的系数网格)
+    GainSchedule gainSchedule;
+    uint32_t gainRevision;     // 调度表每次加载/修改后+1, 调度器据此重算 (不保存)
 
     // 保存和加载
     void save();
     void load();
     void reset();  // 恢复默认值
+    void resetPidGains();  // 只把循迹Kp/Kd恢复默认并保存 (旧版增益提示中的"恢复默认")
     
     // 获取JSON字符串
     String toJson();
     void fromJson(String json);
+    bool applyJson(String json);   // 只更新字段不保存 (解析失败返回false), fromJson = applyJson + save
 
 private:
     Preferences preferences;
@@ -0,0 +1,132 @@
+#include "Profiler.h"
+#include <ArduinoJson.h>
+
+static const char* stageNames[PERF_STAGE_COUNT] = {
+    "cycle", "lineSensor", "sensors", "motor", "objectDetector",
+    "taskManager", "telemetry", "stateMachine", "display"
+};
+
+Profiler::Profiler() {
+    overruns = 0;
+#ifdef ARDUINO_ARCH_ESP32
+    cyclesPerUs = 240;
+#else
+    cyclesPerUs = 1000;
+#endif
+    for (int i = 0; i < PERF_STAGE_COUNT; i++) {
+        stats[i].deadlineUs = 0;
+        resetPending[i] = false;
+        clearStage((PerfStage)i);
+    }
+}
+
+void Profiler::setDeadline(PerfStage stage, uint32_t us) {
+    stats[stage].deadlineUs = us;
+}
+
+void Profiler::clearStage(PerfStage stage) {
+    PerfStats& s = stats[stage];
+    s.count = 0;
+    s.minUs = UINT32_MAX;
+    s.maxUs = 0;
+    s.sumUs = 0;
+    s.deadlineMisses = 0;
+    memset(s.histogram, 0, sizeof(s.histogram));
+}
+
+void Profiler::requestReset() {
+    for (int i = 0; i < PERF_STAGE_COUNT; i++) {
+        resetPending[i] = true;
+    }
+}
+
+// 写入方执行挂起的清零; overruns 与完整周期由同一个任务写入, 随 PERF_CYCLE 清零
+void Profiler::applyPendingReset(PerfStage stage) {
+    if (resetPending[stage]) {
+        clearStage(stage);
+        if (stage == PERF_CYCLE) {
+            overruns = 0;
+        }
+        resetPending[stage] = false;
+    }
+}
+
+void Profiler::recordOverrun(uint32_t missedTicks) {
+    applyPendingReset(PERF_CYCLE);
+    overruns += missedTicks;
+}
+
+// 对数-线性分桶: [0,8)us 每1us一桶, 之后每个2倍区间均分为8桶
+int Profiler::bucketIndex(uint32_t us) {
+    if (us < PERF_HIST_SUB) return us;
+    int octave = 31 - __builtin_clz(us) - 2;   // us >= 8 时 octave >= 1
+    if (octave > PERF_HIST_OCTAVES) return PERF_HIST_BUCKETS - 1;
+    int sub = (us >> (octave - 1)) & (PERF_HIST_SUB - 1);
+    return octave * PERF_HIST_SUB + sub;
+}
+
+uint32_t Profiler::bucketUpperUs(int index) {
+    if (index < PERF_HIST_SUB) return index + 1;
+    int octave = index / PERF_HIST_SUB;
+    int sub = index % PERF_HIST_SUB;
+    return (uint32_t)(PERF_HIST_SUB + sub + 1) << (octave - 1);
+}
+
+void Profiler::record(PerfStage stage, uint32_t cycles) {
+    applyPendingReset(stage);
+    
+    uint32_t us = cycles / cyclesPerUs;
+    PerfStats& s = stats[stage];
+    s.count++;
+    s.sumUs += us;
+    if (us < s.minUs) s.minUs = us;
+    if (us > s.maxUs) s.maxUs = us;
+    if (s.deadlineUs > 0 && us > s.deadlineUs) s.deadlineMisses++;
+    
+    uint32_t& bucket = s.histogram[bucketIndex(us)];
+    if (bucket < UINT32_MAX) bucket++;
+}
+
+uint32_t Profiler::percentileUs(const PerfStats& s, float fraction) {
+    uint32_t total = 0;
+    for (int i = 0; i < PERF_HIST_BUCKETS; i++) total += s.histogram[i];
+    if (total == 0) return 0;
+    
+    uint32_t target = (uint32_t)(total * fraction);
+    uint32_t cumulative = 0;
+    for (int i = 0; i < PERF_HIST_BUCKETS; i++) {
+        cumulative += s.histogram[i];
+        if (cumulative > target) {
+            return min(bucketUpperUs(i), s.maxUs);
+        }
+    }
+    return s.maxUs;
+}
+
+String Profiler::toJson() {
+#ifdef ARDUINO_ARCH_ESP32
+    cyclesPerUs = getCpuFrequencyMhz();
+#endif
+    
+    JsonDocument doc;
+    doc["cpuMHz"] = cyclesPerUs;
+    doc["overruns"] = overruns;
+    
+    JsonObject stages = doc["stages"].to<JsonObject>();
+    for (int i = 0; i < PERF_STAGE_COUNT; i++) {
+        const PerfStats& s = stats[i];
+        JsonObject st = stages[stageNames[i]].to<JsonObject>();
+        st["count"] = s.count;
+        st["min"] = s.count ? s.minUs : 0;
+        st["avg"] = s.count ? (float)s.sumUs / s.count : 0;
+        st["max"] = s.maxUs;
+        st["p50"] = percentileUs(s, 0.50f);
+        st["p99"] = percentileUs(s, 0.99f);
+        st["deadline"] = s.deadlineUs;
+        st["misses"] = s.deadlineMisses;
+    }
+    
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
@@ -0,0 +1,88 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "config.h"
+#ifndef ARDUINO_ARCH_ESP32
+#include <chrono>
+#endif
+
+// 被测阶段
+enum PerfStage {
+    PERF_CYCLE,            // 完整控制周期
+    PERF_LINE_SENSOR,      // lineSensor.update()
+    PERF_SENSORS,          // sensors.update()
+    PERF_MOTOR,            // motor.update()
+    PERF_OBJECT_DETECTOR,  // objectDetector.update()
+    PERF_TASK_MANAGER,     // taskManager.update()
+    PERF_TELEMETRY,        // 遥测采集 (原 getSystemStatus)
+    PERF_STATE_MACHINE,    // 状态机
+    PERF_DISPLAY,          // OLED绘制 (显示任务)
+    PERF_STAGE_COUNT
+};
+
+// 直方图: 按微秒对数分桶, 每个2倍区间8个子桶, 覆盖 0 ~ 2^PERF_HIST_OCTAVES us
+#define PERF_HIST_SUB        8
+#define PERF_HIST_OCTAVES    20
+#define PERF_HIST_BUCKETS    (PERF_HIST_SUB * (PERF_HIST_OCTAVES + 1))
+
+struct PerfStats {
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+    uint32_t deadlineUs;       // 0 表示不检查
+    uint32_t deadlineMisses;
+    uint32_t histogram[PERF_HIST_BUCKETS];  // 500Hz下约99天才饱和 (16位时约131s就饱和, 百分位失真)
+};
+
+// 轻量级周期计数器剖析器
+// 每个阶段只由一个任务写入; Web任务读取时允许看到轻微不一致的快照
+class Profiler {
+public:
+    Profiler();
+    
+    void setDeadline(PerfStage stage, uint32_t us);
+    void record(PerfStage stage, uint32_t cycles);
+    void recordOverrun(uint32_t missedTicks);   // 与 PERF_CYCLE 同在控制任务中调用
+    void requestReset();   // 由写入方在下次记录时清零 (overruns 随 PERF_CYCLE 一起), 避免与写入竞争
+    
+    String toJson();
+    uint32_t getCyclesPerUs() { return cyclesPerUs; }
+    
+#ifdef ARDUINO_ARCH_ESP32
+    static inline uint32_t now() { return ESP.getCycleCount(); }
+#else
+    // 主机构建: 以纳秒计 (虚拟时钟不反映真实耗时, 这里用墙钟)
+    static inline uint32_t now() {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+#endif
+
+private:
+    PerfStats stats[PERF_STAGE_COUNT];
+    volatile bool resetPending[PERF_STAGE_COUNT];
+    volatile uint32_t overruns;
+    uint32_t cyclesPerUs;
+    
+    void clearStage(PerfStage stage);
+    void applyPendingReset(PerfStage stage);
+    static int bucketIndex(uint32_t us);
+    static uint32_t bucketUpperUs(int index);
+    uint32_t percentileUs(const PerfStats& s, float fraction);
+};
+
+// 作用域计时器: 构造时取周期计数, 析构时记录
+class PerfScope {
+public:
+    PerfScope(Profiler& profiler, PerfStage stage) : profiler(profiler), stage(stage), start(Profiler::now()) {}
+    ~PerfScope() { profiler.record(stage, Profiler::now() - start); }
+
+private:
+    Profiler& profiler;
+    PerfStage stage;
+    uint32_t start;
+};
+
+#endif
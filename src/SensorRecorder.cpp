@@ -0,0 +1,69 @@
+#include "SensorRecorder.h"
+
+SensorRecorder::SensorRecorder(size_t capacity) {
+    this->capacity = capacity;
+    records = nullptr;
+    recording = false;
+    memset(&header, 0, sizeof(header));
+}
+
+bool SensorRecorder::begin() {
+    if (records) return true;
+    size_t bytes = capacity * sizeof(SensorRecord);
+#ifdef ARDUINO_ARCH_ESP32
+    records = (SensorRecord*)(psramFound() ? ps_malloc(bytes) : malloc(bytes));
+#else
+    records = (SensorRecord*)malloc(bytes);
+#endif
+    if (!records) {
+        Serial.printf("⚠ Sensor recorder: cannot allocate %u bytes\n", (unsigned)bytes);
+        capacity = 0;
+        return false;
+    }
+    Serial.printf("✓ Sensor recorder: %u records (%u KB)\n", (unsigned)capacity, (unsigned)(bytes / 1024));
+    return true;
+}
+
+void SensorRecorder::start(const SensorRecordingHeader& config) {
+    header = config;
+    header.magic = SENSOR_REC_MAGIC;
+    header.version = SENSOR_REC_VERSION;
+    header.recordSize = sizeof(SensorRecord);
+    header.count = 0;
+    header.dropped = 0;
+    recording = records != nullptr;
+}
+
+void SensorRecorder::record(const SensorRecord& rec) {
+    if (!recording) return;
+    if (header.count >= capacity) {
+        header.dropped++;
+        return;
+    }
+    records[header.count++] = rec;
+}
+
+void SensorRecorder::stop() {
+    recording = false;
+}
+
+size_t SensorRecorder::read(size_t offset, uint8_t* buf, size_t len) {
+    if (recording) return 0;
+
+    size_t total = getSize();
+    if (offset >= total) return 0;
+    if (len > total - offset) len = total - offset;
+
+    size_t copied = 0;
+    if (offset < sizeof(header)) {
+        size_t n = min(len, sizeof(header) - offset);
+        memcpy(buf, (const uint8_t*)&header + offset, n);
+        copied = n;
+    }
+    if (copied < len) {
+        size_t recordOffset = offset + copied - sizeof(header);
+        memcpy(buf + copied, (const uint8_t*)records + recordOffset, len - copied);
+        copied = len;
+    }
+    return copied;
+}
@@ -0,0 +1,77 @@
+#ifndef SENSOR_RECORDER_H
+#define SENSOR_RECORDER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ==================== 录制格式 (SREC) ====================
+// 文件 = SensorRecordingHeader + count 条 SensorRecord, 小端, 无填充
+// 时间均相对检测开始, 回放时重新对齐到回放检测器的开始时刻
+
+#define SENSOR_REC_MAGIC     0x43455253   // "SREC"
+#define SENSOR_REC_VERSION   1
+
+enum SensorRecordFlags {
+    REC_LASER = 1 << 0,   // 一个激光采样 (raw/filtered 有效, 时间为采样时刻)
+    REC_CYCLE = 1 << 1    // 一次 ObjectDetector::update() 调用 (本周期的激光采样紧排在它之前)
+};
+
+struct __attribute__((packed)) SensorRecordingHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t count;
+    uint32_t dropped;             // 缓冲区满后丢弃的条数
+    uint32_t startMs;             // 检测开始时刻 (录制设备的 millis, 仅供参考)
+    uint16_t threshold;           // 检测配置 (回放默认沿用)
+    uint8_t filterSize;
+    uint8_t stableCount;
+    uint32_t timeoutMs;
+    float lengthScale;
+    float lengthOffset;
+    float deviationCorrection;
+    float mmPerPulse;             // 录制固件的编码器换算
+};
+
+struct __attribute__((packed)) SensorRecord {
+    uint32_t timeUs;              // 相对检测开始
+    int32_t encLeft;              // 编码器计数
+    int32_t encRight;
+    uint16_t laserRaw;            // mm
+    uint16_t laserFiltered;       // mm
+    int16_t linePosition;
+    uint8_t flags;                // SensorRecordFlags
+    uint8_t reserved;
+};
+
+// 物块检测录制器: 控制任务在检测期间写入, 检测结束后由Web任务整体下载
+// 缓冲区在 begin() 时一次性分配 (优先PSRAM), 录制过程不分配内存
+class SensorRecorder {
+public:
+    SensorRecorder(size_t capacity = SENSOR_REC_CAPACITY);
+    bool begin();
+
+    // 由 ObjectDetector 调用
+    void start(const SensorRecordingHeader& config);
+    void record(const SensorRecord& rec);
+    void stop();
+
+    bool isRecording() { return recording; }
+    bool hasData() { return !recording && header.count > 0; }
+    uint32_t getCount() { return header.count; }
+    uint32_t getDropped() { return header.dropped; }
+    size_t getSize() { return sizeof(SensorRecordingHeader) + (size_t)header.count * sizeof(SensorRecord); }
+    const SensorRecordingHeader& getHeader() { return header; }
+    const SensorRecord* getRecords() { return records; }
+
+    // 按字节偏移读取完整文件 (头 + 记录), 供分块下载; 录制中返回0
+    size_t read(size_t offset, uint8_t* buf, size_t len);
+
+private:
+    SensorRecord* records;
+    size_t capacity;
+    SensorRecordingHeader header;
+    volatile bool recording;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "SensorReplay.h"
+
+SensorReplay::SensorReplay() : motor(&pwm, &leftEncoder, &rightEncoder), detector(&laser, &motor) {
+    records = nullptr;
+    memset(&header, 0, sizeof(header));
+    error = "not loaded";
+}
+
+bool SensorReplay::load(const uint8_t* data, size_t size) {
+    records = nullptr;
+    if (size < sizeof(SensorRecordingHeader)) {
+        error = "file too short";
+        return false;
+    }
+    SensorRecordingHeader fileHeader;
+    memcpy(&fileHeader, data, sizeof(fileHeader));
+    if (fileHeader.magic == SENSOR_REC_MAGIC && fileHeader.recordSize == sizeof(SensorRecord) &&
+        size < sizeof(fileHeader) + (size_t)fileHeader.count * sizeof(SensorRecord)) {
+        error = "truncated";
+        return false;
+    }
+    // 记录区紧跟在头后面, 不保证对齐 (SensorRecord 为 packed, 逐字段访问安全)
+    return load(fileHeader, (const SensorRecord*)(data + sizeof(fileHeader)));
+}
+
+bool SensorReplay::load(const SensorRecordingHeader& header, const SensorRecord* records) {
+    this->records = nullptr;
+    this->header = header;
+    if (header.magic != SENSOR_REC_MAGIC) {
+        error = "bad magic";
+        return false;
+    }
+    if (header.version != SENSOR_REC_VERSION || header.recordSize != sizeof(SensorRecord)) {
+        error = "unsupported version";
+        return false;
+    }
+    if (fabsf(header.mmPerPulse - (float)MM_PER_PULSE) > 1e-4f) {
+        error = "encoder scale differs from this build";
+        return false;
+    }
+    if (!records || header.count == 0) {
+        error = "empty recording";
+        return false;
+    }
+    this->records = records;
+    error = nullptr;
+    return true;
+}
+
+ReplayConfig SensorReplay::getConfig() {
+    ReplayConfig config;
+    config.threshold = header.threshold;
+    config.filterSize = header.filterSize;
+    config.stableCount = header.stableCount;
+    config.lengthScale = header.lengthScale;
+    config.lengthOffset = header.lengthOffset;
+    config.deviationCorrection = header.deviationCorrection;
+    return config;
+}
+
+ObjectMeasurement SensorReplay::run(const ReplayConfig& config) {
+    ObjectMeasurement empty;
+    memset(&empty, 0, sizeof(empty));
+    if (!records) return empty;
+
+    detector.setFilterSize(config.filterSize);
+    detector.setStableCount(config.stableCount);
+    detector.setTimeout(header.timeoutMs);
+    detector.setCorrection(config.lengthScale, config.lengthOffset);
+    detector.setDeviationCorrection(config.deviationCorrection);
+    detector.startDetection(0, config.threshold);
+
+    // 录制时间相对检测开始, 对齐到本次 startDetection 的时刻
+    unsigned long baseMs = detector.getStartTime();
+    uint32_t baseUs = (uint32_t)baseMs * 1000;
+
+    for (uint32_t i = 0; i < header.count && detector.isDetecting(); i++) {
+        const SensorRecord& rec = records[i];
+        if (rec.flags & REC_LASER) {
+            LaserSample sample;
+            sample.timestampUs = baseUs + rec.timeUs;
+            sample.raw = rec.laserRaw;
+            sample.filtered = rec.laserFiltered;
+            laser.push(sample);
+        }
+        if (rec.flags & REC_CYCLE) {
+            leftEncoder.count = rec.encLeft;
+            rightEncoder.count = rec.encRight;
+            detector.update(rec.linePosition, baseMs + rec.timeUs / 1000);
+        }
+    }
+
+    // 录制在检测结束前被截断 (缓冲区满/手动停止): 按停止处理
+    if (detector.isDetecting()) {
+        detector.stopDetection();
+    }
+    return detector.getResult();
+}
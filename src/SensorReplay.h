@@ -0,0 +1,69 @@
+#ifndef SENSOR_REPLAY_H
+#define SENSOR_REPLAY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "hal/Hal.h"
+#include "LaserSample.h"
+#include "MotorControl.h"
+#include "ObjectDetector.h"
+#include "SensorRecorder.h"
+
+// 回放用外设: 编码器计数由录制数据设置, PWM输出丢弃
+class ReplayEncoder : public HalEncoder {
+public:
+    void attach(int pinA, int pinB) override {}
+    int64_t getCount() override { return count; }
+    void clearCount() override { count = 0; }
+    int64_t count = 0;
+};
+
+class ReplayPwm : public HalPwm {
+public:
+    void setup(uint8_t channel, uint8_t pin, uint32_t freq, uint8_t resolution) override {}
+    void write(uint8_t channel, uint32_t duty) override {}
+};
+
+// 检测参数 (默认取自录制头, A/B 对比时覆盖其中一部分)
+struct ReplayConfig {
+    uint16_t threshold;
+    int filterSize;
+    int stableCount;
+    float lengthScale;
+    float lengthOffset;
+    float deviationCorrection;
+};
+
+// 把一段 SREC 录制逐周期送入独立的 ObjectDetector, 结果只取决于录制数据与参数
+// 板上 (Web接口) 与主机 (tools/replay) 使用同一份代码
+class SensorReplay {
+public:
+    SensorReplay();
+
+    // 校验录制头, 成功后 getConfig() 返回录制时的检测参数
+    bool load(const uint8_t* data, size_t size);                              // SREC 文件
+    bool load(const SensorRecordingHeader& header, const SensorRecord* records); // 板上录制缓冲区
+    const char* getError() { return error; }
+    const SensorRecordingHeader& getHeader() { return header; }
+    ReplayConfig getConfig();
+
+    ObjectMeasurement run(const ReplayConfig& config);
+    ObjectMeasurement run() { return run(getConfig()); }
+    DetectionState getFinalState() { return detector.getState(); }
+
+    void setLogCallback(void (*callback)(String message)) { detector.setLogCallback(callback); }
+
+private:
+    ReplayPwm pwm;
+    ReplayEncoder leftEncoder;
+    ReplayEncoder rightEncoder;
+    MotorControl motor;
+    LaserRing laser;
+    ObjectDetector detector;
+
+    const SensorRecord* records;
+    SensorRecordingHeader header;
+    const char* error;
+};
+
+#endif
@@ -1,17 +1,33 @@
 #include "Sensors.h"
 
-Sensors::Sensors() {
+Sensors::Sensors(HalRanger* laser, HalImu* imu, HalGpio* gpio) : gyroPublisher(&gyroRing) {
+    this->laser = laser;
+    this->imu = imu;
+    this->gpio = gpio;
     laserReady = false;
     laserDistance = 0;
     ultrasonicDistance = 0;
+    ultrasonicTimestamp = 0;
     lastUltrasonicTime = 0;
+    echoRiseUs = 0;
+    echoDurationUs = 0;
+    echoSeq = 0;
+    echoRiseSeen = false;
+    lastEchoSeq = 0;
+    echoPending = false;
+    triggerTimeUs = 0;
+    ultrasonicWindowIndex = 0;
+    ultrasonicWindowCount = 0;
     laserErrorCount = 0;
     lastLaserUpdateTime = 0;
+    laserTaskHandle = nullptr;
+    lastLaserPollTime = 0;
+    imuReady = false;
+    lastImuUpdateTime = 0;
 }
 
 void Sensors::begin() {
-    // 初始化I2C1 (激光传感器 VL53L0X)
-    // 注意: BMI160也使用I2C1,但会在IMU::begin()中再次初始化
+    // 初始化I2C1 (激光传感器 VL53L0X + 陀螺仪 BMI160)
     Wire.begin(PIN_I2C1_SDA, PIN_I2C1_SCL);
     Wire.setClock(400000);  // 设置I2C频率为400kHz
     delay(100);
@@ -27,71 +43,117 @@ void Sensors::begin() {
     
     // 初始化VL53L0X
     Serial.println("Initializing VL53L0X...");
-    if (laser.begin(VL53L0X_I2C_ADDR, false, &Wire)) {
+    if (laser->begin()) {
         Serial.println("✓ VL53L0X found, starting continuous mode (20ms)...");
         // 启用连续测量模式，设置20ms采样周期 (默认是30ms)
         // 这会牺牲最大测量距离，但提高响应速度
-        laser.startRangeContinuous(20); 
-        laserReady = true;
+        laserReady = laser->startContinuous(LASER_PERIOD_MS);
         Serial.println("✓ VL53L0X initialized successfully");
     } else {
         Serial.println("✗ VL53L0X init failed!");
         laserReady = false;
     }
+    lastLaserUpdateTime = millis();
+    
+    // 初始化BMI160 (陀螺仪高ODR写入FIFO, 由读取任务整批取走)
+    Serial.println("Initializing BMI160...");
+    imuReady = imu->begin();
+    if (imuReady) {
+        Serial.printf("✓ BMI160 gyro running at %dHz, FIFO enabled\n", IMU_GYRO_ODR_HZ);
+    } else {
+        Serial.println("✗ BMI160 init failed! Heading falls back to encoders");
+    }
+    lastImuUpdateTime = millis();
+    
+    // 启动I2C1读取任务, 之后I2C1只由该任务访问
+    xTaskCreatePinnedToCore(laserTask, "laser", LASER_TASK_STACK, this,
+                            LASER_TASK_PRIORITY, &laserTaskHandle, LASER_TASK_CORE);
+    if (PIN_LASER_INT >= 0) {
+        pinMode(PIN_LASER_INT, INPUT_PULLUP);
+        attachInterruptArg(digitalPinToInterrupt(PIN_LASER_INT), onLaserReady, this, FALLING);
+    }
     
     // 初始化超声波
-    pinMode(PIN_ULTRASONIC_TRIG, OUTPUT);
-    pinMode(PIN_ULTRASONIC_ECHO, INPUT);
-    digitalWrite(PIN_ULTRASONIC_TRIG, LOW);
+    gpio->pinMode(PIN_ULTRASONIC_TRIG, OUTPUT);
+    gpio->pinMode(PIN_ULTRASONIC_ECHO, INPUT);
+    gpio->digitalWrite(PIN_ULTRASONIC_TRIG, LOW);
+    attachInterruptArg(digitalPinToInterrupt(PIN_ULTRASONIC_ECHO), onEchoEdge, this, CHANGE);
     
     // 初始化按键
-    pinMode(PIN_BUTTON, INPUT_PULLUP);
+    gpio->pinMode(PIN_BUTTON, INPUT_PULLUP);
     
     // 初始化声光报警
-    pinMode(PIN_ALARM, OUTPUT);
-    digitalWrite(PIN_ALARM, LOW);
+    gpio->pinMode(PIN_ALARM, OUTPUT);
+    gpio->digitalWrite(PIN_ALARM, LOW);
 }
 
-void Sensors::update() {
+// VL53L0X数据就绪中断
+void IRAM_ATTR Sensors::onLaserReady(void* arg) {
+    Sensors* self = (Sensors*)arg;
+    if (!self->laserTaskHandle) return;
+    
+    BaseType_t higherPriorityWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(self->laserTaskHandle, &higherPriorityWoken);
+    if (higherPriorityWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void Sensors::laserTask(void* arg) {
+    Sensors* self = (Sensors*)arg;
+    for (;;) {
+        // 接了中断线: 激光在中断到来或 LASER_WAIT_MS 兜底到期时查询
+        // 未接中断线: 每次醒来都查询 (最长 LASER_POLL_MS 醒来一次), 不漏帧, 时间戳最多晚一个醒来间隔
+        // 陀螺仪开启时按 IMU_POLL_MS 醒来读FIFO
+        uint32_t laserWaitMs = PIN_LASER_INT >= 0 ? LASER_WAIT_MS : 0;
+        uint32_t waitMs = self->imuReady ? IMU_POLL_MS : (PIN_LASER_INT >= 0 ? LASER_WAIT_MS : LASER_POLL_MS);
+        bool notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs)) > 0;
+        if (self->imuReady) {
+            self->readImu();
+        }
+        if (notified || millis() - self->lastLaserPollTime >= laserWaitMs) {
+            self->lastLaserPollTime = millis();
+            self->readLaser();
+        }
+    }
+}
+
+void Sensors::readImu() {
+    // FIFO最多 1024/6 帧; 读取周期内通常只有几帧, 一次突发读完
+    static const int MAX_FRAMES = 170;
+    int16_t gyroZ[MAX_FRAMES];
+    int frames = imu->readGyroFifo(gyroZ, MAX_FRAMES);
+    if (frames > 0) {
+        gyroPublisher.publish(gyroZ, frames, micros());
+        lastImuUpdateTime = millis();
+    } else if (millis() - lastImuUpdateTime > IMU_STALL_MS) {
+        // 总线错误或FIFO不再增长: 重新初始化 (控制任务按 IMU_TIMEOUT_MS 自动退回编码器航向)
+        Serial.println("⚠ BMI160 timeout, resetting...");
+        if (imu->begin()) {
+            Serial.println("✓ BMI160 reset success");
+        } else {
+            Serial.println("✗ BMI160 reset failed");
+        }
+        lastImuUpdateTime = millis();
+    }
+}
+
+void Sensors::readLaser() {
     // 更新激光测距（增加滤波，提高稳定性）
-    if (laserReady && laser.isRangeComplete()) {
-        uint16_t newReading = laser.readRange();
+    if (laserReady && laser->isRangeComplete()) {
+        uint32_t sampleTimeUs = micros();
+        uint16_t newReading = laser->readRange();  // 读取结果同时清除中断
         lastLaserUpdateTime = millis();
         
-        // 检查是否为错误值 (8190/8191通常表示超时或超出量程)
-        if (newReading >= 8190) {
-            // 这是一个有效状态，表示"超出量程"或"无物体"
-            // 我们应该更新距离为最大值，以便上层逻辑知道当前没有物体
-            laserDistance = 8190;
-            
-            // 不需要复位，因为这可能是正常的无物体状态
-            // 传感器死机由下方的超时检测处理
-            laserErrorCount = 0;
-            
-            // 更新滤波器的历史值，防止下次检测到物体时误判为突变
-            // 但设为8190可能会导致下次检测到近距离物体(如100mm)时差值过大
-            // 所以这里不更新lastReading，或者将其重置为0让滤波器重新初始化
-        } else {
-            laserErrorCount = 0; // 读数正常，清零计数器
-            
-            // 简单的一阶滤波，平滑激光读数
-            static uint16_t lastReading = newReading;
-            if (abs((int)newReading - (int)lastReading) < 300 || lastReading == 0 || lastReading >= 8190) {
-                // 正常变化，使用加权平均
-                laserDistance = (lastReading * 3 + newReading * 7) / 10;  // 70%新值，30%旧值
-                lastReading = laserDistance;
-            } else {
-                // 突变，可能是噪声，保持上次值
-                static int jumpCount = 0;
-                jumpCount++;
-                if (jumpCount > 2) {
-                    // 连续3次突变，接受新值
-                    laserDistance = newReading;
-                    lastReading = newReading;
-                    jumpCount = 0;
-                }
-            }
-        }
+        // 超量程(>=8190)是正常的无物体状态, 不需要复位; 传感器死机由下方的超时检测处理
+        laserErrorCount = 0;
+        laserDistance = laserFilter.update(newReading);
+        
+        LaserSample sample;
+        sample.timestampUs = sampleTimeUs;
+        sample.raw = newReading;
+        sample.filtered = laserDistance;
+        laserRing.push(sample);
         
         // 调试输出（每秒一次）
         static unsigned long lastDebug = 0;
@@ -99,56 +161,127 @@ void Sensors::update() {
             Serial.printf("[Laser] Raw:%d Filtered:%dmm\n", newReading, laserDistance);
             lastDebug = millis();
         }
-    } else if (laserReady) {
-        // 如果长时间没有数据更新 (超过500ms)
-        if (millis() - lastLaserUpdateTime > 500) {
-             Serial.println("⚠ VL53L0X timeout, resetting...");
-             resetLaser();
-             lastLaserUpdateTime = millis();
+    } else if (laserReady && millis() - lastLaserUpdateTime > LASER_STALL_MS) {
+        // 长时间没有数据更新, 在读取任务中复位总线, 不阻塞控制
+        Serial.println("⚠ VL53L0X timeout, resetting...");
+        resetLaser();
+        lastLaserUpdateTime = millis();
+    }
+}
+
+void Sensors::update() {
+    // 更新超声波测距 (非阻塞)
+    updateUltrasonic();
+}
+
+// 回波引脚边沿中断: 上升沿记录起点, 下降沿计算脉宽并发布
+// ISR位于IRAM, 直接读引脚而不经过HAL虚函数
+// 没有等待中的测量时忽略所有边沿: 无回波时 ECHO 约38ms才拉低, 晚于 ULTRASONIC_TIMEOUT_US,
+// 这个迟到的下降沿不能算作下一次触发的回波
+void IRAM_ATTR Sensors::onEchoEdge(void* arg) {
+    Sensors* self = (Sensors*)arg;
+    uint32_t now = micros();
+    
+    if (!self->echoPending) {
+        self->echoRiseSeen = false;
+        return;
+    }
+    if (digitalRead(PIN_ULTRASONIC_ECHO) == HIGH) {
+        self->echoRiseUs = now;
+        self->echoRiseSeen = true;
+    } else if (self->echoRiseSeen) {
+        self->echoDurationUs = now - self->echoRiseUs;
+        self->echoRiseSeen = false;
+        self->echoSeq = self->echoSeq + 1;  // 最后写序号, 读者看到新序号时脉宽已就绪
+    }
+}
+
+void Sensors::triggerUltrasonic() {
+    // 先丢弃触发前到达的回波, 再开始等待 (回波上升沿在触发后数百微秒才出现)
+    echoRiseSeen = false;
+    lastEchoSeq = echoSeq;
+    triggerTimeUs = micros();
+    echoPending = true;
+    
+    gpio->digitalWrite(PIN_ULTRASONIC_TRIG, HIGH);
+    delayMicroseconds(10);
+    gpio->digitalWrite(PIN_ULTRASONIC_TRIG, LOW);
+}
+
+void Sensors::updateUltrasonic() {
+    if (echoPending) {
+        uint32_t seq = echoSeq;
+        if (seq != lastEchoSeq) {
+            // 新回波到达
+            lastEchoSeq = seq;
+            echoPending = false;
+            
+            // 计算距离 (cm)
+            // 声速 = 340m/s = 0.034cm/us
+            // 距离 = (时间 * 声速) / 2
+            publishUltrasonic(echoDurationUs * 0.034 / 2.0);
+        } else if (micros() - triggerTimeUs > ULTRASONIC_TIMEOUT_US) {
+            // 超时, 视为前方无物体
+            echoPending = false;
+            publishUltrasonic(ULTRASONIC_NO_ECHO_CM);
         }
+        return;
     }
     
-    // 更新超声波测距(限制更新频率)
+    // 限制触发频率 (回波残响消散后再触发下一次)
     unsigned long currentTime = millis();
-    if (currentTime - lastUltrasonicTime > 50) {  // 每50ms更新一次
-        ultrasonicDistance = measureUltrasonic();
+    if (currentTime - lastUltrasonicTime >= ULTRASONIC_INTERVAL_MS) {
         lastUltrasonicTime = currentTime;
+        triggerUltrasonic();
     }
 }
 
-float Sensors::measureUltrasonic() {
-    // 发送触发脉冲
-    digitalWrite(PIN_ULTRASONIC_TRIG, LOW);
-    delayMicroseconds(2);
-    digitalWrite(PIN_ULTRASONIC_TRIG, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(PIN_ULTRASONIC_TRIG, LOW);
+void Sensors::publishUltrasonic(float rawCm) {
+    ultrasonicWindow[ultrasonicWindowIndex] = rawCm;
+    ultrasonicWindowIndex = (ultrasonicWindowIndex + 1) % ULTRASONIC_MEDIAN_MAX;
+    if (ultrasonicWindowCount < ULTRASONIC_MEDIAN_MAX) ultrasonicWindowCount++;
     
-    // 读取回波
-    long duration = pulseIn(PIN_ULTRASONIC_ECHO, HIGH, 30000);  // 30ms超时
+    int size = min(min(ultrasonicWindowCount, ULTRASONIC_MEDIAN_N), ULTRASONIC_MEDIAN_MAX);
     
-    if (duration == 0) {
-        return 999.9;  // 超时,返回最大值
+    // 取最新size个读数做插入排序
+    float sorted[ULTRASONIC_MEDIAN_MAX];
+    int idx = ultrasonicWindowIndex;
+    for (int i = 0; i < size; i++) {
+        idx = (idx - 1 + ULTRASONIC_MEDIAN_MAX) % ULTRASONIC_MEDIAN_MAX;
+        float v = ultrasonicWindow[idx];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
     }
     
-    // 计算距离 (cm)
-    // 声速 = 340m/s = 0.034cm/us
-    // 距离 = (时间 * 声速) / 2
-    float distance = duration * 0.034 / 2.0;
-    
-    return distance;
+    ultrasonicDistance = (size % 2 == 1) ? sorted[size / 2]
+                                         : (sorted[size / 2 - 1] + sorted[size / 2]) / 2.0f;
+    ultrasonicTimestamp = millis();
 }
 
 float Sensors::getUltrasonicDistance() {
     return ultrasonicDistance;
 }
 
+bool Sensors::isUltrasonicValid() {
+    return ultrasonicTimestamp != 0 && getUltrasonicAge() <= ULTRASONIC_MAX_AGE_MS;
+}
+
+unsigned long Sensors::getUltrasonicAge() {
+    unsigned long timestamp = ultrasonicTimestamp;
+    if (timestamp == 0) return ULONG_MAX;
+    return millis() - timestamp;
+}
+
 uint16_t Sensors::getLaserDistance() {
     return laserDistance;
 }
 
 bool Sensors::isButtonPressed() {
-    return digitalRead(PIN_BUTTON) == LOW;  // 按下接地
+    return gpio->digitalRead(PIN_BUTTON) == LOW;  // 按下接地
 }
 
 bool Sensors::waitForButton() {
@@ -187,7 +320,7 @@ bool Sensors::checkButtonLongPress(unsigned long duration) {
 }
 
 void Sensors::setAlarm(bool on) {
-    digitalWrite(PIN_ALARM, on ? HIGH : LOW);
+    gpio->digitalWrite(PIN_ALARM, on ? HIGH : LOW);
 }
 
 void Sensors::beep(int duration) {
@@ -197,14 +330,10 @@ void Sensors::beep(int duration) {
 }
 
 void Sensors::resetLaser() {
-    // 尝试软复位
-    Wire.begin(PIN_I2C1_SDA, PIN_I2C1_SCL); // 重新初始化I2C总线
-    Wire.setClock(400000);
-    
-    if (laser.begin(VL53L0X_I2C_ADDR, false, &Wire)) {
-        laser.startRangeContinuous(20);
+    // 尝试软复位 (ranger->begin() 会重新初始化I2C总线)
+    if (laser->begin()) {
+        laserReady = laser->startContinuous(LASER_PERIOD_MS);
         Serial.println("✓ VL53L0X reset success");
-        laserReady = true;
     } else {
         Serial.println("✗ VL53L0X reset failed");
         laserReady = false;
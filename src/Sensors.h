@@ -3,40 +3,91 @@
 
 #include <Arduino.h>
 #include <Wire.h>
-#include <Adafruit_VL53L0X.h>
 #include "config.h"
+#include "LaserSample.h"
+#include "GyroSample.h"
+#include "hal/Hal.h"
+#include "CarSensors.h"
 
-class Sensors {
+class Sensors : public CarSensors {
 public:
-    Sensors();
+    Sensors(HalRanger* laser, HalImu* imu, HalGpio* gpio);
     void begin();
-    void update();
+    void update() override;
     
-    // 超声波测距 (cm)
-    float getUltrasonicDistance();
+    // 超声波测距 (cm, 中值滤波后, O(1)读取)
+    float getUltrasonicDistance() override;
+    bool isUltrasonicValid() override;      // 最近读数是否足够新
+    unsigned long getUltrasonicAge();       // 最近读数的年龄 (ms)
     
-    // 激光测距 (mm)
+    // 激光测距 (mm, 最新滤波值)
     uint16_t getLaserDistance();
     bool isLaserReady() { return laserReady; }
     
+    // 激光采样队列 (单消费者: 控制任务中的ObjectDetector)
+    LaserRing* getLaserRing() { return &laserRing; }
+    uint32_t getLaserDropped() { return laserRing.getDropped(); }
+    
+    // 陀螺仪 (BMI160): FIFO整批读出后送入队列 (单消费者: 控制任务中的HeadingEstimator)
+    bool isImuReady() { return imuReady; }
+    GyroRing* getGyroRing() { return &gyroRing; }
+    
     // 按键状态
-    bool isButtonPressed();
+    bool isButtonPressed() override;
     bool waitForButton();  // 阻塞等待按键按下
     bool checkButtonLongPress(unsigned long duration);  // 检测长按
     
     // 声光报警
-    void setAlarm(bool on);
+    void setAlarm(bool on) override;
     void beep(int duration);
 
 private:
-    Adafruit_VL53L0X laser;
-    bool laserReady;
-    uint16_t laserDistance;
+    HalRanger* laser;
+    HalImu* imu;
+    HalGpio* gpio;
+    volatile bool laserReady;
+    volatile uint16_t laserDistance;
+    LaserRing laserRing;
+    
+    unsigned long lastUltrasonicTime;        // 上次触发时间 (ms)
+    volatile float ultrasonicDistance;       // 发布的滤波距离
+    volatile unsigned long ultrasonicTimestamp; // 发布时间 (ms), 0表示尚无读数
+    
+    // 回波边沿由中断记录, ISR写入后递增echoSeq, 控制任务据此取走结果
+    static void IRAM_ATTR onEchoEdge(void* arg);
+    volatile uint32_t echoRiseUs;
+    volatile uint32_t echoDurationUs;
+    volatile uint32_t echoSeq;
+    volatile bool echoRiseSeen;
+    uint32_t lastEchoSeq;
+    volatile bool echoPending;               // 已触发, 等待回波 (ISR只在此期间记录边沿)
+    uint32_t triggerTimeUs;
+    
+    // 中值滤波窗口
+    static const int ULTRASONIC_MEDIAN_MAX = 9;
+    float ultrasonicWindow[ULTRASONIC_MEDIAN_MAX];
+    int ultrasonicWindowIndex;
+    int ultrasonicWindowCount;
+    
+    void triggerUltrasonic();
+    void updateUltrasonic();
+    void publishUltrasonic(float rawCm);
+    
+    // I2C1读取任务 (由VL53L0X数据就绪中断唤醒, 陀螺仪开启时每 IMU_POLL_MS 唤醒一次读FIFO;
+    // 总线操作与复位均不在控制路径上)
+    TaskHandle_t laserTaskHandle;
+    static void laserTask(void* arg);
+    static void IRAM_ATTR onLaserReady(void* arg);
+    void readLaser();
+    void readImu();
+    unsigned long lastLaserPollTime;
     
-    unsigned long lastUltrasonicTime;
-    float ultrasonicDistance;
+    volatile bool imuReady;
+    GyroRing gyroRing;
+    GyroPublisher gyroPublisher;
+    unsigned long lastImuUpdateTime;
     
-    float measureUltrasonic();
+    LaserFilter laserFilter;
     
     // 激光传感器错误处理
     int laserErrorCount;
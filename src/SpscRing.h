@@ -0,0 +1,80 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// 单生产者/单消费者无锁环形缓冲区
+// 生产者只修改head, 消费者只修改tail, 无需互斥锁, 不做堆分配
+// N必须是2的幂, 实际可用容量为 N-1; 满时丢弃新数据并计数
+// 只用于"取走全部"的数据流; 需要随时读最新一份时另用 LatestValue (无人消费时环满后不再更新)
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of 2");
+
+public:
+    SpscRing() : head(0), tail(0), pushed(0), dropped(0) {}
+
+    // ---- 生产者侧 ----
+    bool push(const T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t next = (h + 1) & (N - 1);
+        if (next == tail.load(std::memory_order_acquire)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        buffer[h] = item;
+        head.store(next, std::memory_order_release);
+        pushed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // ---- 消费者侧 ----
+    bool pop(T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = buffer[t];
+        tail.store((t + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+    // 批量取出, 返回取出的数量
+    size_t popBatch(T* out, size_t maxCount) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (t != h && count < maxCount) {
+            out[count++] = buffer[t];
+            t = (t + 1) & (N - 1);
+        }
+        tail.store(t, std::memory_order_release);
+        return count;
+    }
+
+    // 丢弃所有未读数据
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    size_t size() const {
+        size_t h = head.load(std::memory_order_acquire);
+        size_t t = tail.load(std::memory_order_acquire);
+        return (h - t) & (N - 1);
+    }
+
+    static constexpr size_t capacity() { return N - 1; }
+    uint32_t getPushed() const { return pushed.load(std::memory_order_relaxed); }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    T buffer[N];
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    std::atomic<uint32_t> pushed;
+    std::atomic<uint32_t> dropped;
+};
+
+#endif
@@ -153,6 +153,7 @@ String TaskManager::getTasksJson() {
         params["duration"] = task.params.duration;
         params["laserBaseline"] = task.params.laserBaseline;
         params["laserThreshold"] = task.params.laserThreshold;
+        params["trigger"] = task.params.trigger;
     }
     
     doc["currentIndex"] = currentTaskIndex;
@@ -186,6 +187,7 @@ bool TaskManager::loadTasksFromJson(String json) {
         params.laserBaseline = taskObj["params"]["laserBaseline"] | 800;
         params.laserThreshold = taskObj["params"]["laserThreshold"] | 100;
         params.customData = taskObj["params"]["customData"] | "";
+        params.trigger = taskObj["params"]["trigger"] | 0;
         
         TaskType type = (TaskType)(taskObj["type"] | 0);
         String desc = taskObj["description"] | "";
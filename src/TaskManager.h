@@ -35,6 +35,7 @@ struct TaskParams {
     uint16_t laserBaseline; // 激光基线距离
     uint16_t laserThreshold; // 激光阈值
     String customData;     // 自定义数据（JSON）
+    uint8_t trigger = 0;   // 循迹任务的结束条件: 出现此赛道特征 (TrackFeature, 0=不使用)
 };
 
 // 任务定义
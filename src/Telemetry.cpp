@@ -0,0 +1,120 @@
+#include "Telemetry.h"
+
+static const char* stateName(uint8_t state) {
+    const char* stateNames[] = {"IDLE", "LINE_FOLLOW", "OBSTACLE_AVOID", "PARKING", "FINISHED", "TESTING"};
+    if (state < sizeof(stateNames) / sizeof(stateNames[0])) {
+        return stateNames[state];
+    }
+    return "UNKNOWN";
+}
+
+// 字段与原 getSystemStatus() 保持一致, 前端无需修改
+void telemetryToJson(const TelemetryRecord& rec, JsonObject doc) {
+    doc["state"] = stateName(rec.state);
+    doc["uptime"] = millis() / 1000;
+    doc["running"] = (rec.flags & TELEM_RUNNING) != 0;
+    doc["loopFreq"] = rec.loopFreq;
+    doc["seq"] = rec.seq;
+    
+    // 传感器数据
+    JsonObject sensor = doc["sensor"].to<JsonObject>();
+    sensor["linePos"] = rec.linePos;
+    sensor["lineStates"] = rec.lineStates;
+    sensor["lineEstPos"] = rec.lineEstPos;
+    sensor["lineRate"] = rec.lineRate;
+    sensor["lineConf"] = rec.lineConf;
+    sensor["dataReady"] = (rec.flags & TELEM_LINE_READY) != 0;
+    sensor["lostLine"] = (rec.flags & TELEM_LOST_LINE) != 0;
+    sensor["laserDist"] = rec.laserDist;
+    sensor["laserReady"] = (rec.flags & TELEM_LASER_READY) != 0;
+    sensor["ultraDist"] = rec.ultraDist;
+    sensor["ultraValid"] = (rec.flags & TELEM_ULTRA_VALID) != 0;
+    
+    // 电机数据
+    JsonObject mot = doc["motor"].to<JsonObject>();
+    mot["speedL"] = rec.speedL;
+    mot["speedR"] = rec.speedR;
+    mot["distL"] = rec.distL;
+    mot["distR"] = rec.distR;
+    mot["encL"] = rec.encL;
+    mot["encR"] = rec.encR;
+    
+    // 里程计位姿
+    JsonObject odom = doc["odom"].to<JsonObject>();
+    odom["x"] = rec.odomX;
+    odom["y"] = rec.odomY;
+    odom["heading"] = rec.odomHeading * 180.0f / PI;
+    odom["dist"] = rec.odomDist;
+    odom["gyro"] = (rec.flags & TELEM_GYRO_ACTIVE) != 0;
+    odom["rate"] = rec.gyroRate;
+    odom["bias"] = rec.gyroBias;
+    
+    // PID调试数据
+    JsonObject pid = doc["pid"].to<JsonObject>();
+    pid["pTerm"] = rec.pTerm;
+    pid["iTerm"] = rec.iTerm;
+    pid["dTerm"] = rec.dTerm;
+    pid["error"] = rec.pidError;
+    
+    // 运行统计
+    doc["totalTime"] = rec.totalTimeS;
+    
+    // 赛道特征与圈计时
+    JsonObject track = doc["track"].to<JsonObject>();
+    track["feature"] = rec.lastFeature;
+    track["featureSeq"] = rec.featureSeq;
+    track["laps"] = rec.lapCount;
+    track["lastLapMs"] = rec.lastLapMs;
+    
+    // 编码器调试信息
+    JsonObject encDebug = doc["encDebug"].to<JsonObject>();
+    encDebug["left"] = rec.distL;
+    encDebug["right"] = rec.distR;
+    encDebug["diff"] = rec.distL - rec.distR;
+    
+    // 物块检测状态
+    JsonObject detection = doc["detection"].to<JsonObject>();
+    detection["active"] = (rec.flags & TELEM_DETECT_ACTIVE) != 0;
+    detection["completed"] = (rec.flags & TELEM_DETECT_COMPLETED) != 0;
+    if (rec.flags & TELEM_DETECT_COMPLETED) {
+        detection["length"] = rec.detectLength;
+        detection["avgDist"] = rec.detectAvgDist;
+        detection["valid"] = (rec.flags & TELEM_DETECT_VALID) != 0;
+        detection["duration"] = rec.detectDuration;
+        detection["rawLength"] = rec.detectRawLength;
+    }
+    
+    // 任务管理状态
+    JsonObject tasks = doc["tasks"].to<JsonObject>();
+    tasks["executing"] = (rec.flags & TELEM_TASK_EXECUTING) != 0;
+    tasks["current"] = rec.taskCurrent;
+    tasks["total"] = rec.taskTotal;
+}
+
+void telemetryBatchToJson(const TelemetryRecord* recs, size_t count, JsonObject doc) {
+    JsonArray seq = doc["seq"].to<JsonArray>();
+    JsonArray t = doc["t"].to<JsonArray>();
+    JsonArray linePos = doc["linePos"].to<JsonArray>();
+    JsonArray lineStates = doc["lineStates"].to<JsonArray>();
+    JsonArray lineRate = doc["lineRate"].to<JsonArray>();
+    JsonArray laser = doc["laser"].to<JsonArray>();
+    JsonArray ultra = doc["ultra"].to<JsonArray>();
+    JsonArray speedL = doc["speedL"].to<JsonArray>();
+    JsonArray speedR = doc["speedR"].to<JsonArray>();
+    JsonArray pidOut = doc["pid"].to<JsonArray>();
+    
+    for (size_t i = 0; i < count; i++) {
+        const TelemetryRecord& rec = recs[i];
+        seq.add(rec.seq);
+        t.add(rec.timestampUs);
+        linePos.add(rec.linePos);
+        lineStates.add(rec.lineStates);
+        lineRate.add(rec.lineRate);
+        laser.add(rec.laserDist);
+        ultra.add(rec.ultraDist);
+        speedL.add(rec.speedL);
+        speedR.add(rec.speedR);
+        pidOut.add(rec.pTerm + rec.iTerm + rec.dTerm);
+    }
+    doc["count"] = count;
+}
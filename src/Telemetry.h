@@ -0,0 +1,70 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "SpscRing.h"
+#include "LatestValue.h"
+
+// 遥测记录标志位
+enum TelemetryFlags {
+    TELEM_RUNNING          = 1 << 0,
+    TELEM_LINE_READY       = 1 << 1,
+    TELEM_LOST_LINE        = 1 << 2,
+    TELEM_LASER_READY      = 1 << 3,
+    TELEM_ULTRA_VALID      = 1 << 4,
+    TELEM_DETECT_ACTIVE    = 1 << 5,
+    TELEM_DETECT_COMPLETED = 1 << 6,
+    TELEM_DETECT_VALID     = 1 << 7,
+    TELEM_TASK_EXECUTING   = 1 << 8,
+    TELEM_GYRO_ACTIVE      = 1 << 9   // 航向取自陀螺仪 (已标定零偏且数据未中断)
+};
+
+// 定长二进制遥测记录 (控制任务每周期写入一条, 无堆分配)
+struct TelemetryRecord {
+    uint32_t seq;            // 控制周期序号
+    uint32_t timestampUs;    // 采集时刻
+    uint16_t flags;          // TelemetryFlags
+    uint8_t state;           // SystemState
+    uint8_t lineStates;      // 循迹原始8位状态
+    int16_t linePos;
+    int16_t lineEstPos;      // 线状态估计: 滤波位置
+    float lineRate;          // 线状态估计: 横向速度 (位置单位/s)
+    uint8_t lineConf;        // 线状态估计: 置信度 0..100
+    uint16_t laserDist;      // mm
+    uint16_t loopFreq;       // 控制频率 (Hz)
+    int16_t taskCurrent;
+    int16_t taskTotal;
+    float ultraDist;         // cm
+    float speedL, speedR;    // mm/s
+    float distL, distR;      // mm
+    int32_t encL, encR;
+    float odomX, odomY;      // 里程计位姿 mm (上电起点坐标系)
+    float odomHeading;       // rad
+    float odomDist;          // 累计里程 mm
+    float gyroRate;          // 去零偏角速度 °/s
+    float gyroBias;          // 陀螺仪零偏 °/s
+    float pTerm, iTerm, dTerm, pidError;
+    float detectLength;      // mm
+    float detectAvgDist;     // mm
+    float detectRawLength;   // mm
+    uint32_t detectDuration; // ms
+    uint32_t totalTimeS;     // 累计运行时间 (s)
+    uint32_t lastLapMs;      // 上一圈用时 (起/终点横条之间)
+    uint16_t lapCount;
+    uint8_t lastFeature;     // 最近一次赛道特征 (TrackFeature)
+    uint8_t featureSeq;      // 特征事件序号低8位, 前端据此发现新事件
+};
+
+// 控制任务(生产者) -> Web任务(消费者): /api/telemetry 逐周期取走
+typedef SpscRing<TelemetryRecord, TELEMETRY_RING_SIZE> TelemetryRing;
+// 控制任务每周期覆盖的最新一条: /api/status 读取, 与环形缓冲区是否有人消费无关
+typedef LatestValue<TelemetryRecord> TelemetryLatest;
+
+// 按需序列化 (仅在Web请求时调用)
+void telemetryToJson(const TelemetryRecord& rec, JsonObject doc);
+// 多条记录按列序列化, 适合高频曲线显示
+void telemetryBatchToJson(const TelemetryRecord* recs, size_t count, JsonObject doc);
+
+#endif
@@ -0,0 +1,127 @@
+#include "TrackFeatures.h"
+
+// 阵列两端各2路算作边缘 (探头0在左), 中间2路为中心
+static const uint8_t LEFT_EDGE_MASK = 0x03;
+static const uint8_t RIGHT_EDGE_MASK = 0xC0;
+static const uint8_t CENTER_MASK = 0x18;
+
+TrackFeatures::TrackFeatures() {
+    reset();
+}
+
+void TrackFeatures::reset() {
+    memset(counts, 0, sizeof(counts));
+    lastEvent.feature = FEATURE_NONE;
+    lastEvent.distanceMm = 0;
+    lastEvent.timeMs = 0;
+    lastEvent.seq = 0;
+    for (int i = 0; i < FEATURE_COUNT; i++) {
+        lastEventMm[i] = -1e9f;
+    }
+    interrupt();
+    settling = false;
+}
+
+void TrackFeatures::interrupt() {
+    settling = true;
+    settleStartMm = -1;
+    inWide = false;
+    wideStartMm = 0;
+    wideFrames = 0;
+    sawLeft = false;
+    sawRight = false;
+    inGap = false;
+    gapReported = false;
+    gapStartMm = 0;
+    lastFoundPosition = 0;
+}
+
+const char* TrackFeatures::name(TrackFeature feature) {
+    switch (feature) {
+        case FEATURE_CROSSING: return "crossing";
+        case FEATURE_BRANCH_LEFT: return "branch_left";
+        case FEATURE_BRANCH_RIGHT: return "branch_right";
+        case FEATURE_STOP_BAR: return "stop_bar";
+        case FEATURE_END_OF_LINE: return "end_of_line";
+        default: return "none";
+    }
+}
+
+// 同类特征在 LINE_FEATURE_HOLDOFF_MM 内只报一次 (横线边缘抖动会被看成两次经过)
+TrackFeature TrackFeatures::emit(TrackFeature feature, float atMm) {
+    if (atMm - lastEventMm[feature] < LINE_FEATURE_HOLDOFF_MM) {
+        return FEATURE_NONE;
+    }
+    lastEventMm[feature] = atMm;
+    counts[feature]++;
+    lastEvent.feature = feature;
+    lastEvent.distanceMm = atMm;
+    lastEvent.timeMs = millis();
+    lastEvent.seq++;
+    return feature;
+}
+
+TrackFeature TrackFeatures::update(const LineSnapshot& snapshot, float distance) {
+    TrackFeature event = FEATURE_NONE;
+    uint8_t states = snapshot.states;
+    // 横线: 压线路数多; 分支: 中心与边缘同时压线 (单条胶带盖不住这么宽)
+    bool wide = snapshot.activeCount >= LINE_FEATURE_WIDE_COUNT ||
+                ((states & CENTER_MASK) && (states & (LEFT_EDGE_MASK | RIGHT_EDGE_MASK)));
+    
+    if (settling) {
+        if (!snapshot.found || wide) {
+            settleStartMm = -1;
+        } else if (settleStartMm < 0) {
+            settleStartMm = distance;
+        } else if (distance - settleStartMm >= LINE_FEATURE_SETTLE_MM) {
+            settling = false;
+        }
+        return FEATURE_NONE;
+    }
+
+    if (wide) {
+        if (!inWide) {
+            inWide = true;
+            wideStartMm = distance;
+            wideFrames = 0;
+            sawLeft = false;
+            sawRight = false;
+        }
+        if (wideFrames < 255) wideFrames++;
+        sawLeft |= (states & LEFT_EDGE_MASK) != 0;
+        sawRight |= (states & RIGHT_EDGE_MASK) != 0;
+    } else if (inWide) {
+        // 横线结束: 按覆盖的边缘与长度分类, 单帧宽图案当作噪声
+        inWide = false;
+        if (wideFrames >= LINE_FEATURE_MIN_FRAMES) {
+            float length = distance - wideStartMm;
+            if (sawLeft && sawRight) {
+                event = emit(length >= LINE_STOP_BAR_MM ? FEATURE_STOP_BAR : FEATURE_CROSSING, wideStartMm);
+            } else if (sawLeft) {
+                event = emit(FEATURE_BRANCH_LEFT, wideStartMm);
+            } else if (sawRight) {
+                event = emit(FEATURE_BRANCH_RIGHT, wideStartMm);
+            }
+        }
+    }
+
+    if (snapshot.found) {
+        inGap = false;
+        gapReported = false;
+        lastFoundPosition = snapshot.position;
+    } else {
+        if (!inGap) {
+            inGap = true;
+            gapStartMm = distance;
+        }
+        // 线在中部消失才算断头; 从边缘消失是弯道甩出, 交给丢线搜索处理
+        if (!gapReported && distance - gapStartMm >= LINE_END_GAP_MM &&
+            abs(lastFoundPosition) < LINE_END_CENTER_POS) {
+            gapReported = true;
+            if (event == FEATURE_NONE) {
+                event = emit(FEATURE_END_OF_LINE, gapStartMm);
+            }
+        }
+    }
+    return event;
+}
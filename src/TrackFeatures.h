@@ -0,0 +1,70 @@
+#ifndef TRACK_FEATURES_H
+#define TRACK_FEATURES_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "LineSensor.h"
+
+// 赛道特征 (数值与任务JSON中的 params.trigger 一致)
+enum TrackFeature {
+    FEATURE_NONE = 0,
+    FEATURE_CROSSING,       // 十字路口: 两侧同时出现横线, 横线窄
+    FEATURE_BRANCH_LEFT,    // 左侧分支
+    FEATURE_BRANCH_RIGHT,   // 右侧分支
+    FEATURE_STOP_BAR,       // 起/终点横条: 两侧同时出现, 沿行进方向比普通横线宽
+    FEATURE_END_OF_LINE,    // 线在阵列中部消失并持续一段距离 (不是弯道甩出)
+    FEATURE_COUNT
+};
+
+// 一次去抖后的特征事件
+struct TrackEvent {
+    TrackFeature feature;
+    float distanceMm;        // 特征起点处的里程计累计里程 (Odometry 的 distance)
+    unsigned long timeMs;
+    uint32_t seq;            // 事件序号 (从1开始)
+};
+
+// 赛道特征分类: 按帧 (LineSnapshot) + 里程计里程做时间/空间上的判别
+// 宽图案 (压线数 >= LINE_FEATURE_WIDE_COUNT, 或中心与边缘同时压线) 连续出现视为经过横线/分支, 结束时按
+// 是否碰到左/右边缘和沿行进方向的长度区分十字/分支/起终点横条
+class TrackFeatures {
+public:
+    TrackFeatures();
+    void reset();
+    // 中断一段输入 (离开循迹状态): 丢弃进行中的横线/丢线过程, 保留计数;
+    // 恢复输入后先稳定压线 LINE_FEATURE_SETTLE_MM 再识别
+    void interrupt();
+
+    // 每个新帧调用一次 (snapshot.seq 变化时), 返回本帧产生的事件 (没有则为 FEATURE_NONE)
+    // distance 为里程计累计里程, 全程连续 (不随编码器清零), 后退时减小
+    TrackFeature update(const LineSnapshot& snapshot, float distance);
+
+    uint32_t getCount(TrackFeature feature) { return feature < FEATURE_COUNT ? counts[feature] : 0; }
+    const TrackEvent& getLastEvent() { return lastEvent; }
+    static const char* name(TrackFeature feature);
+
+private:
+    uint32_t counts[FEATURE_COUNT];
+    TrackEvent lastEvent;
+    float lastEventMm[FEATURE_COUNT];
+
+    bool settling;
+    float settleStartMm;
+    
+    // 横线经过过程
+    bool inWide;
+    float wideStartMm;
+    uint8_t wideFrames;
+    bool sawLeft;
+    bool sawRight;
+
+    // 丢线过程
+    bool inGap;
+    bool gapReported;
+    float gapStartMm;
+    int16_t lastFoundPosition;
+
+    TrackFeature emit(TrackFeature feature, float atMm);
+};
+
+#endif
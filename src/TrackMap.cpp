@@ -0,0 +1,236 @@
+#include "TrackMap.h"
+
+TrackMap::TrackMap(size_t maxBins) {
+    capacity = maxBins;
+    bins = nullptr;
+    reset();
+}
+
+TrackMap::~TrackMap() {
+    free(bins);
+}
+
+bool TrackMap::begin() {
+    if (bins) return true;
+    size_t bytes = capacity * sizeof(TrackBin);
+#ifdef ARDUINO_ARCH_ESP32
+    bins = (TrackBin*)(psramFound() ? ps_malloc(bytes) : malloc(bytes));
+#else
+    bins = (TrackBin*)malloc(bytes);
+#endif
+    if (!bins) {
+        Serial.printf("⚠ Track map: cannot allocate %u bytes\n", (unsigned)bytes);
+        capacity = 0;
+        return false;
+    }
+    return true;
+}
+
+void TrackMap::reset() {
+    count = 0;
+    length = 0;
+    origin = 0;
+    valid = false;
+    recording = false;
+    seedPending = false;
+}
+
+void TrackMap::startRecording() {
+    count = 0;
+    headingSum = 0;
+    offsetSum = 0;
+    headingSamples = 0;
+    offsetSamples = 0;
+    offLine = false;
+    hasPrevious = false;
+    hasPreviousTrack = false;
+    prevHeading = 0;
+    prevOffset = 0;
+    prevTrackHeading = 0;
+    seedPending = true;
+    recording = true;
+    Serial.println("◆ Track map: recording lap");
+}
+
+void TrackMap::abortRecording() {
+    if (recording) {
+        recording = false;
+        count = 0;
+        Serial.println("⚠ Track map: recording interrupted, retry next lap");
+    }
+}
+
+bool TrackMap::lapMark(float distance, bool learn) {
+    bool finished = false;
+    float lap = distance - origin;
+
+    if (recording) {
+        recording = false;
+        if (lap >= TRACK_MAP_MIN_MM && count >= 2 * TRACK_MAP_SMOOTH_BINS + 3) {
+            // 前两格没有上一格的赛道航向 (记为未知), 取第三格
+            bins[0].curvature = bins[1].curvature = bins[2].curvature;
+            length = lap;
+            valid = true;
+            finished = true;
+        } else {
+            Serial.printf("⚠ Track map: lap too short (%.0fmm), discarded\n", lap);
+            count = 0;
+        }
+    } else if (valid && fabsf(lap - length) > length * TRACK_MAP_LENGTH_TOL) {
+        Serial.printf("⚠ Track map: lap %.0fmm vs map %.0fmm, relearning\n", lap, length);
+        valid = false;
+    }
+
+    origin = distance;
+    if (learn && !valid && bins) {
+        startRecording();
+    }
+    return finished;
+}
+
+// 当前格收尾: 取格内航向/偏移的均值, 与上一格比较得到赛道航向, 再差分得到曲率
+// 离开过循迹的格没有线偏移, 记为未知; 回到线上后要再攒两格 (赛道航向需要前一格) 才重新得到曲率
+void TrackMap::closeBin() {
+    float heading = headingSamples ? headingSum / headingSamples : prevHeading;
+    float offset = offsetSamples ? offsetSum / offsetSamples : prevOffset;
+
+    bool known = false;
+    float curvature = 0;
+    if (offLine) {
+        hasPrevious = false;
+        hasPreviousTrack = false;
+    } else {
+        if (hasPrevious) {
+            // 线与车身的夹角 = 偏移对里程的斜率 + 车身转动带动探头的横移 (探头在轴前方)
+            float angle = (offset - prevOffset + TRACK_LINE_FORWARD_MM * (heading - prevHeading)) / TRACK_MAP_BIN_MM;
+            float trackHeading = heading + angle;
+            if (hasPreviousTrack) {
+                curvature = (trackHeading - prevTrackHeading) / TRACK_MAP_BIN_MM;
+                known = true;
+            }
+            prevTrackHeading = trackHeading;
+            hasPreviousTrack = true;
+        }
+        prevHeading = heading;
+        prevOffset = offset;
+        hasPrevious = true;
+    }
+
+    bins[count].curvature = known ? (int16_t)constrain(curvature * TRACK_MAP_CURV_SCALE, -32767.0f, 32767.0f)
+                                  : TRACK_CURVATURE_UNKNOWN;
+    bins[count].speed = 0;
+    count++;
+
+    headingSum = 0;
+    offsetSum = 0;
+    headingSamples = 0;
+    offsetSamples = 0;
+    offLine = false;
+}
+
+void TrackMap::record(const Pose& pose, float lineOffsetMm, bool lineSeen, bool following) {
+    if (!recording) return;
+
+    // 横条事件在横条末端才触发, 圈起点却在横条起点: 起点到这里的格没有采样, 按第一份位姿补齐,
+    // 否则空格取航向0, 与实际航向之差会被当成一个急弯
+    if (seedPending) {
+        prevHeading = pose.heading;
+        prevOffset = lineSeen ? lineOffsetMm : 0;
+        seedPending = false;
+    }
+
+    float s = pose.distance - origin;
+    while (s >= (count + 1) * TRACK_MAP_BIN_MM) {
+        if (count >= (int)capacity) {
+            Serial.printf("⚠ Track map: lap longer than %.0fm, recording stopped\n",
+                          capacity * TRACK_MAP_BIN_MM / 1000.0f);
+            recording = false;
+            count = 0;
+            return;
+        }
+        closeBin();
+    }
+
+    if (!following) {
+        offLine = true;
+        return;
+    }
+    headingSum += pose.heading;
+    headingSamples++;
+    if (lineSeen) {
+        offsetSum += lineOffsetMm;
+        offsetSamples++;
+    }
+}
+
+// 首尾相接的滑动平均, 跳过未知格
+float TrackMap::smoothedCurvature(int i) const {
+    int32_t sum = 0;
+    int known = 0;
+    for (int k = -TRACK_MAP_SMOOTH_BINS; k <= TRACK_MAP_SMOOTH_BINS; k++) {
+        int16_t curvature = bins[(i + k + count) % count].curvature;
+        if (curvature != TRACK_CURVATURE_UNKNOWN) {
+            sum += curvature;
+            known++;
+        }
+    }
+    return known ? sum / (TRACK_MAP_CURV_SCALE * known) : 0;
+}
+
+void TrackMap::computeProfile(float latAccel, float accel, float decel) {
+    if (!valid) return;
+
+    // 未知格按上限处理, 不约束前后 (查表经过未知格时本来就交回按线位置调速)
+    for (int i = 0; i < count; i++) {
+        float curvature = isKnown(i) ? fabsf(smoothedCurvature(i)) : 0;
+        float limit = TRACK_SPEED_CAP;
+        if (curvature > 1e-6f) {
+            limit = min(limit, sqrtf(latAccel / curvature));
+        }
+        bins[i].speed = (uint16_t)limit;
+    }
+
+    // 减速: 从每个弯道向前倒推; 加速: 从弯道出口向后正推. 赛道首尾相接, 各绕两圈保证跨越起点的约束传到位
+    const float brakeStep = 2 * decel * TRACK_MAP_BIN_MM;
+    for (int k = 2 * count - 1; k >= 0; k--) {
+        int i = k % count;
+        float next = bins[(i + 1) % count].speed;
+        bins[i].speed = (uint16_t)min((float)bins[i].speed, sqrtf(next * next + brakeStep));
+    }
+    const float accelStep = 2 * accel * TRACK_MAP_BIN_MM;
+    for (int k = 0; k < 2 * count; k++) {
+        int i = k % count;
+        float previous = bins[(i + count - 1) % count].speed;
+        bins[i].speed = (uint16_t)min((float)bins[i].speed, sqrtf(previous * previous + accelStep));
+    }
+}
+
+float TrackMap::speedAt(float distance, float lookahead) const {
+    if (!valid) return -1;
+
+    float s = distance - origin;
+    if (s > length + TRACK_MATCH_MM) {
+        return -1;   // 过了地图终点仍没有横条: 漏检, 位置对不上
+    }
+    int first = (int)floorf((s - TRACK_MATCH_MM) / TRACK_MAP_BIN_MM);
+    int last = (int)floorf((s + lookahead) / TRACK_MAP_BIN_MM);
+    float speed = TRACK_SPEED_CAP;
+    for (int k = first; k <= last; k++) {
+        int i = ((k % count) + count) % count;
+        if (!isKnown(i)) {
+            return -1;   // 前方是录制时绕行过的路段, 曲线不可信
+        }
+        speed = min(speed, (float)bins[i].speed);
+    }
+    return speed;
+}
+
+float TrackMap::getMinRadius() const {
+    float maxCurvature = 0;
+    for (int i = 0; i < count; i++) {
+        if (isKnown(i)) {
+            maxCurvature = max(maxCurvature, fabsf(smoothedCurvature(i)));
+        }
+    }
+    return maxCurvature > 1e-6f ? 1 / maxCurvature : 0;
+}
@@ -0,0 +1,80 @@
+#ifndef TRACK_MAP_H
+#define TRACK_MAP_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "Odometry.h"
+
+// 地图一格 (TRACK_MAP_BIN_MM 里程): 曲率 + 由曲率算出的速度曲线
+struct TrackBin {
+    int16_t curvature;   // 1/mm × TRACK_MAP_CURV_SCALE, 左转为正
+    uint16_t speed;      // mm/s
+};
+
+// 曲率未知 (该格内离开过循迹, 如避障绕行): 不参与平滑, 查表经过时返回 -1 交回按线位置调速
+static const int16_t TRACK_CURVATURE_UNKNOWN = INT16_MIN;
+
+// 赛道地图: 起/终点横条之间按里程分格, 第一圈录制曲率, 之后各圈按里程查速度曲线
+// 曲率取自里程计航向 (陀螺仪融合) 加上线位置的变化: 赛道航向 = 车身航向 + 探头处横向偏移对里程的斜率
+// 速度曲线: 每格按横向加速度限速, 再按减速度从弯道倒推 (入弯前减速完毕)、按加速度从弯道正推, 首尾相接
+// 缓冲区在 begin() 时一次性分配 (优先PSRAM), 录制与查表都不分配内存
+class TrackMap {
+public:
+    TrackMap(size_t maxBins = TRACK_MAP_MAX_BINS);
+    ~TrackMap();
+    bool begin();
+    void reset();   // 丢弃地图和录制 (每次发车)
+
+    // 经过起/终点横条 (distance 为里程计累计里程): 录制中则收尾, 已有地图则核对圈长, 再从此处开始新的一圈
+    // learn=true 且没有地图时开始录制; 返回 true 表示刚录完一圈 (调用方再 computeProfile)
+    bool lapMark(float distance, bool learn);
+    void abortRecording();   // 本圈不可用 (测试等), 下一条横条重新录制
+
+    // 每个控制周期: 当前位姿 + 探头处线的横向偏移 (mm, 向左为正); 丢线时 lineSeen=false
+    // following=false (避障/入库): 里程计仍连续, 继续按里程分格, 这些格记为曲率未知
+    void record(const Pose& pose, float lineOffsetMm, bool lineSeen, bool following);
+
+    void computeProfile(float latAccel, float accel, float decel);
+
+    // 当前里程处的目标车速 (mm/s): 取 [s-TRACK_MATCH_MM, s+lookahead] 内的最小值; 无地图或对不上时返回 -1
+    float speedAt(float distance, float lookahead) const;
+
+    bool isValid() { return valid; }
+    bool isRecording() { return recording; }
+    int getBinCount() { return count; }
+    float getLength() { return length; }
+    float getLapDistance(float distance) { return distance - origin; }
+    bool isKnown(int i) const { return bins[i].curvature != TRACK_CURVATURE_UNKNOWN; }
+    float getCurvature(int i) const { return isKnown(i) ? bins[i].curvature / TRACK_MAP_CURV_SCALE : 0; }
+    float getSpeed(int i) const { return bins[i].speed; }
+    float getMinRadius() const;
+
+private:
+    TrackBin* bins;
+    size_t capacity;
+    int count;           // 已完成的格数
+    float length;        // 录制时的一圈里程
+    float origin;        // 本圈起点 (横条处) 的累计里程
+    bool valid;
+    bool recording;
+
+    // 当前格的累加量
+    float headingSum;
+    float offsetSum;
+    int headingSamples;
+    int offsetSamples;
+    bool offLine;        // 本格内离开过循迹
+    // 上一格的均值与赛道航向
+    bool hasPrevious;
+    bool hasPreviousTrack;
+    float prevHeading;
+    float prevOffset;
+    float prevTrackHeading;
+    bool seedPending;    // 新一圈尚未收到位姿: 第一份位姿作为空格的航向/偏移
+
+    void startRecording();
+    void closeBin();
+    float smoothedCurvature(int i) const;
+};
+
+#endif
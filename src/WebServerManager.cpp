@@ -1,4 +1,5 @@
 #include "WebServerManager.h"
+#include "SensorReplay.h"
 
 WebServerManager::WebServerManager(ParameterManager* params) {
     paramManager = params;
@@ -9,12 +10,17 @@ WebServerManager::WebServerManager(ParameterManager* params) {
     calibrationCallback = nullptr;
     detectionCallback = nullptr;
     taskCallback = nullptr;
+    perfCallback = nullptr;
     logIndex = 0;
     logCount = 0;
     
+    telemetry = nullptr;
+    telemetryLatest = nullptr;
+    telemetryBatch = nullptr;
+    recorder = nullptr;
+    
     // 初始化互斥锁
     mutex = xSemaphoreCreateMutex();
-    currentStatusJson = "{\"status\":\"initializing\"}";
 }
 
 void WebServerManager::begin() {
@@ -56,11 +62,72 @@ void WebServerManager::begin() {
 //     statusCallback = callback;
 // }
 
-void WebServerManager::updateStatusJson(const String& json) {
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        currentStatusJson = json;
-        xSemaphoreGive(mutex);
+void WebServerManager::setTelemetrySource(TelemetryRing* ring, TelemetryLatest* latest) {
+    telemetry = ring;
+    telemetryLatest = latest;
+    if (!telemetryBatch) {
+        telemetryBatch = new TelemetryRecord[TELEMETRY_BATCH_MAX];
+    }
+}
+
+void WebServerManager::setRecorder(SensorRecorder* recorder) {
+    this->recorder = recorder;
+}
+
+// 用录制数据重跑一次物块检测, 请求体中的字段覆盖录制时的参数
+String WebServerManager::replayRecording(String json) {
+    JsonDocument doc;
+    if (!recorder || !recorder->hasData()) {
+        doc["status"] = "error";
+        doc["message"] = "no recording";
+    } else {
+        SensorReplay* replay = new SensorReplay();
+        replay->setLogCallback([](String message) {});
+        if (!replay->load(recorder->getHeader(), recorder->getRecords())) {
+            doc["status"] = "error";
+            doc["message"] = replay->getError();
+        } else {
+            JsonDocument request;
+            deserializeJson(request, json);  // 空请求体使用录制参数
+            ReplayConfig config = replay->getConfig();
+            config.threshold = request["threshold"] | config.threshold;
+            config.filterSize = request["filter"] | config.filterSize;
+            config.stableCount = request["stable"] | config.stableCount;
+            config.lengthScale = request["scale"] | config.lengthScale;
+            config.lengthOffset = request["offset"] | config.lengthOffset;
+            config.deviationCorrection = request["devCorr"] | config.deviationCorrection;
+            
+            ObjectMeasurement result = replay->run(config);
+            doc["status"] = "ok";
+            doc["records"] = recorder->getCount();
+            doc["valid"] = result.valid;
+            doc["length"] = result.length;
+            doc["avgDistance"] = result.avgDistance;
+            doc["startPos"] = result.startPos;
+            doc["endPos"] = result.endPos;
+            doc["duration"] = result.duration;
+        }
+        delete replay;
     }
+    
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+// 读取最新一条遥测并序列化 (读最新值槽, 不出队, 不影响 /api/telemetry 的数据流)
+String WebServerManager::getStatusJson() {
+    TelemetryRecord rec;
+    if (!telemetryLatest || !telemetryLatest->read(rec)) {
+        return "{\"status\":\"initializing\"}";
+    }
+    
+    JsonDocument doc;
+    telemetryToJson(rec, doc.to<JsonObject>());
+    
+    String output;
+    serializeJson(doc, output);
+    return output;
 }
 
 void WebServerManager::setMotionCallback(void (*callback)(String action, float value)) {
@@ -83,6 +150,10 @@ void WebServerManager::setTaskCallback(String (*callback)(String action, String
     taskCallback = callback;
 }
 
+void WebServerManager::setPerfCallback(String (*callback)(String action)) {
+    perfCallback = callback;
+}
+
 String WebServerManager::getIPAddress() {
     if (WiFi.getMode() == WIFI_STA && WiFi.status() == WL_CONNECTED) {
         return WiFi.localIP().toString();
@@ -121,32 +192,117 @@ void WebServerManager::setupRoutes() {
         }
     );
     
-    // 重置参数
+    // 重置参数 (?pid=1 只恢复循迹Kp/Kd)
     server->on("/api/reset", HTTP_POST, [this](AsyncWebServerRequest *request){
-        paramManager->reset();
+        if (request->hasParam("pid")) {
+            paramManager->resetPidGains();
+        } else {
+            paramManager->reset();
+        }
         request->send(200, "application/json", "{\"status\":\"ok\"}");
     });
     
     // 获取实时状态
     server->on("/api/status", HTTP_GET, [this](AsyncWebServerRequest *request){
-        String json = "{}";
-        if (xSemaphoreTake(mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            json = currentStatusJson;
-            xSemaphoreGive(mutex);
-        }
-        request->send(200, "application/json", json);
+        request->send(200, "application/json", getStatusJson());
     });
     
     // 传感器测试
     server->on("/api/test/sensors", HTTP_GET, [this](AsyncWebServerRequest *request){
-        String json = "{}";
-        if (xSemaphoreTake(mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            json = currentStatusJson;
-            xSemaphoreGive(mutex);
+        request->send(200, "application/json", getStatusJson());
+    });
+    
+    // 逐周期遥测 (取出上次请求以来的所有记录, 按列返回)
+    // ?since=<上次收到的最后一个seq>: 返回 missed = 本客户端漏掉的记录数 (环满丢弃, 或被其他客户端取走)
+    server->on("/api/telemetry", HTTP_GET, [this](AsyncWebServerRequest *request){
+        if (!telemetry) {
+            request->send(503, "application/json", "{\"status\":\"error\"}");
+            return;
+        }
+        size_t count = telemetry->popBatch(telemetryBatch, TELEMETRY_BATCH_MAX);
+        
+        JsonDocument doc;
+        telemetryBatchToJson(telemetryBatch, count, doc.to<JsonObject>());
+        doc["pending"] = telemetry->size();
+        doc["dropped"] = telemetry->getDropped();
+        if (request->hasParam("since") && count > 0) {
+            uint32_t since = (uint32_t)strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+            uint32_t gap = telemetryBatch[0].seq - since - 1;
+            doc["missed"] = (int32_t)gap > 0 ? gap : 0;
         }
-        request->send(200, "application/json", json);
+        
+        String output;
+        serializeJson(doc, output);
+        request->send(200, "application/json", output);
+    });
+    
+    // 分阶段耗时统计
+    server->on("/api/perf", HTTP_GET, [this](AsyncWebServerRequest *request){
+        if (perfCallback) {
+            request->send(200, "application/json", perfCallback("get"));
+        } else {
+            request->send(503, "application/json", "{\"status\":\"error\"}");
+        }
+    });
+    
+    server->on("/api/perf/reset", HTTP_POST, [this](AsyncWebServerRequest *request){
+        if (perfCallback) {
+            request->send(200, "application/json", perfCallback("reset"));
+        } else {
+            request->send(503, "application/json", "{\"status\":\"error\"}");
+        }
+    });
+    
+    // 物块检测录制: 状态 / 下载 (SREC二进制) / 板上回放
+    server->on("/api/record/status", HTTP_GET, [this](AsyncWebServerRequest *request){
+        JsonDocument doc;
+        doc["available"] = recorder != nullptr;
+        if (recorder) {
+            doc["recording"] = recorder->isRecording();
+            doc["count"] = recorder->getCount();
+            doc["dropped"] = recorder->getDropped();
+            doc["bytes"] = recorder->getSize();
+        }
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+    
+    server->on("/api/record", HTTP_GET, [this](AsyncWebServerRequest *request){
+        if (!recorder || !recorder->hasData()) {
+            request->send(404, "application/json", "{\"status\":\"error\",\"message\":\"no recording\"}");
+            return;
+        }
+        SensorRecorder* rec = recorder;
+        AsyncWebServerResponse* response = request->beginResponse("application/octet-stream", rec->getSize(),
+            [rec](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                return rec->read(index, buffer, maxLen);
+            });
+        response->addHeader("Content-Disposition", "attachment; filename=\"detect.srec\"");
+        request->send(response);
     });
     
+    // 请求体可以为空 (使用录制参数), 也可能分多块到达: 按 index/total 拼好, 收齐后只在请求回调中回复一次
+    server->on("/api/record/replay", HTTP_POST, [this](AsyncWebServerRequest *request){
+            const char* body = (const char*)request->_tempObject;
+            if (request->contentLength() > 0 && !body) {
+                request->send(413, "application/json", "{\"status\":\"error\",\"message\":\"body too large\"}");
+                return;
+            }
+            request->send(200, "application/json", replayRecording(body ? String(body) : String()));
+        }, 
+        NULL, 
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+            // _tempObject 在请求析构时由库 free()
+            if (index == 0 && total <= WEB_REPLAY_BODY_MAX) {
+                request->_tempObject = calloc(total + 1, 1);
+            }
+            char* body = (char*)request->_tempObject;
+            if (body && index + len <= total) {
+                memcpy(body + index, data, len);
+            }
+        });
+    
     // 运动控制
     server->on("/api/motion", HTTP_POST, [](AsyncWebServerRequest *request){}, 
         NULL, 
@@ -323,7 +479,7 @@ void WebServerManager::setupRoutes() {
             DeserializationError error = deserializeJson(doc, json);
             if (!error && doc.containsKey("action")) {
                 String act = doc["action"].as<String>();
-                if (act == "test_turn" || act == "test_straight" || act == "test_avoid" || act == "test_parking") {
+                if (act == "test_turn" || act == "test_straight" || act == "test_avoid" || act == "test_parking" || act == "line_cal") {
                     action = act;
                 }
             }
@@ -781,6 +937,10 @@ String WebServerManager::generateHTML() {
                 <!-- PID Config -->
                 <div class="cyber-card">
                     <h2>🎯 PID 控制核心</h2>
+                    <div id="pidOutdated" style="display: none; border: 1px solid var(--warning); color: var(--warning); padding: 8px; margin-bottom: 10px; border-radius: 4px; font-size: 0.85rem;">
+                        ⚠️ 当前Kp/Kd由旧版固件保存 (旧的10ms差分PID), 在新时基上会严重过阻尼。修改Kp/Kd后保存, 或
+                        <button class="cyber-btn secondary" onclick="resetPidGains()">恢复默认Kp/Kd</button>
+                    </div>
                     <div class="param-grid">
                         <div class="input-group">
                             <label>Kp (比例)</label>
@@ -810,11 +970,28 @@ String WebServerManager::generateHTML() {
                         <div class="param-grid" style="margin-top: 15px;">
                             <div class="input-group"><label>积分分离</label><input type="number" id="pidIntRange" class="cyber-input"></div>
                             <div class="input-group"><label>电机死区</label><input type="number" id="motorDeadband" class="cyber-input"></div>
-                            <div class="input-group"><label>直线阈值</label><input type="number" id="pidSmallErrorThres" class="cyber-input"></div>
-                            <div class="input-group"><label>直线Kp缩放</label><input type="number" id="pidKpSmallScale" class="cyber-input" step="0.1"></div>
-                            <div class="input-group"><label>直线Kd缩放</label><input type="number" id="pidKdSmallScale" class="cyber-input" step="0.1"></div>
+                            <div class="input-group"><label>微分滤波Hz</label><input type="number" id="pidDCutoff" class="cyber-input" step="1"></div>
+                            <div class="input-group"><label>循迹采集</label><select id="lineMode" class="cyber-input"><option value="0">数字</option><option value="1">模拟-质心</option><option value="2">模拟-二次插值</option></select></div>
+                            <div class="input-group"><label>循迹传输</label><select id="lineStream" class="cyber-input"><option value="0">请求</option><option value="1">连续</option></select></div>
+                            <div class="input-group"><label>轮速闭环</label><select id="velMode" class="cyber-input"><option value="0">开环</option><option value="1">闭环</option></select></div>
+                            <div class="input-group"><label>轮速Kp</label><input type="number" id="velKp" class="cyber-input" step="0.01"></div>
+                            <div class="input-group"><label>轮速Ki</label><input type="number" id="velKi" class="cyber-input" step="0.1"></div>
+                            <div class="input-group"><label>轮速前馈</label><input type="number" id="velKff" class="cyber-input" step="0.01"></div>
+                            <div class="input-group"><label>动作加速度</label><input type="number" id="moveAccel" class="cyber-input" step="100"></div>
+                            <div class="input-group"><label>动作加加速度</label><input type="number" id="moveJerk" class="cyber-input" step="1000"></div>
+                            <div class="input-group"><label>微分来源</label><select id="lineEst" class="cyber-input"><option value="0">差分</option><option value="1">估计</option></select></div>
+                            <div class="input-group"><label>转向判定</label><select id="imuTurns" class="cyber-input"><option value="0">行程</option><option value="1">陀螺仪</option></select></div>
+                            <div class="input-group"><label>赛道学习</label><select id="trackLearn" class="cyber-input"><option value="0">关闭</option><option value="1">开启</option></select></div>
+                            <div class="input-group"><label>弯道横向加速度</label><input type="number" id="trackLat" class="cyber-input" step="100"></div>
                         </div>
                     </details>
+                    
+                    <details style="margin-top: 15px; border-top: 1px dashed var(--card-border); padding-top: 10px;">
+                        <summary style="color: var(--primary); cursor: pointer; font-size: 0.9rem;">📈 增益调度表</summary>
+                        <div style="font-size: 0.8rem; color: var(--text-dim); margin: 10px 0;">行=实测轮速(mm/s), 列=|线位置|, 每格为 Kp/Ki/Kd 系数 (乘在该阶段的基础增益上), 断点之间线性插值</div>
+                        <div class="input-group"><label>阶段</label><select id="gainPhase" class="cyber-input" onchange="switchGainPhase()"><option value="pre">测距前</option><option value="measure">测量中</option><option value="post">测距后</option></select></div>
+                        <table class="cyber-table" id="gainTable" style="margin-top: 10px;"></table>
+                    </details>
                 </div>
 
                 <!-- Speed Config -->
@@ -858,6 +1035,11 @@ String WebServerManager::generateHTML() {
                         <div class="input-group"><label>Step5 右转(mm)</label><input type="number" id="avoidTurn3Dist" class="cyber-input"></div>
                         <div class="input-group"><label>搜线距离(mm)</label><input type="number" id="avoidSearchDist" class="cyber-input"></div>
                     </div>
+                    <div class="param-grid" style="margin-top: 15px;">
+                        <div class="input-group"><label>绕行方式</label><select id="avoidMode" class="cyber-input"><option value="0">分步</option><option value="1">圆弧</option></select></div>
+                        <div class="input-group"><label>圆弧半径(mm)</label><input type="number" id="avoidRadius" class="cyber-input"></div>
+                        <div class="input-group"><label>避让余量(mm)</label><input type="number" id="avoidMargin" class="cyber-input"></div>
+                    </div>
                     
                     <details style="margin-top: 15px;">
                         <summary style="color: var(--text-dim); cursor: pointer; font-size: 0.8rem;">⚙️ 步骤速度微调</summary>
@@ -896,6 +1078,7 @@ String WebServerManager::generateHTML() {
                         <div class="input-group"><label>S7</label><input type="number" id="weight7" class="cyber-input"></div>
                     </div>
                     <button class="cyber-btn" onclick="applyWeights()" style="margin-top: 15px;">应用权重</button>
+                    <button class="cyber-btn secondary" onclick="calibrateLine()" style="margin-top: 10px;">循迹校准 (原地摆动扫线)</button>
                 </div>
 
                 <!-- Parking -->
@@ -1013,6 +1196,7 @@ String WebServerManager::generateHTML() {
                 document.getElementById('kp').value = data.pid.kp;
                 document.getElementById('ki').value = data.pid.ki;
                 document.getElementById('kd').value = data.pid.kd;
+                document.getElementById('pidOutdated').style.display = data.pid.outdated ? 'block' : 'none';
                 if (data.pid.kpPost !== undefined) {
                     document.getElementById('kpPost').value = data.pid.kpPost;
                     document.getElementById('kiPost').value = data.pid.kiPost;
@@ -1023,9 +1207,19 @@ String WebServerManager::generateHTML() {
                 if (data.advanced) {
                     document.getElementById('pidIntRange').value = data.advanced.intRange;
                     document.getElementById('motorDeadband').value = data.advanced.deadband;
-                    document.getElementById('pidSmallErrorThres').value = data.advanced.smallErr;
-                    document.getElementById('pidKpSmallScale').value = data.advanced.kpScale;
-                    document.getElementById('pidKdSmallScale').value = data.advanced.kdScale;
+                    if (data.advanced.dCutoff !== undefined) document.getElementById('pidDCutoff').value = data.advanced.dCutoff;
+                    if (data.advanced.lineMode !== undefined) document.getElementById('lineMode').value = data.advanced.lineMode;
+                    if (data.advanced.lineStream !== undefined) document.getElementById('lineStream').value = data.advanced.lineStream;
+                    if (data.advanced.lineEst !== undefined) document.getElementById('lineEst').value = data.advanced.lineEst;
+                    if (data.advanced.imuTurns !== undefined) document.getElementById('imuTurns').value = data.advanced.imuTurns;
+                    if (data.advanced.trackLearn !== undefined) document.getElementById('trackLearn').value = data.advanced.trackLearn;
+                    if (data.advanced.trackLat !== undefined) document.getElementById('trackLat').value = data.advanced.trackLat;
+                }
+                
+                // 增益调度表
+                if (data.gains) {
+                    gainTable = data.gains;
+                    renderGainTable();
                 }
                 
                 // 物体测量参数
@@ -1074,6 +1268,9 @@ String WebServerManager::generateHTML() {
                     document.getElementById('avoidSpeed').value = data.avoid.speed || 150;
                     document.getElementById('avoidTurnSpeed').value = data.avoid.turnSpeed || 120;
                     document.getElementById('avoidKp').value = data.avoid.kp || 2.0;
+                    if (data.avoid.mode !== undefined) document.getElementById('avoidMode').value = data.avoid.mode;
+                    if (data.avoid.radius !== undefined) document.getElementById('avoidRadius').value = data.avoid.radius;
+                    if (data.avoid.margin !== undefined) document.getElementById('avoidMargin').value = data.avoid.margin;
                 }
                 
                 if (data.avoidSteps) {
@@ -1094,6 +1291,16 @@ String WebServerManager::generateHTML() {
                     document.getElementById('pkSpdVSlow').value = data.parking.spdVSlow || 60;
                 }
                 
+                // 轮速闭环参数
+                if (data.velocity) {
+                    document.getElementById('velMode').value = data.velocity.mode;
+                    document.getElementById('velKp').value = data.velocity.kp;
+                    document.getElementById('velKi').value = data.velocity.ki;
+                    document.getElementById('velKff').value = data.velocity.kff;
+                    if (data.velocity.accel !== undefined) document.getElementById('moveAccel').value = data.velocity.accel;
+                    if (data.velocity.jerk !== undefined) document.getElementById('moveJerk').value = data.velocity.jerk;
+                }
+                
                 // 编码器闭环参数
                 if (data.encoder) {
                     document.getElementById('turn90Dist').value = data.encoder.turn90 || 118.0;
@@ -1111,6 +1318,48 @@ String WebServerManager::generateHTML() {
             }
         }
         
+        // 增益调度表: 当前阶段渲染为表格, 切换阶段/保存前把输入读回 gainTable
+        let gainTable = null;
+        let gainTablePhase = 'pre';
+        
+        function renderGainTable() {
+            const phase = document.getElementById('gainPhase').value;
+            const cells = gainTable[phase];
+            const errors = gainTable.errors;
+            let html = '<tr><th>速度 / 误差</th>';
+            errors.forEach((e, j) => { html += `<th><input id="gErr${j}" class="cyber-input" value="${e}"></th>`; });
+            html += '</tr>';
+            gainTable.speeds.forEach((v, i) => {
+                html += `<tr><td><input id="gSpd${i}" class="cyber-input" value="${v}"></td>`;
+                errors.forEach((e, j) => {
+                    const c = cells[i * errors.length + j];
+                    html += '<td>' + ['kp', 'ki', 'kd'].map((k, n) =>
+                        `<input id="g_${i}_${j}_${n}" class="cyber-input" title="${k}" value="${c[n]}" style="margin-bottom: 2px;">`).join('') + '</td>';
+                });
+                html += '</tr>';
+            });
+            document.getElementById('gainTable').innerHTML = html;
+            gainTablePhase = phase;
+        }
+        
+        function readGainTable() {
+            if (!gainTable) return;
+            const errors = gainTable.errors;
+            errors.forEach((e, j) => { errors[j] = parseFloat(document.getElementById('gErr' + j).value); });
+            gainTable.speeds.forEach((v, i) => {
+                gainTable.speeds[i] = parseFloat(document.getElementById('gSpd' + i).value);
+                errors.forEach((e, j) => {
+                    gainTable[gainTablePhase][i * errors.length + j] =
+                        [0, 1, 2].map(n => parseFloat(document.getElementById(`g_${i}_${j}_${n}`).value));
+                });
+            });
+        }
+        
+        function switchGainPhase() {
+            readGainTable();
+            renderGainTable();
+        }
+        
         // 保存参数
         async function saveParams() {
             const params = {
@@ -1125,9 +1374,13 @@ String WebServerManager::generateHTML() {
                 advanced: {
                     intRange: parseInt(document.getElementById('pidIntRange').value),
                     deadband: parseInt(document.getElementById('motorDeadband').value),
-                    smallErr: parseInt(document.getElementById('pidSmallErrorThres').value),
-                    kpScale: parseFloat(document.getElementById('pidKpSmallScale').value),
-                    kdScale: parseFloat(document.getElementById('pidKdSmallScale').value)
+                    dCutoff: parseFloat(document.getElementById('pidDCutoff').value),
+                    lineMode: parseInt(document.getElementById('lineMode').value),
+                    lineStream: parseInt(document.getElementById('lineStream').value),
+                    lineEst: parseInt(document.getElementById('lineEst').value),
+                    imuTurns: parseInt(document.getElementById('imuTurns').value),
+                    trackLearn: parseInt(document.getElementById('trackLearn').value),
+                    trackLat: parseFloat(document.getElementById('trackLat').value)
                 },
                 object: {
                     scale: parseFloat(document.getElementById('objLengthScale').value),
@@ -1156,7 +1409,10 @@ String WebServerManager::generateHTML() {
                     search: parseInt(document.getElementById('avoidSearchDist').value),
                     speed: parseInt(document.getElementById('avoidSpeed').value),
                     turnSpeed: parseInt(document.getElementById('avoidTurnSpeed').value),
-                    kp: parseFloat(document.getElementById('avoidKp').value)
+                    kp: parseFloat(document.getElementById('avoidKp').value),
+                    mode: parseInt(document.getElementById('avoidMode').value),
+                    radius: parseInt(document.getElementById('avoidRadius').value),
+                    margin: parseInt(document.getElementById('avoidMargin').value)
                 },
                 avoidSteps: {
                     s1l: parseFloat(document.getElementById('avS1L').value), s1r: parseFloat(document.getElementById('avS1R').value),
@@ -1176,8 +1432,20 @@ String WebServerManager::generateHTML() {
                 encoder: {
                     kp: 0, ki: 0, kd: 0,
                     turn90: parseFloat(document.getElementById('turn90Dist').value)
+                },
+                velocity: {
+                    mode: parseInt(document.getElementById('velMode').value),
+                    kp: parseFloat(document.getElementById('velKp').value),
+                    ki: parseFloat(document.getElementById('velKi').value),
+                    kff: parseFloat(document.getElementById('velKff').value),
+                    accel: parseFloat(document.getElementById('moveAccel').value),
+                    jerk: parseFloat(document.getElementById('moveJerk').value)
                 }
             };
+            if (gainTable) {
+                readGainTable();
+                params.gains = gainTable;
+            }
             
             try {
                 const response = await fetch('/api/params', {
@@ -1210,6 +1478,20 @@ String WebServerManager::generateHTML() {
             }
         }
         
+        // 只恢复循迹Kp/Kd (旧版固件保存的增益)
+        async function resetPidGains() {
+            if (!confirm('确定要把Kp/Kd恢复默认吗?')) return;
+            try {
+                const response = await fetch('/api/reset?pid=1', { method: 'POST' });
+                if (response.ok) {
+                    await loadParams();
+                    showToast('Kp/Kd已恢复默认!', 'success');
+                }
+            } catch (error) {
+                showToast('重置失败: ' + error, 'error');
+            }
+        }
+        
         // 更新状态
         async function updateStatus() {
             try {
@@ -1563,6 +1845,18 @@ String WebServerManager::generateHTML() {
             } catch (e) { showToast('请求失败', 'error'); }
         }
 
+        async function calibrateLine() {
+            if (!confirm('小车将原地左右摆动扫过黑线, 请把探头放在黑线正上方')) return;
+            try {
+                const response = await fetch('/api/tasks', {
+                    method: 'POST',
+                    headers: { 'Content-Type': 'application/json' },
+                    body: JSON.stringify({ action: 'line_cal' })
+                });
+                if (response.ok) showToast('开始循迹校准', 'success');
+            } catch (e) { showToast('请求失败', 'error'); }
+        }
+
         function resetDetection() {
             stopDetection();
             document.getElementById('detectionResult').style.display = 'none';
@@ -7,6 +7,8 @@
 #include <ArduinoJson.h>
 #include "config.h"
 #include "ParameterManager.h"
+#include "Telemetry.h"
+#include "SensorRecorder.h"
 
 class WebServerManager {
 public:
@@ -18,26 +20,35 @@ public:
     void setCalibrationCallback(void (*callback)(float leftCalib, float rightCalib));
     void setDetectionCallback(void (*callback)(uint16_t baseline, uint16_t threshold));
     void setTaskCallback(String (*callback)(String action, String data));
+    void setPerfCallback(String (*callback)(String action));
     
     void addLog(String message);  // 添加日志
     String getLogs();              // 获取日志JSON
     void clearLogs();              // 清空日志
     
-    void updateStatusJson(const String& json); // 更新状态JSON (由主循环调用)
+    // 遥测数据源: ring 供 /api/telemetry 逐周期取走 (Web任务为唯一消费者), latest 供 /api/status 读最新一条
+    void setTelemetrySource(TelemetryRing* ring, TelemetryLatest* latest);
+    void setRecorder(SensorRecorder* recorder);    // 物块检测录制 (下载/板上回放)
     String getIPAddress();
 
 private:
     AsyncWebServer* server;
     ParameterManager* paramManager;
-    // String (*statusCallback)(); // 移除回调，改为主动更新
-    String currentStatusJson;      // 缓存的状态JSON
-    SemaphoreHandle_t mutex;       // 互斥锁，保护共享资源
+    TelemetryRing* telemetry;      // 控制任务写入的遥测环, 请求时才序列化
+    TelemetryLatest* telemetryLatest; // 控制任务每周期覆盖的最新一条
+    TelemetryRecord* telemetryBatch; // /api/telemetry 批量读取缓冲
+    SensorRecorder* recorder;
+    SemaphoreHandle_t mutex;       // 互斥锁，保护日志缓冲区
+    
+    String getStatusJson();
+    String replayRecording(String json);
     
     void (*motionCallback)(String action, float value);
     void (*weightCallback)(int16_t weights[8]);
     void (*calibrationCallback)(float leftCalib, float rightCalib);
     void (*detectionCallback)(uint16_t baseline, uint16_t threshold);
     String (*taskCallback)(String action, String data);
+    String (*perfCallback)(String action);
     
     // 日志缓冲区
     static const int MAX_LOGS = 50;  // 减少日志数量以节省内存
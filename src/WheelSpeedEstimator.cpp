@@ -0,0 +1,80 @@
+#include "WheelSpeedEstimator.h"
+
+// 一个A相周期对应的行程
+static const float EDGE_PERIOD_MM = 4 * MM_PER_PULSE;
+
+WheelSpeedEstimator::WheelSpeedEstimator(HalEncoder* encoder) {
+    this->encoder = encoder;
+    reset();
+}
+
+void WheelSpeedEstimator::reset() {
+    memset(countHistory, 0, sizeof(countHistory));
+    memset(timeHistory, 0, sizeof(timeHistory));
+    historyIndex = 0;
+    historyCount = 0;
+    direction = 1;
+    speed = 0;
+    countSpeed = 0;
+    edgeSpeed = 0;
+}
+
+void WheelSpeedEstimator::shiftCount(int64_t offset) {
+    for (int i = 0; i < VELOCITY_WINDOW; i++) {
+        countHistory[i] -= offset;
+    }
+}
+
+// T法: 上一个沿之后迟迟没有新沿, 说明轮子正在减速, 用"距上一个沿的时间"给出速度上限;
+// 超过 WHEEL_SPEED_STOP_MS 没有沿视为停止
+bool WheelSpeedEstimator::computeEdgeSpeed(uint32_t nowUs, float& out) {
+    HalEdgeTiming timing;
+    if (!encoder->getEdgeTiming(timing)) {
+        return false;
+    }
+    uint32_t sinceEdge = nowUs - timing.lastEdgeUs;
+    if (sinceEdge > WHEEL_SPEED_STOP_MS * 1000UL) {
+        out = 0;
+        return true;
+    }
+    if (timing.periodUs == 0 || timing.periodUs > WHEEL_SPEED_STOP_MS * 1000UL) {
+        return false;   // 首个沿/刚换向/从静止起步: 周期不代表当前速度
+    }
+    uint32_t period = max(timing.periodUs, sinceEdge);
+    out = direction * EDGE_PERIOD_MM * 1e6f / period;
+    return true;
+}
+
+void WheelSpeedEstimator::update(uint32_t nowUs) {
+    int64_t count = encoder->getCount();
+
+    if (historyCount > 0) {
+        uint8_t newest = (historyIndex + VELOCITY_WINDOW - 1) % VELOCITY_WINDOW;
+        if (count != countHistory[newest]) {
+            direction = count > countHistory[newest] ? 1 : -1;
+        }
+        // 窗口内最旧一次的计数 -> 平均速度 (单周期内只有几个脉冲, 直接差分量化太粗)
+        uint8_t oldest = historyCount < VELOCITY_WINDOW ? 0 : historyIndex;
+        float windowS = (nowUs - timeHistory[oldest]) * 1e-6f;
+        if (windowS > 0) {
+            countSpeed = (count - countHistory[oldest]) * MM_PER_PULSE / windowS;
+        }
+    }
+    countHistory[historyIndex] = count;
+    timeHistory[historyIndex] = nowUs;
+    historyIndex = (historyIndex + 1) % VELOCITY_WINDOW;
+    if (historyCount < VELOCITY_WINDOW) historyCount++;
+
+    float edge;
+    if (!computeEdgeSpeed(nowUs, edge)) {
+        edgeSpeed = 0;
+        speed = countSpeed;
+        return;
+    }
+    edgeSpeed = edge;
+
+    // 过渡权重取M法速度 (T法单次抖动不影响选择)
+    float weight = (fabsf(countSpeed) - WHEEL_SPEED_BLEND_LO) / (WHEEL_SPEED_BLEND_HI - WHEEL_SPEED_BLEND_LO);
+    weight = constrain(weight, 0.0f, 1.0f);
+    speed = weight * countSpeed + (1 - weight) * edgeSpeed;
+}
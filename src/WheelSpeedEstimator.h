@@ -0,0 +1,41 @@
+#ifndef WHEEL_SPEED_ESTIMATOR_H
+#define WHEEL_SPEED_ESTIMATOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "hal/Hal.h"
+
+// 单轮测速, 每个控制周期调用一次:
+//   M法: 最近 VELOCITY_WINDOW 个周期的计数增量 / 窗口时长, 高速时脉冲多、量化误差小
+//   T法: A相相邻上升沿间隔 (4个计数), 低速时一个窗口只有几个脉冲, 用周期测速分辨率高得多
+// 两者按速度线性过渡; 编码器不支持边沿计时时只用M法
+class WheelSpeedEstimator {
+public:
+    explicit WheelSpeedEstimator(HalEncoder* encoder);
+    void reset();
+
+    void update(uint32_t nowUs);
+    // 编码器计数清零后调用 (offset 为清零前的计数), 窗口整体平移保持速度连续
+    void shiftCount(int64_t offset);
+
+    float getSpeed() { return speed; }          // mm/s
+    float getCountSpeed() { return countSpeed; } // M法结果
+    float getEdgeSpeed() { return edgeSpeed; }   // T法结果 (无有效边沿时为0)
+
+private:
+    HalEncoder* encoder;
+
+    int64_t countHistory[VELOCITY_WINDOW];
+    uint32_t timeHistory[VELOCITY_WINDOW];
+    uint8_t historyIndex;
+    uint8_t historyCount;
+    int8_t direction;    // 最近一次计数变化的方向, T法结果取此符号
+
+    float speed;
+    float countSpeed;
+    float edgeSpeed;
+
+    bool computeEdgeSpeed(uint32_t nowUs, float& out);
+};
+
+#endif
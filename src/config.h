@@ -28,6 +28,11 @@
 // I2C1 (BMI160 + VL53L0X)
 #define PIN_I2C1_SDA         16
 #define PIN_I2C1_SCL         15
+#define BMI160_I2C_ADDR      0x69      // SDO接高 (常见模块默认); SDO接地为 0x68
+
+// VL53L0X GPIO1 数据就绪中断 (开漏, 低有效); -1 表示未接线, 读取任务按 LASER_WAIT_MS 轮询
+// 主板引脚表中没有空闲的GPIO (IO2 是触摸按键), 飞线接好 GPIO1 后在此填入引脚号
+#define PIN_LASER_INT        -1
 
 // I2C2 (OLED)
 #define PIN_I2C2_SDA         14
@@ -56,8 +61,77 @@
 
 // ==================== 传感器参数 ====================
 #define LINE_SENSOR_COUNT    8
+#define LINE_LOST_FRAMES     3         // 连续多少帧无线才算丢线
 #define LINE_UART_BAUD       115200
 
+// 循迹模块指令 (单字节) 与模拟量应答帧
+// 帧格式: 0xFF 0xFF ID LEN data[LEN] CHK, CHK = ~(ID+LEN+data), 每路12位模拟值高字节在前
+#define LINE_CMD_MANUAL      0         // 手动模式 (主动请求)
+#define LINE_CMD_DIGITAL     1         // 读取8路数字状态 (1字节应答)
+#define LINE_CMD_ANALOG      2         // 读取8路模拟值 (应答帧)
+#define LINE_CMD_STREAM_DIGITAL 3      // 连续输出: 模块按自身扫描周期主动发送数字状态 (每字节一帧)
+#define LINE_CMD_STREAM_ANALOG  4      // 连续输出: 主动发送模拟量帧
+#define LINE_FRAME_HEAD      0xFF
+#define LINE_ANALOG_DATA_LEN   (LINE_SENSOR_COUNT * 2)
+#define LINE_ANALOG_FRAME_SIZE (LINE_ANALOG_DATA_LEN + 5)
+#define LINE_ANALOG_MAX      4095
+#define LINE_MODE_DEFAULT    0         // 0=数字, 1=模拟量质心, 2=模拟量二次插值 (可在网页高级设置中切换)
+#define LINE_ANALOG_THRESHOLD  1800    // 模拟值高于此值视为压线 (派生数字状态/丢线判断)
+#define LINE_ANALOG_FAIL_LIMIT 50      // 连续无有效模拟帧次数, 超过后退回数字模式
+#define LINE_CAL_MIN_SPAN    400       // 校准: 每路 max-min 至少要有此对比度 (扫过了黑线)
+#define LINE_CAL_SWEEP_DEG   40        // 校准: 原地左右摆动角度 (探头扫过 ±50mm 左右)
+#define LINE_CAL_TIMEOUT_MS  5000      // 校准: 超过此时间还没摆完 (打滑/被卡住) 则中止, 保留原校准
+
+// 赛道特征识别 (TrackFeatures)
+#define LINE_FEATURE_WIDE_COUNT  5     // 压线路数 >= 此值视为经过横线/分支
+#define LINE_FEATURE_MIN_FRAMES  2     // 横线至少连续出现的帧数 (去抖)
+#define LINE_FEATURE_HOLDOFF_MM  80    // 同类特征的最小间距
+#define LINE_STOP_BAR_MM     35        // 横线沿行进方向长于此值为起/终点横条, 否则为十字
+#define LINE_END_GAP_MM      40        // 丢线持续此里程才报断头
+#define LINE_END_CENTER_POS  400       // 丢线前位置在此范围内 (阵列中部) 才算断头
+#define LINE_FEATURE_SETTLE_MM 100     // 避障等动作回到循迹后, 先稳定压线此里程再识别 (斜着回线会像分支)
+// 线状态估计 (LineEstimator): 匀速模型卡尔曼滤波, 输出滤波位置/横向速度/置信度
+#define LINE_EST_DEFAULT     0         // 1=PID微分项使用估计的横向速度 (可在网页高级设置中切换, 切换后需重调Kd)
+#define LINE_EST_ACCEL_SIGMA 60000.0   // 过程噪声: 横向加速度 1σ (位置单位/s²), 越大跟踪越快、速度越噪
+#define LINE_EST_DIGITAL_SIGMA 100.0   // 量测噪声 1σ: 数字模式 (权重台阶 250 的量化误差)
+#define LINE_EST_ANALOG_SIGMA  30.0    // 量测噪声 1σ: 模拟量模式
+#define LINE_EST_RATE_SIGMA0 5000.0    // 初始化时横向速度的不确定度 (位置单位/s)
+#define LINE_EST_GATE        9.0       // 归一化新息平方门限 (3σ), 超过后放大协方差
+#define LINE_EST_RESET_MS    100       // 帧间隔超过此值重新初始化
+#define LINE_EST_SIGMA_MAX   300.0     // 位置不确定度达到此值时置信度为0
+#define LINE_EST_MIN_CONFIDENCE 0.3    // 置信度低于此值时PID退回差分微分
+#define LINE_STREAM_DEFAULT  0         // 1=连续输出模式 (可在网页高级设置中切换)
+#define LINE_STREAM_TIMEOUT_MS 100     // 连续输出模式下超过此时间无帧, 退回请求/应答模式
+#define LINE_STREAM_SETTLE_MS 20       // 连续输出中切换帧类型后丢弃此时间内收到的字节 (旧格式的残留帧)
+#define LINE_RING_SIZE       16        // 接收回调 -> 控制任务 的采样环形缓冲区 (2的幂)
+
+// I2C1 读取任务 (VL53L0X + BMI160, 之后I2C1只由该任务访问)
+#define LASER_PERIOD_MS      20        // 连续测量周期
+#define LASER_WAIT_MS        30        // 接了中断线时等待中断的超时, 超时后主动查询一次
+#define LASER_POLL_MS        (LASER_PERIOD_MS / 4)  // 未接中断线 (PIN_LASER_INT < 0) 时的查询间隔, 也是采样时间戳的最大延迟
+#define LASER_STALL_MS       500       // 超过此时间无数据则复位传感器
+#define LASER_TASK_PRIORITY  3
+#define LASER_TASK_CORE      0
+#define LASER_TASK_STACK     4096
+#define LASER_RING_SIZE      32        // 采样环形缓冲区 (2的幂)
+
+// BMI160 陀螺仪: 高ODR采样存入硬件FIFO, 读取任务定期整批取走
+#define IMU_GYRO_ODR_HZ      1600      // 陀螺仪输出频率 (25~3200Hz, 25的2^n倍)
+#define IMU_GYRO_RANGE_DPS   1000      // 量程 ±°/s (125/250/500/1000/2000)
+#define IMU_GYRO_Z_SIGN      1         // 芯片正面朝上安装时逆时针为正; 倒装改为 -1
+#define IMU_POLL_MS          2         // FIFO读取周期 (1600Hz下每次约3帧)
+#define IMU_STALL_MS         200       // 超过此时间读不到数据则重新初始化
+#define IMU_RING_SIZE        64        // 读取任务 -> 控制任务 的批次环形缓冲区 (2的幂)
+
+// 航向融合 (HeadingEstimator): 陀螺仪积分 + 编码器修正偏置
+#define IMU_STILL_SPEED      5.0       // 两轮实测速度都低于此值 (mm/s) 视为静止
+#define IMU_STILL_MS         200       // 静止持续此时长后开始标定零偏 (刹车余振消散)
+#define IMU_BIAS_FRAMES      800       // 每次静止标定平均的帧数 (1600Hz下0.5s)
+#define IMU_FUSION_MAX_DPS   60.0      // 角速度低于此值 (直道/缓弯, 不打滑) 时用编码器航向修正零偏
+#define IMU_FUSION_TAU_S     10.0      // 行驶中零偏修正的时间常数
+#define IMU_TIMEOUT_MS       50        // 超过此时间没有陀螺仪数据, 航向退回编码器差速
+#define IMU_TURNS_DEFAULT    1         // 1=陀螺仪可用时转向按角度判定 (可在网页高级设置中切换)
+
 // ==================== 控制参数 ====================
 // PWM参数
 #define PWM_FREQ             20000     // 20kHz PWM频率
@@ -75,20 +149,78 @@
 #define SPEED_TURN           120       // 转弯速度
 
 // PID参数 - 循迹 (电赛标准参数,可通过WebServer调整)
-// 注意: 位置范围是 -1000~+1000, 输出差速PWM 0~255
-#define KP_LINE              0.20     // 比例系数: 位置误差的响应速度
+// 注意: 位置范围是 -1000~+1000, 输出差速PWM 0~255; 微分项输入为 位置单位/秒 (横向速度)
+#define KP_LINE              0.30     // 比例系数: 位置误差的响应速度
 #define KI_LINE              0.005    // 积分系数: 消除稳态误差
-#define KD_LINE              1.5      // 微分系数: 抑制振荡和超调
+#define KD_LINE              0.005    // 微分系数: 抑制振荡和超调
+#define PID_GAIN_VERSION     2        // 增益含义版本: 2=微秒时基PID (旧版10ms差分的Kd被限幅截断, 数值不通用)
 
 // 新增优化参数
 #define PID_INTEGRAL_RANGE   200      // 积分分离阈值：误差小于此值才进行积分
+#define PID_INTEGRAL_LIMIT   500      // 积分限幅 (误差·秒)
+#define PID_D_CUTOFF_HZ      20.0     // 微分一阶低通截止频率 (computeAt, 0=不滤波)
+#define PID_ANTIWINDUP_GAIN  5.0      // 反算抗饱和增益 (1/s): 输出限幅时积分回拉速度
+#define PID_BUMPLESS_MS      200      // 无扰切换: 增益组切换瞬间的输出差值按此时间常数衰减
+#define PID_MAX_GAP_MS       100      // 两帧间隔超过此值时微分重新起步 (积分保留, 只有 reset() 清零)
 #define MOTOR_DEADBAND       30       // 电机死区补偿PWM值 (根据电机特性调整)
-#define MOTOR_SLEW_RATE      20       // 电机加速度限制 (每周期最大PWM变化量)
 
-// 动态PID参数 (优化直线平顺度)
+// 轮速闭环 (MotorControl 速度模式): 每个控制周期 前馈 + 每轮PI
+#define VELOCITY_MODE_DEFAULT 0       // 1=循迹/前进任务按 mm/s 指令轮速 (可在网页高级设置中切换)
+#define VELOCITY_MMS_PER_UNIT 4.7     // 速度参数 (0~255档) 换算为目标轮速: 255档约1200mm/s, 与开环满占空比轮速相当
+#define VELOCITY_KFF         0.21     // 前馈: 档位/(mm/s), 约为 255/满占空比时的轮速
+#define VELOCITY_KP          0.15     // 比例: 档位/(mm/s)
+#define VELOCITY_KI          3.0      // 积分: 档位/mm
+#define VELOCITY_INTEGRAL_MAX 120     // 积分项限幅 (档位), 覆盖电池电压/地面摩擦带来的偏差
+#define VELOCITY_WINDOW      8        // M法测速窗口 (控制周期数, 500Hz下16ms)
+#define WHEEL_SPEED_BLEND_LO 150.0    // 轮速低于此值 (mm/s) 只用T法 (A相沿间隔), 窗口内脉冲太少
+#define WHEEL_SPEED_BLEND_HI 400.0    // 轮速高于此值只用M法 (窗口计数), 其间线性过渡
+#define WHEEL_SPEED_STOP_MS  60       // 超过此时长没有A相沿视为停止 (对应约15mm/s)
+
+// 离散动作速度曲线 (MotionProfile): 直行/原地转按S曲线逐周期给出目标轮速 (速度闭环跟踪)
+#define MOTION_ACCEL_DEFAULT 1500.0   // 加速度限幅 mm/s² (可在网页高级设置中调整), 过大起步打滑
+#define MOTION_JERK_DEFAULT  15000.0  // 加加速度限幅 mm/s³
+#define MOTION_POS_EPS       0.5      // 曲线到位判定 (mm)
+#define MOTION_POS_KP        8.0      // 位置修正: 实测位置落后曲线时附加的速度 (1/s)
+#define MOTION_HEADING_KP    5.0      // 直行时两轮行程差修正 ((mm/s)/mm)
+#define MOTION_DONE_MM       3.0      // 曲线走完后实测位置与终点之差小于此值即完成
+#define MOTION_SETTLE_MS     300      // 曲线走完后最多再等待此时长
+
+// 里程计 (Odometry): 差速模型按控制周期积分位姿
+#define ODOM_TRACK_MM        (WHEEL_BASE_CM * 10.0)  // 有效轮距: 原地转圈时里程计角度比实际偏大 (打滑) 则调大
+
+// 控制任务调度 (FreeRTOS)
+#define CONTROL_LOOP_HZ      500       // 控制周期频率 (硬件定时器触发)
+#define CONTROL_TIMER_ID     0         // 控制节拍使用的硬件定时器编号
+#define CONTROL_TASK_CORE    1         // 控制任务绑定的核心 (Web/WiFi运行在核心0)
+#define CONTROL_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#define CONTROL_TASK_STACK   8192
+#define AUX_TASK_CORE        0         // 状态/显示等低优先级任务所在核心
+#define DISPLAY_TASK_PRIORITY 1
+#define AUX_TASK_STACK       6144
+#define TELEMETRY_RING_SIZE  512       // 遥测环形缓冲区 (2的幂, 500Hz下约1秒)
+#define TELEMETRY_BATCH_MAX  128       // /api/telemetry 单次最多返回的记录数
+#define DISPLAY_UPDATE_MS    100       // OLED刷新周期
+#define SENSOR_REC_CAPACITY  16384     // 物块检测录制条数 (每条20字节, 优先放PSRAM, 约25s)
+
+// 增益调度表 (GainScheduler): 阶段 × 实测轮速 × |线位置| 的PID系数网格, 双线性插值
+#define GAIN_SPEED_POINTS         3     // 速度断点数
+#define GAIN_ERROR_POINTS         3     // 误差断点数
+#define GAIN_SPEED_STEP           25.0  // 输入量化 (mm/s): 量化后的输入不变时不重算增益
+#define GAIN_ERROR_STEP           10.0  // 输入量化 (位置单位)
+#define GAIN_DEFAULT_SPEEDS       {0, 600, 1200}
+// 默认表沿用原"直线缩放": 误差小于阈值时 Kp/Kd 乘系数 (阈值的2/3到阈值之间线性过渡)
 #define PID_SMALL_ERROR_THRES     150   // 直线判定阈值
 #define PID_KP_SMALL_SCALE        0.6   // 直线时Kp缩放系数 (降低响应防抖动)
 #define PID_KD_SMALL_SCALE        1.5   // 直线时Kd缩放系数 (增加阻尼防震荡)
+#define GAIN_MEASURE_KP_SCALE     2.5   // 物块测量中: 强力维持直线, 防止蛇形走位导致里程偏大
+#define GAIN_MEASURE_KD_SCALE     3.0
+
+// 超声波测距引擎 (中断测量回波, 不阻塞控制循环)
+#define ULTRASONIC_INTERVAL_MS   50      // 触发间隔
+#define ULTRASONIC_TIMEOUT_US    30000   // 回波超时 (约5m)
+#define ULTRASONIC_MEDIAN_N      5       // 中值滤波窗口 (最大9)
+#define ULTRASONIC_MAX_AGE_MS    200     // 读数超过此年龄视为无效
+#define ULTRASONIC_NO_ECHO_CM    999.9   // 无回波时的距离值
 
 // 超声波距离阈值 (cm)
 #define OBSTACLE_DETECT_DIST 30        // 障碍物检测距离
@@ -96,11 +228,40 @@
 
 // 避障参数
 #define AVOID_TIME_MS        5000      // 避障最大时间 5秒
+#define AVOID_BRAKE_MS       500       // 分步绕行前的刹停时间 (控制周期内计时, 不阻塞)
 #define OBSTACLE_WIDTH_CM    30        // 障碍物宽度
 #define OBSTACLE_LENGTH_CM   30        // 障碍物长度
 #define AVOID_TURN_TIME_MS   1200      // 转向时间 (ms) - 90度转向约需1.2秒
 #define AVOID_FORWARD_DIST_MM 500      // 绕行前进距离 (mm)
 
+// 圆弧绕行 (AvoidPath): 变道-平行-变道回线, 纯追踪跟踪, 不停车
+#define AVOID_MODE_DEFAULT   1         // 0=分步 (原地转+直行七步), 1=圆弧路径 (可在网页避障设置中切换)
+#define AVOID_RADIUS_MM      250       // 期望转弯半径 (障碍物太近时出发变道自动减小)
+#define AVOID_MARGIN_MM      60        // 与障碍物前后/侧面留出的余量
+#define AVOID_ARC_MIN_RADIUS_MM 100    // 半径减到此值仍来不及变道则改为分步绕行
+#define AVOID_ARC_MAX_DEG    60        // 变道最大偏航角 (偏移更大时中间加直线)
+#define AVOID_SONAR_FORWARD_MM 120     // 超声波探头在驱动轴前方的距离
+#define AVOID_BODY_REAR_MM   60        // 车尾在驱动轴后方的距离
+#define AVOID_LOOKAHEAD_MM   120       // 纯追踪前视距离
+#define AVOID_LAT_ACCEL      1500.0    // 弯道横向加速度上限 mm/s² (圆弧段限速)
+#define AVOID_REJOIN_MM      300       // 回到原赛道后沿直线继续的长度 (期间识线即接回循迹)
+#define AVOID_REJOIN_DEG     30        // 识线时航向与原赛道相差小于此角度才接回循迹
+
+// 赛道学习 (TrackMap): 第一圈按里程记录曲率, 之后各圈按预先算好的速度曲线循迹 (弯前提前减速)
+#define TRACK_LEARN_DEFAULT  0         // 1=启用 (可在网页高级设置中切换), 需要赛道上有起/终点横条且跑两圈以上
+#define TRACK_MAP_BIN_MM     50.0      // 曲率采样间距 (里程)
+#define TRACK_MAP_MAX_BINS   1024      // 最长约51m (每格4字节, 优先放PSRAM)
+#define TRACK_MAP_MIN_MM     1000      // 一圈短于此里程视为误判的横条, 不生成地图
+#define TRACK_MAP_LENGTH_TOL 0.1       // 之后各圈圈长与地图相差超过此比例 (漏检/误检横条) 则重新学习
+#define TRACK_MAP_SMOOTH_BINS 2        // 曲率平滑: 前后各取此格数平均 (抑制线位置量化噪声)
+#define TRACK_MAP_CURV_SCALE 1000000.0 // 曲率存储: int16, 单位 1e-6/mm (最小可表示半径约30mm)
+#define TRACK_LINE_FORWARD_MM 70.0     // 循迹阵列在驱动轴前方的距离
+#define TRACK_LINE_MM_PER_UNIT 0.04    // 线位置 (-1000~1000) 换算为横向偏移: 探头间距12mm约对应300
+#define TRACK_LAT_ACCEL      3000.0    // 弯道横向加速度上限 mm/s² (可在网页高级设置中调整)
+#define TRACK_SPEED_CAP      3000.0    // 直道曲率为0时的速度曲线上限 (mm/s, 实际再按速度档位限幅)
+#define TRACK_LOOKAHEAD_MM   100.0     // 查速度曲线时向前看的距离 (覆盖轮速闭环的响应滞后)
+#define TRACK_MATCH_MM       50.0      // 里程与地图的对应误差, 查表时向后多看此距离
+
 // 物体测量参数
 #define OBJECT_DETECT_DIST   300       // 物体检测距离 (mm)
 #define OBJECT_LENGTH_SCALE  1.0f      // 长度计算乘数
@@ -109,6 +270,7 @@
 // 车库参数
 #define PARKING_WIDTH        400       // 车库宽度 mm
 #define PARKING_DEPTH        450       // 车库深度 mm
+#define PARKING_BRAKE_MS     200       // 到达停车距离后的刹车时间, 之后松开再报警
 
 // ==================== 状态定义 ====================
 enum SystemState {
@@ -135,6 +297,7 @@ enum SystemState {
 #define WIFI_AP_SSID         "SmartCar_AP"
 #define WIFI_AP_PASSWORD     "12345678"
 #define WEB_SERVER_PORT      80
+#define WEB_REPLAY_BODY_MAX  1024      // /api/record/replay 请求体上限 (只有几个阈值参数)
 
 #endif
 
@@ -0,0 +1,82 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+
+// ==================== 硬件抽象层 ====================
+// 控制核心 (LineSensor / MotorControl / PIDController / ObjectDetector / TaskManager)
+// 只通过这些接口访问外设, 同一份代码可在ESP32与主机(native)上编译运行.
+// 实现: hal/esp32/Esp32Hal.h (板上), hal/host/HostHal.h (主机仿真/基准)
+//
+// 时钟: 控制核心直接使用 millis()/micros()/delay().
+//       ESP32上由Arduino核心提供; 主机构建时由 hal/host/Arduino.h 提供,
+//       背后是可手动推进的虚拟时钟 (见 HostHal.h 中的 hostClock* 函数).
+
+// 串口 (循迹模块)
+class HalUart {
+public:
+    virtual ~HalUart() {}
+    virtual void begin(uint32_t baud) = 0;
+    virtual int available() = 0;
+    virtual int read() = 0;                  // 无数据返回-1
+    virtual size_t readBytes(uint8_t* buf, size_t len) = 0;
+    virtual size_t write(uint8_t byte) = 0;
+    virtual int availableForWrite() = 0;
+    // 接收回调 (在串口事件任务中调用, 不是ISR); 返回false表示不支持, 调用方自行轮询
+    virtual bool setReceiveCallback(void (*callback)(void* arg), void* arg) { return false; }
+};
+
+// PWM输出 (电机H桥)
+class HalPwm {
+public:
+    virtual ~HalPwm() {}
+    virtual void setup(uint8_t channel, uint8_t pin, uint32_t freq, uint8_t resolution) = 0;
+    virtual void write(uint8_t channel, uint32_t duty) = 0;
+};
+
+// 编码器边沿计时 (低速T法测速): A相相邻两个同向上升沿, 间隔内走过4个计数
+struct HalEdgeTiming {
+    uint32_t lastEdgeUs;   // 最近一个上升沿的 micros()
+    uint32_t periodUs;     // 与上一个上升沿的间隔, 0=无效 (首个沿/刚换向)
+};
+
+// 正交编码器 (4倍频计数)
+class HalEncoder {
+public:
+    virtual ~HalEncoder() {}
+    virtual void attach(int pinA, int pinB) = 0;
+    virtual int64_t getCount() = 0;
+    virtual void clearCount() = 0;
+    // 不支持边沿计时的实现返回false, 测速只用计数
+    virtual bool getEdgeTiming(HalEdgeTiming& timing) { return false; }
+};
+
+// I2C测距传感器 (VL53L0X)
+class HalRanger {
+public:
+    virtual ~HalRanger() {}
+    virtual bool begin() = 0;                            // 初始化总线与传感器
+    virtual bool startContinuous(uint32_t periodMs) = 0; // 连续测量, 数据就绪时拉低中断脚
+    virtual bool isRangeComplete() = 0;
+    virtual uint16_t readRange() = 0;                    // 读取结果并清除中断, >=8190 表示无目标
+};
+
+// I2C陀螺仪 (BMI160): 采样存入芯片FIFO, 读取方整批取走
+class HalImu {
+public:
+    virtual ~HalImu() {}
+    virtual bool begin() = 0;       // 复位并配置陀螺仪ODR/量程, 开启FIFO; 复位时同样走这里
+    // 取出FIFO中的完整帧, 只保留Z轴原始值 (按时间先后), 返回帧数; 总线错误返回-1
+    virtual int readGyroFifo(int16_t* gyroZ, int maxFrames) = 0;
+};
+
+// 通用GPIO
+class HalGpio {
+public:
+    virtual ~HalGpio() {}
+    virtual void pinMode(uint8_t pin, uint8_t mode) = 0;
+    virtual int digitalRead(uint8_t pin) = 0;
+    virtual void digitalWrite(uint8_t pin, uint8_t level) = 0;
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "Esp32Hal.h"
+
+Esp32Uart::Esp32Uart(uint8_t uartNum, int rxPin, int txPin) : serial(uartNum) {
+    this->rxPin = rxPin;
+    this->txPin = txPin;
+}
+
+void Esp32Uart::begin(uint32_t baud) {
+    serial.begin(baud, SERIAL_8N1, rxPin, txPin);
+}
+
+// 事件由串口驱动任务发出: 线路空闲1个字符时间即触发, 一帧收完立刻回调, 不必等FIFO满
+bool Esp32Uart::setReceiveCallback(void (*callback)(void* arg), void* arg) {
+    serial.setRxTimeout(1);
+    serial.onReceive([callback, arg]() { callback(arg); }, false);
+    return true;
+}
+
+void Esp32Pwm::setup(uint8_t channel, uint8_t pin, uint32_t freq, uint8_t resolution) {
+    ::pinMode(pin, OUTPUT);
+    ledcSetup(channel, freq, resolution);
+    ledcAttachPin(pin, channel);
+}
+
+// 满速约1.2m/s时A相周期约700us, 短于此间隔的沿只可能是抖动
+static const uint32_t EDGE_MIN_US = 50;
+
+void Esp32QuadEncoder::attach(int pinA, int pinB) {
+    ESP32Encoder::useInternalWeakPullResistors = puType::up;
+    encoder.attachFullQuad(pinA, pinB);
+    encoder.clearCount();
+
+    // 同一引脚经GPIO矩阵同时送PCNT和GPIO中断, 计数仍由硬件完成
+    this->pinB = pinB;
+    attachInterruptArg(pinA, onEdge, this, RISING);
+}
+
+// A相上升沿: B相低电平为正转 (与 attachFullQuad 计数方向一致)
+void IRAM_ATTR Esp32QuadEncoder::onEdge(void* arg) {
+    Esp32QuadEncoder* self = (Esp32QuadEncoder*)arg;
+    uint32_t now = micros();
+    int8_t direction = digitalRead(self->pinB) ? -1 : 1;
+
+    portENTER_CRITICAL_ISR(&self->edgeMux);
+    uint32_t period = now - self->edge.lastEdgeUs;
+    if (self->edgeDirection == 0 || period >= EDGE_MIN_US) {
+        // 间隔过短视为抖动 (PCNT有硬件滤波, GPIO中断没有), 直接丢弃
+        self->edge.periodUs = direction == self->edgeDirection ? period : 0;
+        self->edge.lastEdgeUs = now;
+        self->edgeDirection = direction;
+    }
+    portEXIT_CRITICAL_ISR(&self->edgeMux);
+}
+
+bool Esp32QuadEncoder::getEdgeTiming(HalEdgeTiming& timing) {
+    portENTER_CRITICAL(&edgeMux);
+    timing = edge;
+    portEXIT_CRITICAL(&edgeMux);
+    return edgeDirection != 0;
+}
+
+Esp32Vl53l0xRanger::Esp32Vl53l0xRanger(TwoWire* wire, int sdaPin, int sclPin, uint8_t address, int intPin) {
+    this->wire = wire;
+    this->sdaPin = sdaPin;
+    this->sclPin = sclPin;
+    this->address = address;
+    this->intPin = intPin;
+}
+
+bool Esp32Vl53l0xRanger::begin() {
+    // (重新)初始化I2C总线, 复位时同样走这里
+    wire->begin(sdaPin, sclPin);
+    wire->setClock(400000);  // 设置I2C频率为400kHz
+    return laser.begin(address, false, wire);
+}
+
+bool Esp32Vl53l0xRanger::startContinuous(uint32_t periodMs) {
+    // 数据就绪时拉低GPIO1, 由中断唤醒读取任务
+    if (intPin >= 0) {
+        laser.setGpioConfig(VL53L0X_DEVICEMODE_CONTINUOUS_RANGING,
+                            VL53L0X_GPIOFUNCTIONALITY_NEW_MEASURE_READY,
+                            VL53L0X_INTERRUPTPOLARITY_LOW);
+    }
+    laser.startRangeContinuous(periodMs);
+    laser.clearInterruptMask(false);
+    return true;
+}
+
+// ==================== BMI160 ====================
+
+static const uint8_t BMI160_REG_CHIP_ID = 0x00;
+static const uint8_t BMI160_REG_PMU_STATUS = 0x03;
+static const uint8_t BMI160_REG_FIFO_LENGTH = 0x22;   // 0x22/0x23, 11位字节数
+static const uint8_t BMI160_REG_FIFO_DATA = 0x24;
+static const uint8_t BMI160_REG_GYR_CONF = 0x42;
+static const uint8_t BMI160_REG_GYR_RANGE = 0x43;
+static const uint8_t BMI160_REG_FIFO_CONFIG_1 = 0x47;
+static const uint8_t BMI160_REG_CMD = 0x7E;
+
+static const uint8_t BMI160_CHIP_ID = 0xD1;
+static const uint8_t BMI160_CMD_SOFT_RESET = 0xB6;
+static const uint8_t BMI160_CMD_GYR_NORMAL = 0x15;
+static const uint8_t BMI160_CMD_FIFO_FLUSH = 0xB0;
+static const uint8_t BMI160_GYR_BWP_NORMAL = 0x20;
+static const uint8_t BMI160_FIFO_GYR_EN = 0x80;        // 只存陀螺仪, 不带帧头
+static const uint8_t BMI160_PMU_GYR_MASK = 0x0C;
+static const uint8_t BMI160_PMU_GYR_NORMAL = 0x04;
+
+static const int BMI160_FRAME_BYTES = 6;               // x, y, z 各2字节, 小端
+static const int BMI160_BURST_FRAMES = 20;             // 单次突发读取120字节, 不超过Wire缓冲区(128)
+
+Esp32Bmi160Imu::Esp32Bmi160Imu(TwoWire* wire, uint8_t address, uint16_t odrHz, uint16_t rangeDps) {
+    this->wire = wire;
+    this->address = address;
+
+    // ODR: 25Hz 为 0x06, 每翻一倍加1 (3200Hz 为 0x0D)
+    odrCode = 0x06;
+    for (uint16_t hz = 25; hz < odrHz && odrCode < 0x0D; hz *= 2) {
+        odrCode++;
+    }
+    // 量程: ±2000°/s 为 0, 每减半加1 (±125°/s 为 4)
+    rangeCode = 0;
+    for (uint16_t dps = 2000; dps > rangeDps && rangeCode < 4; dps /= 2) {
+        rangeCode++;
+    }
+}
+
+bool Esp32Bmi160Imu::writeRegister(uint8_t reg, uint8_t value) {
+    wire->beginTransmission(address);
+    wire->write(reg);
+    wire->write(value);
+    return wire->endTransmission() == 0;
+}
+
+bool Esp32Bmi160Imu::readRegisters(uint8_t reg, uint8_t* buf, size_t len) {
+    wire->beginTransmission(address);
+    wire->write(reg);
+    if (wire->endTransmission(false) != 0) {
+        return false;
+    }
+    if (wire->requestFrom(address, (uint8_t)len) != len) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = wire->read();
+    }
+    return true;
+}
+
+bool Esp32Bmi160Imu::begin() {
+    uint8_t id = 0;
+    if (!readRegisters(BMI160_REG_CHIP_ID, &id, 1) || id != BMI160_CHIP_ID) {
+        return false;
+    }
+    writeRegister(BMI160_REG_CMD, BMI160_CMD_SOFT_RESET);
+    delay(10);
+
+    writeRegister(BMI160_REG_GYR_CONF, BMI160_GYR_BWP_NORMAL | odrCode);
+    writeRegister(BMI160_REG_GYR_RANGE, rangeCode);
+    writeRegister(BMI160_REG_CMD, BMI160_CMD_GYR_NORMAL);
+    delay(80);  // 陀螺仪从挂起到正常模式的启动时间 (数据手册最大80ms)
+
+    uint8_t pmu = 0;
+    if (!readRegisters(BMI160_REG_PMU_STATUS, &pmu, 1) || (pmu & BMI160_PMU_GYR_MASK) != BMI160_PMU_GYR_NORMAL) {
+        return false;
+    }
+    writeRegister(BMI160_REG_FIFO_CONFIG_1, BMI160_FIFO_GYR_EN);
+    return writeRegister(BMI160_REG_CMD, BMI160_CMD_FIFO_FLUSH);
+}
+
+int Esp32Bmi160Imu::readGyroFifo(int16_t* gyroZ, int maxFrames) {
+    uint8_t lengthBytes[2];
+    if (!readRegisters(BMI160_REG_FIFO_LENGTH, lengthBytes, 2)) {
+        return -1;
+    }
+    int frames = ((lengthBytes[0] | (lengthBytes[1] << 8)) & 0x07FF) / BMI160_FRAME_BYTES;
+    frames = min(frames, maxFrames);
+
+    // FIFO_DATA 连续读取依次弹出帧, 按整帧分块即可保持帧边界
+    int done = 0;
+    uint8_t buf[BMI160_BURST_FRAMES * BMI160_FRAME_BYTES];
+    while (done < frames) {
+        int chunk = min(frames - done, BMI160_BURST_FRAMES);
+        if (!readRegisters(BMI160_REG_FIFO_DATA, buf, chunk * BMI160_FRAME_BYTES)) {
+            return -1;
+        }
+        for (int i = 0; i < chunk; i++) {
+            const uint8_t* frame = buf + i * BMI160_FRAME_BYTES;
+            gyroZ[done + i] = (int16_t)(frame[4] | (frame[5] << 8));
+        }
+        done += chunk;
+    }
+    return frames;
+}
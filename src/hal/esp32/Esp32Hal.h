@@ -0,0 +1,95 @@
+#ifndef ESP32_HAL_H
+#define ESP32_HAL_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <ESP32Encoder.h>
+#include <Adafruit_VL53L0X.h>
+#include "../Hal.h"
+
+// 硬件串口 (引脚在构造时指定)
+class Esp32Uart : public HalUart {
+public:
+    Esp32Uart(uint8_t uartNum, int rxPin, int txPin);
+    void begin(uint32_t baud) override;
+    int available() override { return serial.available(); }
+    int read() override { return serial.read(); }
+    size_t readBytes(uint8_t* buf, size_t len) override { return serial.readBytes(buf, len); }
+    size_t write(uint8_t byte) override { return serial.write(byte); }
+    int availableForWrite() override { return serial.availableForWrite(); }
+    bool setReceiveCallback(void (*callback)(void* arg), void* arg) override;
+
+private:
+    HardwareSerial serial;
+    int rxPin;
+    int txPin;
+};
+
+// LEDC PWM
+class Esp32Pwm : public HalPwm {
+public:
+    void setup(uint8_t channel, uint8_t pin, uint32_t freq, uint8_t resolution) override;
+    void write(uint8_t channel, uint32_t duty) override { ledcWrite(channel, duty); }
+};
+
+// PCNT硬件计数器 (ESP32Encoder库) + A相上升沿GPIO中断计时
+class Esp32QuadEncoder : public HalEncoder {
+public:
+    void attach(int pinA, int pinB) override;
+    int64_t getCount() override { return encoder.getCount(); }
+    void clearCount() override { encoder.clearCount(); }
+    bool getEdgeTiming(HalEdgeTiming& timing) override;
+
+private:
+    ESP32Encoder encoder;
+    int pinB = -1;
+    portMUX_TYPE edgeMux = portMUX_INITIALIZER_UNLOCKED;
+    HalEdgeTiming edge = {0, 0};
+    int8_t edgeDirection = 0;    // 0=还没有沿
+
+    static void IRAM_ATTR onEdge(void* arg);
+};
+
+// VL53L0X (Adafruit库), 可选数据就绪中断脚
+class Esp32Vl53l0xRanger : public HalRanger {
+public:
+    Esp32Vl53l0xRanger(TwoWire* wire, int sdaPin, int sclPin, uint8_t address, int intPin);
+    bool begin() override;
+    bool startContinuous(uint32_t periodMs) override;
+    bool isRangeComplete() override { return laser.isRangeComplete(); }
+    uint16_t readRange() override { return laser.readRange(); }
+
+private:
+    Adafruit_VL53L0X laser;
+    TwoWire* wire;
+    int sdaPin;
+    int sclPin;
+    uint8_t address;
+    int intPin;
+};
+
+// BMI160 (寄存器直接读写): 只开陀螺仪, FIFO无帧头模式, 突发读取
+class Esp32Bmi160Imu : public HalImu {
+public:
+    Esp32Bmi160Imu(TwoWire* wire, uint8_t address, uint16_t odrHz, uint16_t rangeDps);
+    bool begin() override;
+    int readGyroFifo(int16_t* gyroZ, int maxFrames) override;
+
+private:
+    TwoWire* wire;
+    uint8_t address;
+    uint8_t odrCode;
+    uint8_t rangeCode;
+
+    bool writeRegister(uint8_t reg, uint8_t value);
+    bool readRegisters(uint8_t reg, uint8_t* buf, size_t len);
+};
+
+class Esp32Gpio : public HalGpio {
+public:
+    void pinMode(uint8_t pin, uint8_t mode) override { ::pinMode(pin, mode); }
+    int digitalRead(uint8_t pin) override { return ::digitalRead(pin); }
+    void digitalWrite(uint8_t pin, uint8_t level) override { ::digitalWrite(pin, level); }
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// 主机(native)构建用的最小Arduino兼容层
+// 只覆盖控制核心实际用到的部分; 时间来自 HostHal 的虚拟时钟
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <algorithm>
+
+using std::abs;
+using std::min;
+using std::max;
+
+#define IRAM_ATTR
+
+#define HIGH   1
+#define LOW    0
+#define INPUT          0x01
+#define OUTPUT         0x03
+#define INPUT_PULLUP   0x05
+
+#define DEC 10
+#define HEX 16
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ---- 时间 (虚拟时钟) ----
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// ---- String ----
+class String {
+public:
+    String() {}
+    String(const char* s) : str(s ? s : "") {}
+    String(const std::string& s) : str(s) {}
+    String(char c) : str(1, c) {}
+    String(int value, unsigned char base = DEC);
+    String(unsigned int value, unsigned char base = DEC);
+    String(long value, unsigned char base = DEC);
+    String(unsigned long value, unsigned char base = DEC);
+    String(long long value, unsigned char base = DEC);
+    String(unsigned long long value, unsigned char base = DEC);
+    String(float value, unsigned int decimals = 2);
+    String(double value, unsigned int decimals = 2);
+
+    const char* c_str() const { return str.c_str(); }
+    unsigned int length() const { return str.length(); }
+    bool isEmpty() const { return str.empty(); }
+    void reserve(unsigned int size) { str.reserve(size); }
+
+    bool concat(const String& s) { str += s.str; return true; }
+    bool concat(const char* s) { if (s) str += s; return true; }
+    bool concat(const char* s, unsigned int len) { if (s) str.append(s, len); return true; }
+    bool concat(char c) { str += c; return true; }
+
+    String& operator+=(const String& s) { concat(s); return *this; }
+    String& operator+=(const char* s) { concat(s); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+
+    bool operator==(const String& s) const { return str == s.str; }
+    bool operator==(const char* s) const { return str == (s ? s : ""); }
+    bool operator!=(const String& s) const { return str != s.str; }
+    bool operator!=(const char* s) const { return !(*this == s); }
+    bool operator<(const String& s) const { return str < s.str; }
+    char operator[](unsigned int index) const { return index < str.size() ? str[index] : 0; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& s, unsigned int from = 0) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    bool startsWith(const String& s) const { return str.compare(0, s.str.size(), s.str) == 0; }
+    bool endsWith(const String& s) const;
+    void trim();
+    long toInt() const { return atol(str.c_str()); }
+    float toFloat() const { return (float)atof(str.c_str()); }
+
+    friend String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+    friend String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+    friend String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+
+private:
+    std::string str;
+};
+
+// ArduinoJson 在启用Arduino String支持时会引用该类型
+class StringSumHelper : public String {
+public:
+    using String::String;
+};
+
+// ---- Serial (调试输出到stdout, 可静音以免干扰基准) ----
+class HostSerial {
+public:
+    void begin(unsigned long baud) {}
+    void setMuted(bool muted) { this->muted = muted; }
+    bool isMuted() const { return muted; }
+
+    size_t print(const String& s) { return emit(s.c_str()); }
+    size_t print(const char* s) { return emit(s); }
+    size_t print(char c) { char buf[2] = {c, 0}; return emit(buf); }
+    size_t print(int v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned int v, int base = DEC) { return print(String(v, base)); }
+    size_t print(long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+
+    template <typename T>
+    size_t println(const T& v) { size_t n = print(v); return n + emit("\n"); }
+    template <typename T>
+    size_t println(const T& v, int format) { size_t n = print(v, format); return n + emit("\n"); }
+    size_t println() { return emit("\n"); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    bool muted = false;
+    size_t emit(const char* s);
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,113 @@
+#include <Arduino.h>
+#include "HostHal.h"
+
+HostSerial Serial;
+
+// ==================== 时间 ====================
+
+unsigned long millis() {
+    return (unsigned long)(hostClockMicros() / 1000);
+}
+
+unsigned long micros() {
+    // 与ESP32一致, 32位回绕
+    return (unsigned long)(uint32_t)hostClockMicros();
+}
+
+void delay(unsigned long ms) {
+    hostClockDelay((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    hostClockDelay(us);
+}
+
+// ==================== String ====================
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base) {
+    if (base < 2 || base > 36) base = DEC;
+    char buf[72];
+    int pos = sizeof(buf) - 1;
+    buf[pos] = '\0';
+    do {
+        int digit = value % base;
+        buf[--pos] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value /= base;
+    } while (value > 0);
+    if (negative) buf[--pos] = '-';
+    return std::string(buf + pos);
+}
+
+// 与Arduino一致: 非十进制时负数按无符号补码输出
+String::String(int value, unsigned char base)
+    : str(base == DEC ? formatInteger(value < 0 ? -(long long)value : value, value < 0, base)
+                      : formatInteger((unsigned int)value, false, base)) {}
+String::String(unsigned int value, unsigned char base) : str(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base)
+    : str(base == DEC ? formatInteger(value < 0 ? -(long long)value : value, value < 0, base)
+                      : formatInteger((unsigned long)value, false, base)) {}
+String::String(unsigned long value, unsigned char base) : str(formatInteger(value, false, base)) {}
+String::String(long long value, unsigned char base)
+    : str(base == DEC ? formatInteger(value < 0 ? -(unsigned long long)value : value, value < 0, base)
+                      : formatInteger((unsigned long long)value, false, base)) {}
+String::String(unsigned long long value, unsigned char base) : str(formatInteger(value, false, base)) {}
+
+String::String(float value, unsigned int decimals) : String((double)value, decimals) {}
+
+String::String(double value, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+    str = buf;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = str.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& s, unsigned int from) const {
+    size_t pos = str.find(s.str, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from) const {
+    return substring(from, str.size());
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= str.size()) return String();
+    if (to > str.size()) to = str.size();
+    return String(str.substr(from, to - from));
+}
+
+bool String::endsWith(const String& s) const {
+    if (s.str.size() > str.size()) return false;
+    return str.compare(str.size() - s.str.size(), s.str.size(), s.str) == 0;
+}
+
+void String::trim() {
+    size_t begin = str.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        str.clear();
+        return;
+    }
+    size_t end = str.find_last_not_of(" \t\r\n");
+    str = str.substr(begin, end - begin + 1);
+}
+
+// ==================== Serial ====================
+
+size_t HostSerial::emit(const char* s) {
+    if (muted || !s) return 0;
+    return fputs(s, stdout) >= 0 ? strlen(s) : 0;
+}
+
+size_t HostSerial::printf(const char* format, ...) {
+    if (muted) return 0;
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n > 0 ? n : 0;
+}
@@ -0,0 +1,86 @@
+#include "HostHal.h"
+
+// ==================== 虚拟时钟 ====================
+
+static thread_local uint64_t clockUs = 0;
+static thread_local std::function<void(uint64_t)> delayHook;
+
+void hostClockSet(uint64_t us) {
+    clockUs = us;
+}
+
+void hostClockAdvance(uint64_t us) {
+    clockUs += us;
+}
+
+void hostClockDelay(uint64_t us) {
+    clockUs += us;
+    if (delayHook) {
+        delayHook(us);
+    }
+}
+
+uint64_t hostClockMicros() {
+    return clockUs;
+}
+
+void hostClockSetDelayHook(std::function<void(uint64_t us)> hook) {
+    delayHook = hook;
+}
+
+// ==================== HostUart ====================
+
+int HostUart::read() {
+    if (rx.empty()) return -1;
+    uint8_t byte = rx.front();
+    rx.pop_front();
+    return byte;
+}
+
+size_t HostUart::readBytes(uint8_t* buf, size_t len) {
+    size_t count = 0;
+    while (count < len && !rx.empty()) {
+        buf[count++] = rx.front();
+        rx.pop_front();
+    }
+    return count;
+}
+
+size_t HostUart::write(uint8_t byte) {
+    tx.push_back(byte);
+    if (responder) {
+        responder(byte, *this);
+    }
+    return 1;
+}
+
+// ==================== HostEncoder ====================
+
+bool HostEncoder::getEdgeTiming(HalEdgeTiming& timing) {
+    timing = edge;
+    return edgeDirection != 0;
+}
+
+// 正转时计数走到4的倍数、反转时走到4k+2 即为A相上升沿
+void HostEncoder::addPulse(int direction, uint32_t timestampUs) {
+    count += direction;
+    int phase = (int)(((count % 4) + 4) % 4);
+    if (phase != (direction > 0 ? 0 : 2)) {
+        return;
+    }
+    edge.periodUs = direction == edgeDirection ? timestampUs - edge.lastEdgeUs : 0;
+    edge.lastEdgeUs = timestampUs;
+    edgeDirection = direction;
+}
+
+// ==================== HostRanger ====================
+
+bool HostRanger::isRangeComplete() {
+    // 按测量周期产生新数据
+    return present && hostClockMicros() - lastReadUs >= (uint64_t)periodMs * 1000;
+}
+
+uint16_t HostRanger::readRange() {
+    lastReadUs = hostClockMicros();
+    return source ? source() : distanceMm;
+}
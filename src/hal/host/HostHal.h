@@ -0,0 +1,105 @@
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+#include "../Hal.h"
+
+// ==================== 虚拟时钟 ====================
+// 每个线程一份, 多个仿真实例可并行运行互不干扰
+// 默认手动推进; delay() 推进虚拟时间并调用可选钩子 (仿真可借此推进物理模型)
+void hostClockSet(uint64_t us);
+void hostClockAdvance(uint64_t us);
+void hostClockDelay(uint64_t us);          // delay()/delayMicroseconds() 的实现
+uint64_t hostClockMicros();
+void hostClockSetDelayHook(std::function<void(uint64_t us)> hook);
+
+// ==================== 外设仿真 ====================
+
+// 串口: 测试代码写入接收队列, 被测代码写出的字节记录在发送队列
+// 可设置应答函数, 收到请求字节时自动回填响应 (模拟循迹模块)
+class HostUart : public HalUart {
+public:
+    void begin(uint32_t baud) override { this->baud = baud; }
+    int available() override { return rx.size(); }
+    int read() override;
+    size_t readBytes(uint8_t* buf, size_t len) override;
+    size_t write(uint8_t byte) override;
+    int availableForWrite() override { return 128; }
+
+    void inject(const uint8_t* data, size_t len) { rx.insert(rx.end(), data, data + len); }
+    void setResponder(std::function<void(uint8_t request, HostUart& uart)> responder) { this->responder = responder; }
+    std::deque<uint8_t>& sent() { return tx; }
+
+private:
+    uint32_t baud = 0;
+    std::deque<uint8_t> rx;
+    std::deque<uint8_t> tx;
+    std::function<void(uint8_t, HostUart&)> responder;
+};
+
+// PWM: 记录各通道最近一次占空比
+class HostPwm : public HalPwm {
+public:
+    static const int MAX_CHANNELS = 16;
+    void setup(uint8_t channel, uint8_t pin, uint32_t freq, uint8_t resolution) override {}
+    void write(uint8_t channel, uint32_t duty) override { if (channel < MAX_CHANNELS) duties[channel] = duty; }
+    uint32_t getDuty(uint8_t channel) const { return channel < MAX_CHANNELS ? duties[channel] : 0; }
+
+private:
+    uint32_t duties[MAX_CHANNELS] = {};
+};
+
+// 编码器: 计数由仿真直接设置或累加
+class HostEncoder : public HalEncoder {
+public:
+    void attach(int pinA, int pinB) override { count = 0; }
+    int64_t getCount() override { return count; }
+    void clearCount() override { count = 0; }
+
+    bool getEdgeTiming(HalEdgeTiming& timing) override;
+
+    void setCount(int64_t value) { count = value; }
+    void addCount(int64_t delta) { count += delta; }
+    // 单个脉冲 (direction=±1) 及其时刻: 按正交相位推算A相上升沿, 供T法测速
+    void addPulse(int direction, uint32_t timestampUs);
+
+private:
+    int64_t count = 0;
+    HalEdgeTiming edge = {0, 0};
+    int edgeDirection = 0;
+};
+
+// 测距: 每次读取调用距离函数 (默认返回固定值)
+class HostRanger : public HalRanger {
+public:
+    bool begin() override { return present; }
+    bool startContinuous(uint32_t periodMs) override { this->periodMs = periodMs; return present; }
+    bool isRangeComplete() override;
+    uint16_t readRange() override;
+
+    void setPresent(bool present) { this->present = present; }
+    void setDistance(uint16_t mm) { distanceMm = mm; }
+    void setSource(std::function<uint16_t()> source) { this->source = source; }
+
+private:
+    bool present = true;
+    uint32_t periodMs = 20;
+    uint64_t lastReadUs = 0;
+    uint16_t distanceMm = 8190;
+    std::function<uint16_t()> source;
+};
+
+class HostGpio : public HalGpio {
+public:
+    static const int MAX_PINS = 64;
+    void pinMode(uint8_t pin, uint8_t mode) override {}
+    int digitalRead(uint8_t pin) override { return pin < MAX_PINS ? levels[pin] : LOW; }
+    void digitalWrite(uint8_t pin, uint8_t level) override { if (pin < MAX_PINS) levels[pin] = level; }
+
+private:
+    uint8_t levels[MAX_PINS] = {};
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+// 主机端 Preferences: 内存中的键值表, 接口与 ESP32 NVS 版本一致
+// 每个实例独立存储 (不跨实例共享命名空间), 进程退出即丢失
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) { opened = true; return true; }
+    void end() { opened = false; }
+    bool clear() { values.clear(); return true; }
+    bool remove(const char* key) { return values.erase(key) > 0; }
+    bool isKey(const char* key) { return values.count(key) > 0; }
+
+    size_t putInt(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putFloat(const char* key, float value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putBool(const char* key, bool value) { return putBytes(key, &value, sizeof(value)); }
+
+    int32_t getInt(const char* key, int32_t defaultValue = 0) { return get(key, defaultValue); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+    float getFloat(const char* key, float defaultValue = NAN) { return get(key, defaultValue); }
+    bool getBool(const char* key, bool defaultValue = false) { return get(key, defaultValue); }
+
+    size_t putBytes(const char* key, const void* value, size_t len) {
+        const uint8_t* bytes = (const uint8_t*)value;
+        values[key] = std::vector<uint8_t>(bytes, bytes + len);
+        return len;
+    }
+
+    size_t getBytesLength(const char* key) {
+        auto it = values.find(key);
+        return it == values.end() ? 0 : it->second.size();
+    }
+
+    size_t getBytes(const char* key, void* buf, size_t maxLen) {
+        auto it = values.find(key);
+        if (it == values.end() || it->second.size() > maxLen) return 0;
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+private:
+    bool opened = false;
+    std::map<std::string, std::vector<uint8_t>> values;
+
+    template <typename T>
+    T get(const char* key, T defaultValue) {
+        T value;
+        return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+    }
+};
+
+#endif
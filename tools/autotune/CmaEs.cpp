@@ -0,0 +1,167 @@
+#include "CmaEs.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+CmaEs::CmaEs(const Vector& x0, double sigma0, int lambda, uint32_t seed)
+    : n((int)x0.size()), mean(x0), sigma(sigma0), rng(seed), normal(0.0, 1.0) {
+    this->lambda = lambda > 0 ? lambda : 4 + (int)(3 * std::log((double)n));
+    mu = this->lambda / 2;
+
+    // 对数递减的重组权重
+    weights.resize(mu);
+    for (int i = 0; i < mu; i++) {
+        weights[i] = std::log(mu + 0.5) - std::log(i + 1.0);
+    }
+    double sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+    double sum2 = 0;
+    for (double& w : weights) {
+        w /= sum;
+        sum2 += w * w;
+    }
+    mueff = 1.0 / sum2;
+
+    // 默认策略参数
+    cc = (4 + mueff / n) / (n + 4 + 2 * mueff / n);
+    cs = (mueff + 2) / (n + mueff + 5);
+    c1 = 2 / ((n + 1.3) * (n + 1.3) + mueff);
+    cmu = std::min(1 - c1, 2 * (mueff - 2 + 1 / mueff) / ((n + 2) * (n + 2) + mueff));
+    damps = 1 + 2 * std::max(0.0, std::sqrt((mueff - 1) / (n + 1)) - 1) + cs;
+    chiN = std::sqrt((double)n) * (1 - 1.0 / (4 * n) + 1.0 / (21.0 * n * n));
+
+    pc.assign(n, 0);
+    ps.assign(n, 0);
+    C.assign(n, Vector(n, 0));
+    B.assign(n, Vector(n, 0));
+    D.assign(n, 1);
+    for (int i = 0; i < n; i++) {
+        C[i][i] = 1;
+        B[i][i] = 1;
+    }
+    generation = 0;
+    eigenGeneration = 0;
+}
+
+std::vector<CmaEs::Vector> CmaEs::ask() {
+    std::vector<Vector> candidates(lambda, Vector(n));
+    Vector z(n);
+    for (Vector& x : candidates) {
+        for (int i = 0; i < n; i++) z[i] = D[i] * normal(rng);
+        for (int i = 0; i < n; i++) {
+            double y = 0;
+            for (int j = 0; j < n; j++) y += B[i][j] * z[j];
+            x[i] = mean[i] + sigma * y;
+        }
+    }
+    return candidates;
+}
+
+void CmaEs::tell(const std::vector<Vector>& candidates, const std::vector<double>& costs) {
+    std::vector<int> order(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return costs[a] < costs[b]; });
+
+    Vector oldMean = mean;
+    for (int i = 0; i < n; i++) {
+        mean[i] = 0;
+        for (int k = 0; k < mu; k++) mean[i] += weights[k] * candidates[order[k]][i];
+    }
+    generation++;
+
+    // 步长路径: ps += C^-1/2 * (m - m_old) / sigma
+    Vector yw(n);
+    for (int i = 0; i < n; i++) yw[i] = (mean[i] - oldMean[i]) / sigma;
+    Vector bty(n, 0);
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) bty[j] += B[i][j] * yw[i];
+        bty[j] /= D[j];
+    }
+    double psNorm2 = 0;
+    double csFactor = std::sqrt(cs * (2 - cs) * mueff);
+    for (int i = 0; i < n; i++) {
+        double v = 0;
+        for (int j = 0; j < n; j++) v += B[i][j] * bty[j];
+        ps[i] = (1 - cs) * ps[i] + csFactor * v;
+        psNorm2 += ps[i] * ps[i];
+    }
+    double psNorm = std::sqrt(psNorm2);
+    bool hsig = psNorm / std::sqrt(1 - std::pow(1 - cs, 2.0 * generation)) / chiN < 1.4 + 2.0 / (n + 1);
+
+    // 协方差路径与秩1 + 秩mu 更新
+    double ccFactor = hsig ? std::sqrt(cc * (2 - cc) * mueff) : 0;
+    for (int i = 0; i < n; i++) pc[i] = (1 - cc) * pc[i] + ccFactor * yw[i];
+
+    double oldScale = 1 - c1 - cmu + (hsig ? 0 : c1 * cc * (2 - cc));
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j <= i; j++) {
+            double rankMu = 0;
+            for (int k = 0; k < mu; k++) {
+                const Vector& x = candidates[order[k]];
+                rankMu += weights[k] * (x[i] - oldMean[i]) * (x[j] - oldMean[j]);
+            }
+            C[i][j] = oldScale * C[i][j] + c1 * pc[i] * pc[j] + cmu * rankMu / (sigma * sigma);
+            C[j][i] = C[i][j];
+        }
+    }
+
+    sigma *= std::exp((cs / damps) * (psNorm / chiN - 1));
+
+    // 特征分解 O(n^3), 每隔几代做一次即可
+    if (generation - eigenGeneration > lambda / (c1 + cmu) / n / 10) {
+        updateEigen();
+    }
+}
+
+// 循环 Jacobi 旋转求对称矩阵特征分解 (n 只有几十, 足够快)
+void CmaEs::updateEigen() {
+    eigenGeneration = generation;
+    std::vector<Vector> a = C;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) B[i][j] = i == j ? 1 : 0;
+    }
+
+    for (int sweep = 0; sweep < 50; sweep++) {
+        double off = 0;
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) off += a[i][j] * a[i][j];
+        }
+        if (off < 1e-22) break;
+
+        for (int p = 0; p < n; p++) {
+            for (int q = p + 1; q < n; q++) {
+                if (std::fabs(a[p][q]) < 1e-30) continue;
+                double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+                double t = (theta >= 0 ? 1 : -1) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+                double c = 1 / std::sqrt(t * t + 1);
+                double s = t * c;
+                for (int k = 0; k < n; k++) {
+                    double akp = a[k][p];
+                    double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; k++) {
+                    double apk = a[p][k];
+                    double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; k++) {
+                    double bkp = B[k][p];
+                    double bkq = B[k][q];
+                    B[k][p] = c * bkp - s * bkq;
+                    B[k][q] = s * bkp + c * bkq;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        D[i] = std::sqrt(std::max(a[i][i], 1e-20));
+    }
+}
+
+double CmaEs::getConditionNumber() const {
+    double lo = *std::min_element(D.begin(), D.end());
+    double hi = *std::max_element(D.begin(), D.end());
+    return (hi * hi) / (lo * lo);
+}
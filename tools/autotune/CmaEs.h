@@ -0,0 +1,49 @@
+#ifndef CMA_ES_H
+#define CMA_ES_H
+
+#include <random>
+#include <vector>
+
+// (mu/mu_w, lambda)-CMA-ES, 最小化; 实现参照 Hansen "The CMA Evolution Strategy: A Tutorial"
+// 搜索在 [0,1]^n 归一化空间中进行, 由调用方映射到真实参数范围
+class CmaEs {
+public:
+    typedef std::vector<double> Vector;
+
+    CmaEs(const Vector& x0, double sigma0, int lambda = 0, uint32_t seed = 1);
+
+    // 采样一代候选解 (lambda 个)
+    std::vector<Vector> ask();
+    // 回报同一代的代价, 顺序与 ask() 返回一致
+    void tell(const std::vector<Vector>& candidates, const std::vector<double>& costs);
+
+    const Vector& getMean() const { return mean; }
+    double getSigma() const { return sigma; }
+    int getLambda() const { return lambda; }
+    int getGeneration() const { return generation; }
+    double getConditionNumber() const;
+
+private:
+    int n;
+    int lambda;
+    int mu;
+    Vector weights;
+    double mueff;
+    double cc, cs, c1, cmu, damps, chiN;
+
+    Vector mean;
+    double sigma;
+    Vector pc, ps;
+    std::vector<Vector> C;   // 协方差
+    std::vector<Vector> B;   // 特征向量 (列)
+    Vector D;                // 特征值开方
+    int generation;
+    int eigenGeneration;
+
+    std::mt19937 rng;
+    std::normal_distribution<double> normal;
+
+    void updateEigen();
+};
+
+#endif
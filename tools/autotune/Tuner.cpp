@@ -0,0 +1,183 @@
+#include "Tuner.h"
+#include <ArduinoJson.h>
+
+// ==================== TuneSpace ====================
+
+TuneSpace TuneSpace::standard() {
+    TuneSpace s;
+    s.dims = {
+        // 循迹PID (测量前 / 测量后)
+        {"pid", "kp", 0.05f, 1.2f, false},
+        {"pid", "kd", 0.0f, 0.1f, false},
+        {"pid", "kpPost", 0.05f, 1.2f, false},
+        {"pid", "kdPost", 0.0f, 0.1f, false},
+        // 速度
+        {"speed", "normal", 80, 255, true},
+        {"speed", "fast", 100, 255, true},
+        {"speed", "turn", 60, 200, true},
+        {"speed", "normalPost", 80, 255, true},
+        {"speed", "fastPost", 100, 255, true},
+        {"speed", "turnPost", 60, 200, true},
+        // 直线判定与缩放 (旧版参数, ParameterManager 读入时转换为增益调度表的误差轴)
+        {"advanced", "smallErr", 50, 400, true},
+        {"advanced", "kpScale", 0.2f, 1.2f, false},
+        {"advanced", "kdScale", 0.5f, 3.0f, false},
+        {"advanced", "dCutoff", 5, 100, false},
+        // 避障行程
+        {"avoid", "turn1", 80, 160, false},
+        {"avoid", "turn2", 80, 160, false},
+        {"avoid", "turn3", 80, 160, false},
+        {"avoid", "finalTurn", 60, 160, false},
+        {"avoid", "forward", 200, 600, true},
+        {"avoid", "parallel", 300, 1200, true},
+        {"avoid", "speed", 80, 220, true},
+    };
+    return s;
+}
+
+bool TuneSpace::fromJson(String json, String& error) {
+    JsonDocument doc;
+    DeserializationError parseError = deserializeJson(doc, json);
+    if (parseError) {
+        error = parseError.c_str();
+        return false;
+    }
+
+    std::vector<TuneDim> parsed;
+    for (JsonPair pair : doc.as<JsonObject>()) {
+        String name = pair.key().c_str();
+        int dot = name.indexOf('.');
+        JsonArray range = pair.value().as<JsonArray>();
+        if (dot <= 0 || range.size() < 2) {
+            error = "bad entry: " + name;
+            return false;
+        }
+        TuneDim dim;
+        dim.group = name.substring(0, dot);
+        dim.key = name.substring(dot + 1);
+        dim.min = range[0] | 0.0f;
+        dim.max = range[1] | 0.0f;
+        dim.integer = range.size() > 2 && String(range[2] | "") == "int";
+        if (dim.max <= dim.min) {
+            error = "empty range: " + name;
+            return false;
+        }
+        parsed.push_back(dim);
+    }
+    if (parsed.empty()) {
+        error = "no parameters";
+        return false;
+    }
+    dims = parsed;
+    return true;
+}
+
+float TuneSpace::value(size_t i, double x) const {
+    const TuneDim& d = dims[i];
+    float v = d.min + (float)constrain(x, 0.0, 1.0) * (d.max - d.min);
+    return d.integer ? roundf(v) : v;
+}
+
+ParameterManager TuneSpace::apply(const ParameterManager& base, const std::vector<double>& x) const {
+    // 通过 fromJson 写入, 与网页下发参数走同一条路径
+    JsonDocument patch;
+    for (size_t i = 0; i < dims.size(); i++) {
+        if (dims[i].integer) {
+            patch[dims[i].group][dims[i].key] = (int)value(i, x[i]);
+        } else {
+            patch[dims[i].group][dims[i].key] = value(i, x[i]);
+        }
+    }
+    String json;
+    serializeJson(patch, json);
+
+    ParameterManager params = base;
+    params.fromJson(json);
+    return params;
+}
+
+std::vector<double> TuneSpace::normalize(const ParameterManager& base) const {
+    ParameterManager copy = base;
+    JsonDocument doc;
+    deserializeJson(doc, copy.toJson());
+
+    std::vector<double> x(dims.size());
+    for (size_t i = 0; i < dims.size(); i++) {
+        const TuneDim& d = dims[i];
+        float v = doc[d.group][d.key] | (d.min + d.max) / 2;
+        x[i] = constrain((v - d.min) / (d.max - d.min), 0.0f, 1.0f);
+    }
+    return x;
+}
+
+// ==================== TuneObjective ====================
+
+float TuneObjective::cost(const SimResult& result, float trackLengthMm) const {
+    float c = lapWeight * result.lapTimeS + trackWeight * result.maxLineErrorMm;
+    if (result.objectValid) {
+        c += objectWeight * fabsf(result.objectLengthMm - result.objectTrueMm);
+    } else {
+        c += objectInvalidPenalty;
+    }
+    if (!result.finished) {
+        // 跑得越远代价越低, 给优化器一个方向
+        c += failPenalty + remainingWeight * std::max(0.0f, trackLengthMm - result.progressMm);
+    }
+    return c;
+}
+
+// ==================== Tuner ====================
+
+Tuner::Tuner(const SimScenario& scenario, const TuneSpace& space, const ParameterManager& base,
+             WorkPool& pool, int seeds)
+    : scenario(scenario), space(space), base(base), pool(pool), seeds(std::max(1, seeds)) {
+    simulations = 0;
+    simSeconds = 0;
+}
+
+std::vector<TuneEvaluation> Tuner::evaluate(const std::vector<std::vector<double>>& candidates) {
+    std::vector<ParameterManager> params;
+    params.reserve(candidates.size());
+    for (const std::vector<double>& x : candidates) {
+        params.push_back(space.apply(base, x));
+    }
+    return evaluateAll(params);
+}
+
+TuneEvaluation Tuner::evaluate(const ParameterManager& params) {
+    return evaluateAll(std::vector<ParameterManager>(1, params))[0];
+}
+
+std::vector<TuneEvaluation> Tuner::evaluateAll(const std::vector<ParameterManager>& params) {
+    // 任务 = (候选, 种子), 每个任务写自己的槽位, 无需加锁
+    std::vector<SimResult> results(params.size() * seeds);
+    pool.run(results.size(), [&](size_t job) {
+        Simulation sim(scenario, params[job / seeds], carConfig, 1 + (uint32_t)(job % seeds));
+        results[job] = sim.run();
+    });
+
+    float trackLength = scenario.track.getLength();
+    std::vector<TuneEvaluation> evaluations(params.size());
+    for (size_t c = 0; c < params.size(); c++) {
+        TuneEvaluation& e = evaluations[c];
+        e = TuneEvaluation();
+        e.runs = seeds;
+        float lapSum = 0;
+        for (int s = 0; s < seeds; s++) {
+            const SimResult& r = results[c * seeds + s];
+            float cost = objective.cost(r, trackLength);
+            e.cost += cost / seeds;
+            e.worstCost = std::max(e.worstCost, cost);
+            e.maxLineErrorMm = std::max(e.maxLineErrorMm, r.maxLineErrorMm);
+            e.objectErrorMm += (r.objectValid ? fabsf(r.objectLengthMm - r.objectTrueMm) : r.objectTrueMm) / seeds;
+            if (r.finished) {
+                e.finished++;
+                lapSum += r.lapTimeS;
+            }
+            simSeconds += r.simSeconds;
+        }
+        e.lapTimeS = e.finished ? lapSum / e.finished : 0;
+    }
+    simulations += results.size();
+    return evaluations;
+}
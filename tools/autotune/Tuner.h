@@ -0,0 +1,91 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "ParameterManager.h"
+#include "Simulation.h"
+#include "WorkPool.h"
+
+// 一个可调参数, 用 /api/params JSON 中的 "分组.键" 定位 (如 "pid.kp")
+struct TuneDim {
+    String group;
+    String key;
+    float min;
+    float max;
+    bool integer;
+};
+
+// 搜索空间: 候选解为 [0,1]^n 中的点, 线性映射到每个参数的取值范围
+class TuneSpace {
+public:
+    static TuneSpace standard();   // 循迹PID/速度/直线缩放/避障行程
+
+    // {"pid.kp":[0.05,0.6], "speed.fast":[150,255,"int"]}, 替换默认空间
+    bool fromJson(String json, String& error);
+
+    size_t size() const { return dims.size(); }
+    const TuneDim& operator[](size_t i) const { return dims[i]; }
+
+    // 候选解 -> 完整参数 (base 中不在搜索空间里的参数保持不变)
+    ParameterManager apply(const ParameterManager& base, const std::vector<double>& x) const;
+    // 参数 -> 归一化坐标 (作为搜索起点)
+    std::vector<double> normalize(const ParameterManager& base) const;
+    float value(size_t i, double x) const;
+
+private:
+    std::vector<TuneDim> dims;
+};
+
+// 代价 = 圈时(s) + 循迹误差 + 物块长度误差 + 失败惩罚, 越小越好
+struct TuneObjective {
+    float lapWeight = 1.0f;          // 每秒
+    float trackWeight = 0.05f;       // 每mm最大循迹误差
+    float objectWeight = 0.1f;       // 每mm物块长度误差
+    float objectInvalidPenalty = 30.0f;
+    float failPenalty = 100.0f;      // 未完成 (撞车/超时)
+    float remainingWeight = 0.02f;   // 未完成时每mm剩余赛道
+
+    float cost(const SimResult& result, float trackLengthMm) const;
+};
+
+struct TuneEvaluation {
+    float cost;              // 各随机种子的平均代价
+    float worstCost;
+    float lapTimeS;          // 完成的运行的平均圈时, 无则为0
+    float maxLineErrorMm;
+    float objectErrorMm;     // 平均绝对误差
+    int finished;
+    int runs;
+};
+
+// 把一批候选参数 x 每个随机种子各仿真一次, 所有 (候选, 种子) 组合放进线程池
+class Tuner {
+public:
+    Tuner(const SimScenario& scenario, const TuneSpace& space, const ParameterManager& base,
+          WorkPool& pool, int seeds = 3);
+
+    void setObjective(const TuneObjective& objective) { this->objective = objective; }
+    void setCarConfig(const SimCarConfig& config) { carConfig = config; }
+
+    std::vector<TuneEvaluation> evaluate(const std::vector<std::vector<double>>& candidates);
+    TuneEvaluation evaluate(const ParameterManager& params);
+
+    uint64_t getSimulations() const { return simulations; }
+    double getSimSeconds() const { return simSeconds; }
+
+private:
+    const SimScenario& scenario;
+    const TuneSpace& space;
+    const ParameterManager& base;
+    WorkPool& pool;
+    int seeds;
+    TuneObjective objective;
+    SimCarConfig carConfig;
+    uint64_t simulations;
+    double simSeconds;
+
+    std::vector<TuneEvaluation> evaluateAll(const std::vector<ParameterManager>& params);
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "WorkPool.h"
+
+WorkPool::WorkPool(int threads) {
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    current = nullptr;
+    batch = 0;
+    remaining = 0;
+    steals = 0;
+    stopping = false;
+
+    for (int i = 0; i < threads; i++) {
+        queues.push_back(new Queue());
+    }
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+WorkPool::~WorkPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+    for (Queue* q : queues) delete q;
+}
+
+void WorkPool::run(size_t count, const std::function<void(size_t)>& job) {
+    if (count == 0) return;
+    current = &job;
+    remaining = count;
+
+    // 轮流分配初始任务, 之后靠窃取平衡
+    for (size_t i = 0; i < count; i++) {
+        Queue* q = queues[i % queues.size()];
+        std::lock_guard<std::mutex> guard(q->lock);
+        q->items.push_back(i);
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    batch++;
+    wake.notify_all();
+    done.wait(guard, [this] { return remaining == 0; });
+    current = nullptr;
+}
+
+bool WorkPool::take(int index, size_t& item) {
+    Queue* own = queues[index];
+    {
+        std::lock_guard<std::mutex> guard(own->lock);
+        if (!own->items.empty()) {
+            item = own->items.back();
+            own->items.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues.size(); k++) {
+        Queue* victim = queues[(index + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim->lock);
+        if (!victim->items.empty()) {
+            item = victim->items.front();
+            victim->items.pop_front();
+            steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkPool::workerLoop(int index) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || batch != seen; });
+            if (stopping) return;
+            seen = batch;
+        }
+
+        size_t item;
+        while (take(index, item)) {
+            (*current.load())(item);
+            if (--remaining == 0) {
+                std::lock_guard<std::mutex> guard(lock);
+                done.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池: 每个线程一个双端队列, 先取自己队尾, 空了再从其它线程队头窃取
+// 仿真耗时差异很大 (撞车几秒结束, 跑完整圈要到超时), 窃取让快线程帮慢线程分担
+class WorkPool {
+public:
+    explicit WorkPool(int threads = 0);   // 0: 使用全部CPU核
+    ~WorkPool();
+
+    // 并行执行 job(0) .. job(count-1), 全部完成后返回
+    void run(size_t count, const std::function<void(size_t)>& job);
+
+    int getThreads() const { return (int)workers.size(); }
+    uint64_t getSteals() const { return steals; }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<Queue*> queues;
+    std::atomic<const std::function<void(size_t)>*> current;   // 先于任务入队设置
+
+    std::mutex lock;
+    std::condition_variable wake;       // 新批次
+    std::condition_variable done;       // 批次完成
+    uint64_t batch;
+    std::atomic<size_t> remaining;
+    std::atomic<uint64_t> steals;
+    bool stopping;
+
+    void workerLoop(int index);
+    bool take(int index, size_t& item);
+};
+
+#endif
@@ -0,0 +1,205 @@
+// 参数自动整定: 在主机仿真上用 CMA-ES (或单参数扫描) 搜索参数, 所有CPU核并行
+// pio run -e autotune && .pio/build/autotune/program [base.json] [--space space.json]
+//     [--gens N] [--pop N] [--seeds N] [--threads N] [--sigma S] [--seed S] [--out best.json]
+//     [--sweep group.key --range MIN MAX --steps N]
+// base.json / best.json 与网页 /api/params 的格式相同, best.json 可直接在网页导入或 POST 到 /api/params
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include "CmaEs.h"
+#include "Tuner.h"
+
+static bool loadFile(const char* path, String& content) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    content = String(buffer.str());
+    return true;
+}
+
+static bool saveFile(const char* path, const String& content) {
+    std::ofstream file(path);
+    if (!file) return false;
+    file << content.c_str() << "\n";
+    return (bool)file;
+}
+
+static void printEvaluation(const char* label, const TuneEvaluation& e) {
+    Serial.printf("%-10s cost=%8.2f worst=%8.2f lap=%6.2fs maxErr=%5.1fmm objErr=%5.1fmm finished=%d/%d\n",
+                  label, e.cost, e.worstCost, e.lapTimeS, e.maxLineErrorMm, e.objectErrorMm,
+                  e.finished, e.runs);
+}
+
+// 超出 [0,1] 的部分在 apply 中被截断; 额外加二次惩罚, 防止分布均值漂出边界
+static double boundaryPenalty(const std::vector<double>& x) {
+    double penalty = 0;
+    for (double v : x) {
+        double out = v < 0 ? -v : (v > 1 ? v - 1 : 0);
+        penalty += out * out;
+    }
+    return 100.0 * penalty;
+}
+
+int main(int argc, char** argv) {
+    const char* basePath = nullptr;
+    const char* spacePath = nullptr;
+    const char* outPath = "autotune_best.json";
+    const char* sweepName = nullptr;
+    float sweepMin = 0, sweepMax = 0;
+    int sweepSteps = 11;
+    int generations = 40;
+    int population = 0;
+    int seeds = 2;
+    int threads = 0;
+    double sigma = 0.2;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        if (arg == "--space" && i + 1 < argc) spacePath = argv[++i];
+        else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+        else if (arg == "--gens" && i + 1 < argc) generations = std::max(1, atoi(argv[++i]));
+        else if (arg == "--pop" && i + 1 < argc) population = std::max(4, atoi(argv[++i]));
+        else if (arg == "--seeds" && i + 1 < argc) seeds = std::max(1, atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (arg == "--sigma" && i + 1 < argc) sigma = atof(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--sweep" && i + 1 < argc) sweepName = argv[++i];
+        else if (arg == "--range" && i + 2 < argc) {
+            sweepMin = atof(argv[++i]);
+            sweepMax = atof(argv[++i]);
+        }
+        else if (arg == "--steps" && i + 1 < argc) sweepSteps = std::max(2, atoi(argv[++i]));
+        else if (arg.startsWith("--")) {
+            Serial.printf("Unknown option %s\n", argv[i]);
+            return 1;
+        }
+        else basePath = argv[i];
+    }
+
+    // fromJson 每次都会 save() 并打印, 整定期间静音
+    Serial.setMuted(true);
+    ParameterManager base;
+    if (basePath) {
+        String json;
+        if (!loadFile(basePath, json)) {
+            Serial.setMuted(false);
+            Serial.printf("Cannot read %s\n", basePath);
+            return 1;
+        }
+        base.fromJson(json);
+    }
+
+    TuneSpace space = TuneSpace::standard();
+    String error;
+    if (sweepName) {
+        // 单参数扫描: 搜索空间只有这一维
+        String json = "{\"" + String(sweepName) + "\":[" + String(sweepMin) + "," + String(sweepMax) + "]}";
+        if (!space.fromJson(json, error)) {
+            Serial.setMuted(false);
+            Serial.printf("Bad sweep: %s\n", error.c_str());
+            return 1;
+        }
+    } else if (spacePath) {
+        String json;
+        if (!loadFile(spacePath, json) || !space.fromJson(json, error)) {
+            Serial.setMuted(false);
+            Serial.printf("Bad space %s: %s\n", spacePath, error.c_str());
+            return 1;
+        }
+    }
+    Serial.setMuted(false);
+
+    SimScenario scenario = SimScenario::standard();
+    WorkPool pool(threads);
+    Tuner tuner(scenario, space, base, pool, seeds);
+    auto wallStart = std::chrono::steady_clock::now();
+
+    Serial.setMuted(true);
+    TuneEvaluation baseline = tuner.evaluate(base);
+    Serial.setMuted(false);
+    Serial.printf("%d threads, %d dims, %d seeds per candidate\n", pool.getThreads(), (int)space.size(), seeds);
+    printEvaluation("baseline", baseline);
+
+    std::vector<double> bestX = space.normalize(base);
+    TuneEvaluation best = baseline;
+    bool improved = false;
+
+    if (sweepName) {
+        std::vector<std::vector<double>> candidates;
+        for (int i = 0; i < sweepSteps; i++) {
+            candidates.push_back(std::vector<double>(1, (double)i / (sweepSteps - 1)));
+        }
+        Serial.setMuted(true);
+        std::vector<TuneEvaluation> evaluations = tuner.evaluate(candidates);
+        Serial.setMuted(false);
+        for (size_t i = 0; i < candidates.size(); i++) {
+            String label = String(space.value(0, candidates[i][0]));
+            printEvaluation(label.c_str(), evaluations[i]);
+            if (evaluations[i].cost < best.cost) {
+                best = evaluations[i];
+                bestX = candidates[i];
+                improved = true;
+            }
+        }
+    } else {
+        CmaEs cma(bestX, sigma, population, seed);
+        if (population == 0 && cma.getLambda() < pool.getThreads()) {
+            cma = CmaEs(bestX, sigma, pool.getThreads(), seed);   // 一代至少占满所有线程
+        }
+        for (int gen = 0; gen < generations; gen++) {
+            std::vector<std::vector<double>> candidates = cma.ask();
+            Serial.setMuted(true);
+            std::vector<TuneEvaluation> evaluations = tuner.evaluate(candidates);
+            Serial.setMuted(false);
+
+            std::vector<double> costs(candidates.size());
+            double meanCost = 0;
+            size_t genBest = 0;
+            for (size_t i = 0; i < candidates.size(); i++) {
+                costs[i] = evaluations[i].cost + boundaryPenalty(candidates[i]);
+                meanCost += costs[i] / candidates.size();
+                if (costs[i] < costs[genBest]) genBest = i;
+                if (evaluations[i].cost < best.cost) {
+                    best = evaluations[i];
+                    bestX = candidates[i];
+                    improved = true;
+                }
+            }
+            cma.tell(candidates, costs);
+
+            Serial.printf("gen %3d  best=%8.2f mean=%8.2f sigma=%.3f cond=%.1e  overall=%8.2f lap=%.2fs finished=%d/%d\n",
+                          gen + 1, costs[genBest], meanCost, cma.getSigma(), cma.getConditionNumber(),
+                          best.cost, best.lapTimeS, best.finished, best.runs);
+        }
+    }
+
+    float wallSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - wallStart).count();
+    Serial.printf("%llu simulations, %.0f s simulated in %.1f s wall (%.0fx), %llu steals\n",
+                  (unsigned long long)tuner.getSimulations(), tuner.getSimSeconds(), wallSeconds,
+                  tuner.getSimSeconds() / std::max(wallSeconds, 1e-3f), (unsigned long long)pool.getSteals());
+    printEvaluation("best", best);
+
+    if (!improved) {
+        Serial.println("No candidate beat the baseline; nothing written");
+        return 2;
+    }
+
+    for (size_t i = 0; i < space.size(); i++) {
+        Serial.printf("  %s.%s = %g\n", space[i].group.c_str(), space[i].key.c_str(), space.value(i, bestX[i]));
+    }
+
+    Serial.setMuted(true);
+    ParameterManager tuned = space.apply(base, bestX);
+    Serial.setMuted(false);
+    if (!saveFile(outPath, tuned.toJson())) {
+        Serial.printf("Cannot write %s\n", outPath);
+        return 1;
+    }
+    Serial.printf("Wrote %s\n", outPath);
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "Bench.h"
+#include <ArduinoJson.h>
+#include <new>
+
+volatile uint32_t benchAllocCount = 0;
+
+// ==================== 分配计数 ====================
+
+#ifdef ARDUINO_ARCH_ESP32
+// 板上: 链接参数 -Wl,--wrap=malloc,--wrap=realloc,--wrap=calloc (见 platformio.ini env:bench_esp32)
+// operator new 与 Arduino String 最终都落到这三个函数
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __real_calloc(size_t n, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    benchAllocCount++;
+    return __real_malloc(size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    benchAllocCount++;
+    return __real_realloc(ptr, size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    benchAllocCount++;
+    return __real_calloc(n, size);
+}
+}
+#else
+// 主机: 替换全局 operator new (String 兼容层基于 std::string, 短字符串不分配, 与板上数字会有差异)
+void* operator new(size_t size) {
+    benchAllocCount++;
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    benchAllocCount++;
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+#endif
+
+// ==================== BenchRunner ====================
+
+BenchRunner::BenchRunner() {
+    results.reserve(32);
+}
+
+void BenchRunner::record(const char* name, uint32_t iterations, float nsPerCall, float allocsPerCall) {
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerCall = nsPerCall;
+    result.allocsPerCall = allocsPerCall;
+    results.push_back(result);
+}
+
+String BenchRunner::toJson() {
+    JsonDocument doc;
+#ifdef ARDUINO_ARCH_ESP32
+    doc["platform"] = "esp32";
+#else
+    doc["platform"] = "host";
+#endif
+    doc["cyclesPerUs"] = profiler.getCyclesPerUs();
+
+    JsonObject benches = doc["benches"].to<JsonObject>();
+    for (const BenchResult& r : results) {
+        JsonObject b = benches[r.name].to<JsonObject>();
+        b["ns"] = roundf(r.nsPerCall * 10) / 10;
+        b["allocs"] = roundf(r.allocsPerCall * 1000) / 1000;
+        b["iterations"] = r.iterations;
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+int BenchRunner::compare(String baselineJson, float tolerance) {
+    JsonDocument baseline;
+    DeserializationError error = deserializeJson(baseline, baselineJson);
+    if (error) {
+        Serial.print("Baseline parse error: ");
+        Serial.println(error.c_str());
+        return -1;
+    }
+
+    int regressions = 0;
+    for (const BenchResult& r : results) {
+        JsonObject b = baseline["benches"][r.name];
+        if (b.isNull()) continue;   // 新增项没有基线
+
+        float baseNs = b["ns"] | 0.0f;
+        float baseAllocs = b["allocs"] | 0.0f;
+        bool slower = baseNs > 0 && r.nsPerCall > baseNs * (1.0f + tolerance);
+        bool allocates = r.allocsPerCall > baseAllocs + 0.001f;
+        if (slower || allocates) {
+            regressions++;
+            Serial.printf("REGRESSION %-34s %9.1f ns (base %.1f)  %.3f allocs (base %.3f)\n",
+                          r.name, r.nsPerCall, baseNs, r.allocsPerCall, baseAllocs);
+        }
+    }
+    return regressions;
+}
@@ -0,0 +1,124 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+#include <vector>
+#include "Profiler.h"
+#include "config.h"
+#include "hal/Hal.h"
+
+// 堆分配计数 (Bench.cpp): 主机替换 operator new, 板上用 --wrap=malloc/realloc/calloc
+extern volatile uint32_t benchAllocCount;
+
+struct BenchResult {
+    const char* name;
+    uint32_t iterations;
+    float nsPerCall;
+    float allocsPerCall;
+};
+
+// 微基准: 自动加倍迭代次数直到单批耗时超过 BENCH_TARGET_US, 记录 ns/次 与 分配/次
+// 计时使用 Profiler::now() (板上为CPU周期计数, 主机为纳秒)
+class BenchRunner {
+public:
+    static const uint32_t BENCH_TARGET_US = 20000;
+
+    BenchRunner();
+
+    template <typename F>
+    void run(const char* name, F&& body) {
+        for (uint32_t i = 0; i < 64; i++) body(i);   // 预热
+
+        uint32_t iterations = 64;
+        while (true) {
+            uint32_t allocStart = benchAllocCount;
+            uint32_t start = Profiler::now();
+            for (uint32_t i = 0; i < iterations; i++) body(i);
+            uint32_t cycles = Profiler::now() - start;
+            uint32_t allocs = benchAllocCount - allocStart;
+
+            float us = (float)cycles / profiler.getCyclesPerUs();
+            if (us >= BENCH_TARGET_US || iterations >= (1u << 24)) {
+                record(name, iterations, us * 1000.0f / iterations, (float)allocs / iterations);
+                return;
+            }
+            iterations *= 2;
+        }
+    }
+
+    String toJson();
+
+    // 与基线JSON比较: ns/次 超过 (1+tolerance) 倍或分配次数增加视为回退, 返回回退项数量
+    int compare(String baselineJson, float tolerance);
+
+private:
+    Profiler profiler;
+    std::vector<BenchResult> results;
+
+    void record(const char* name, uint32_t iterations, float nsPerCall, float allocsPerCall);
+};
+
+// 基准用的空外设 (板上/主机通用, 不驱动真实硬件)
+class BenchUart : public HalUart {
+public:
+    uint8_t response = 0x18;   // 每次数字请求应答的循迹状态
+    uint8_t analogFrame[LINE_ANALOG_FRAME_SIZE] = {};   // 模拟量请求的应答帧
+
+    void begin(uint32_t baud) override {}
+    int available() override { return pendingLen - pendingPos; }
+    int read() override { return pendingPos < pendingLen ? pending[pendingPos++] : -1; }
+    size_t readBytes(uint8_t* buf, size_t len) override {
+        size_t n = min(len, (size_t)(pendingLen - pendingPos));
+        memcpy(buf, pending + pendingPos, n);
+        pendingPos += n;
+        return n;
+    }
+    size_t write(uint8_t byte) override {
+        pendingPos = 0;
+        pendingLen = 0;
+        if (byte == LINE_CMD_DIGITAL) {
+            pending = &response;
+            pendingLen = 1;
+        } else if (byte == LINE_CMD_ANALOG) {
+            pending = analogFrame;
+            pendingLen = LINE_ANALOG_FRAME_SIZE;
+        } else if (byte == LINE_CMD_STREAM_DIGITAL || byte == LINE_CMD_STREAM_ANALOG) {
+            streamCommand = byte;
+        } else if (byte == LINE_CMD_MANUAL) {
+            streamCommand = 0;
+        }
+        return 1;
+    }
+    // 连续输出模式: 模拟模块发出一帧
+    void streamFrame() {
+        pendingPos = 0;
+        pending = streamCommand == LINE_CMD_STREAM_ANALOG ? analogFrame : &response;
+        pendingLen = streamCommand == LINE_CMD_STREAM_ANALOG ? LINE_ANALOG_FRAME_SIZE : 1;
+    }
+    int availableForWrite() override { return 128; }
+
+private:
+    uint8_t streamCommand = 0;
+    const uint8_t* pending = nullptr;
+    int pendingLen = 0;
+    int pendingPos = 0;
+};
+
+class BenchPwm : public HalPwm {
+public:
+    void setup(uint8_t channel, uint8_t pin, uint32_t freq, uint8_t resolution) override {}
+    void write(uint8_t channel, uint32_t duty) override {}
+};
+
+class BenchEncoder : public HalEncoder {
+public:
+    int64_t count = 0;
+    bool edges = false;          // true 时提供边沿计时 (测T法路径)
+    HalEdgeTiming timing = {0, 0};
+    void attach(int pinA, int pinB) override {}
+    int64_t getCount() override { return count; }
+    void clearCount() override { count = 0; }
+    bool getEdgeTiming(HalEdgeTiming& out) override { out = timing; return edges; }
+};
+
+#endif
@@ -0,0 +1,419 @@
+// 控制热路径微基准: ns/次 + 堆分配/次, 结果输出JSON
+// 板上时钟不能推进, 带时间门限的接口一律测无门限路径 (computeAt / update(nowUs) / 跳过请求限频),
+// 只有 pid.compute 测的是 millis() 门限后的计算 (仅主机, 每次推进10ms)
+// 主机: pio run -e bench && .pio/build/bench/program [--baseline bench.json] [--tolerance 0.25]
+// 板上: pio run -e bench_esp32 -t upload && pio device monitor  (结果从串口输出)
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "LineSensor.h"
+#include "MotorControl.h"
+#include "PIDController.h"
+#include "ObjectDetector.h"
+#include "TaskManager.h"
+#include "ParameterManager.h"
+#include "Telemetry.h"
+#include "TrackFeatures.h"
+#include "LineEstimator.h"
+#include "WheelSpeedEstimator.h"
+#include "GainScheduler.h"
+#include "Odometry.h"
+#include "HeadingEstimator.h"
+#include "MotionProfile.h"
+#include "AvoidPath.h"
+#include "TrackMap.h"
+#include "Bench.h"
+#ifndef ARDUINO_ARCH_ESP32
+#include <fstream>
+#include <sstream>
+#include "hal/host/HostHal.h"
+#endif
+
+static BenchUart lineUart;
+static BenchPwm motorPwm;
+static BenchEncoder leftEncoder;
+static BenchEncoder rightEncoder;
+
+static LineSensor lineSensor(&lineUart);
+static MotorControl motor(&motorPwm, &leftEncoder, &rightEncoder);
+static PIDController pidController(KP_LINE, KI_LINE, KD_LINE);
+static LaserRing laserRing;
+static ObjectDetector objectDetector(&laserRing, &motor);
+static TaskManager taskManager;
+static ParameterManager params;
+static TrackFeatures trackFeatures;
+static LineEstimator lineEstimator;
+
+// 直接调用 ObjectDetector 的内部算法 (ObjectDetector.h 中声明为友元)
+class ObjectDetectorBench {
+public:
+    static void fillBuffers(ObjectDetector& d) {
+        d.sampleCount = 0;
+        for (int i = 0; i < ObjectDetector::MAX_SAMPLES; i++) {
+            d.addDistanceSample(80 + (i * 37) % 41);
+        }
+        for (int i = 0; i < ObjectDetector::HISTORY_SIZE; i++) {
+            d.pushHistory(i < ObjectDetector::HISTORY_SIZE / 2 ? 8190 : 90, i * 4.0f, i * 20);
+        }
+    }
+    static uint16_t filtered(ObjectDetector& d, uint16_t raw) { return d.getFilteredDistance(raw); }
+    static float median(ObjectDetector& d) { return d.calculateMedianDistance(); }
+    static float crossing(ObjectDetector& d, bool entering) { return d.findPreciseCrossingPoint(entering, 300); }
+};
+
+// 循迹请求每4ms限频一次: 每次迭代先让门限过期, 再走一遍 发请求 + 读应答
+class LineSensorBench {
+public:
+    static void exchange(LineSensor& s) {
+        s.lastRequestTime = millis() - 4;
+        s.update();
+        s.update();
+    }
+};
+
+// 主机上虚拟时钟不随执行前进, 需要时手动推进一个控制周期
+static void advanceControlPeriod() {
+#ifndef ARDUINO_ARCH_ESP32
+    hostClockAdvance(1000000 / CONTROL_LOOP_HZ);
+#endif
+}
+
+static volatile float sink;   // 防止结果被优化掉
+
+static void runBenches(BenchRunner& bench) {
+    const int16_t positions[] = {0, 120, -250, 400, -700, 950, -30, 60};
+
+    // ---------- PID ----------
+    pidController.setOutputLimits(-255, 255);
+#ifndef ARDUINO_ARCH_ESP32
+    // millis() 时基: 不足10ms直接返回上次输出, 每次推进10ms保证测到完整计算
+    bench.run("pid.compute", [&](uint32_t i) {
+        hostClockAdvance(10000);
+        sink = pidController.compute(positions[i & 7]);
+    });
+#endif
+    // 外部给出变化率时没有10ms门限
+    bench.run("pid.compute.rate", [&](uint32_t i) {
+        advanceControlPeriod();
+        sink = pidController.compute(positions[i & 7], positions[(i + 1) & 7] * 4.0f);
+    });
+    // 微秒时基: 每个周期一帧 (微分滤波 + 反算抗饱和 + 无扰切换衰减)
+    pidController.reset();
+    bench.run("pid.computeAt", [&](uint32_t i) {
+        sink = pidController.computeAt(positions[i & 7], i * (1000000 / CONTROL_LOOP_HZ));
+    });
+
+    // 增益调度: 输入每周期变化 (每次都重新插值) / 输入不变 (只比较量化键)
+    GainScheduler gainScheduler;
+    bench.run("gainScheduler.update", [&](uint32_t i) {
+        sink = gainScheduler.update(params.gainSchedule, params.gainRevision, GAIN_PHASE_PRE,
+                                    (i & 63) * 20.0f, positions[i & 7], KP_LINE, KI_LINE, KD_LINE);
+    });
+    bench.run("gainScheduler.update.cached", [&](uint32_t i) {
+        sink = gainScheduler.update(params.gainSchedule, params.gainRevision, GAIN_PHASE_PRE,
+                                    600.0f, 40.0f, KP_LINE, KI_LINE, KD_LINE);
+    });
+
+    // ---------- 电机 (时间戳按控制周期给出, 轮速闭环每次都运行) ----------
+    uint32_t motorUs = micros();
+    bench.run("motor.update", [&](uint32_t i) {
+        motorUs += 1000000 / CONTROL_LOOP_HZ;
+        leftEncoder.count += 9;
+        rightEncoder.count += 8;
+        motor.update(motorUs);
+    });
+    motor.setVelocity(800, 760);
+    bench.run("motor.update.velocity", [&](uint32_t i) {
+        motorUs += 1000000 / CONTROL_LOOP_HZ;
+        leftEncoder.count += 9;
+        rightEncoder.count += 8;
+        motor.update(motorUs);
+    });
+    motor.stop();
+
+    // 低速 (约100mm/s): 每周期不到一个脉冲, 以沿间隔测速
+    BenchEncoder slowEncoder;
+    slowEncoder.edges = true;
+    WheelSpeedEstimator wheelSpeed(&slowEncoder);
+    bench.run("wheelSpeed.update", [&](uint32_t i) {
+        uint32_t now = i * (1000000 / CONTROL_LOOP_HZ);
+        if ((i & 3) == 0) {
+            slowEncoder.count += 1;
+            if ((i & 15) == 0) {
+                slowEncoder.timing.periodUs = now - slowEncoder.timing.lastEdgeUs;
+                slowEncoder.timing.lastEdgeUs = now;
+            }
+        }
+        wheelSpeed.update(now);
+        sink = wheelSpeed.getSpeed();
+    });
+
+    // 里程计: 每周期两轮各走几个脉冲 (缓慢左转)
+    Odometry odometry;
+    int64_t odomLeft = 0, odomRight = 0;
+    bench.run("odometry.update", [&](uint32_t i) {
+        odomLeft += 8;
+        odomRight += 9;
+        odometry.update(odomLeft, odomRight);
+        sink = odometry.getPose().x;
+    });
+
+    // 航向融合: 每周期取走一批 (1600Hz/500Hz 约3帧), 行驶中修正零偏
+    GyroRing gyroRing;
+    GyroPublisher gyroPublisher(&gyroRing);
+    HeadingEstimator heading;
+    heading.setSource(&gyroRing);
+    bench.run("heading.update", [&](uint32_t i) {
+        gyroPublisher.publishSum(3 * 40, 3, micros());
+        sink = heading.update(0.0005f, false);
+    });
+
+    // 速度曲线: 每个动作约几百个周期, 走完后重新开始 (含刹车距离计算的最坏情况)
+    MotionProfile profile;
+    profile.setLimits(600, MOTION_ACCEL_DEFAULT, MOTION_JERK_DEFAULT);
+    bench.run("motionProfile.step", [&](uint32_t i) {
+        if (profile.isDone()) {
+            profile.start(500);
+        }
+        sink = profile.step(0.002f).vel;
+    });
+
+    // 圆弧绕行: 沿路径每周期前进约1mm, 纯追踪 + 弯道限速
+    AvoidPath avoidPath;
+    AvoidGeometry geometry = {400, OBSTACLE_LENGTH_CM * 10, 300, AVOID_RADIUS_MM, AVOID_MARGIN_MM};
+    avoidPath.plan(geometry);
+    float pathS = 0;
+    bench.run("avoidPath.track", [&](uint32_t i) {
+        pathS += 1.0f;
+        if (pathS > avoidPath.getLength()) {
+            avoidPath.plan(geometry);
+            pathS = 0;
+        }
+        PathPoint p = avoidPath.pointAt(pathS);
+        sink = avoidPath.track(p.x, p.y + 5, p.heading, AVOID_LOOKAHEAD_MM) +
+               avoidPath.speedLimit(700, AVOID_LAT_ACCEL, MOTION_ACCEL_DEFAULT);
+    });
+
+    // 赛道学习: 录制一圈 (直道 + 半径400mm的半圆, 每周期约2mm), 之后每周期查速度曲线
+    TrackMap trackMap;
+    trackMap.begin();
+    trackMap.lapMark(0, true);
+    Pose lapPose = {0, 0, 0, 0};
+    while (lapPose.distance < 4000) {
+        lapPose.distance += 2;
+        if (lapPose.distance > 2000 && lapPose.distance < 2000 + 400 * PI) {
+            lapPose.heading += 2.0f / 400;
+        }
+        trackMap.record(lapPose, 0, true, true);
+    }
+    trackMap.lapMark(lapPose.distance, true);
+    trackMap.computeProfile(TRACK_LAT_ACCEL, MOTION_ACCEL_DEFAULT, MOTION_ACCEL_DEFAULT);
+    float lapS = lapPose.distance;
+    bench.run("trackMap.speedAt", [&](uint32_t i) {
+        lapS += 2.0f;
+        if (trackMap.getLapDistance(lapS) > trackMap.getLength()) {
+            trackMap.lapMark(lapS, true);
+        }
+        sink = trackMap.speedAt(lapS, TRACK_LOOKAHEAD_MM);
+    });
+
+    // ---------- 循迹 ----------
+    for (int i = 0; i < 4; i++) {
+        advanceControlPeriod();
+        advanceControlPeriod();
+        lineSensor.update();
+    }
+    bench.run("lineSensor.getLinePosition", [&](uint32_t i) {
+        sink = lineSensor.getLinePosition();
+    });
+    // 一次完整的 请求 + 应答解析 (两次 update)
+    bench.run("lineSensor.update", [&](uint32_t i) {
+        advanceControlPeriod();
+        LineSensorBench::exchange(lineSensor);
+    });
+
+    // 模拟量帧: 线压在通道3/4之间, 校验和按模块协议计算
+    const uint16_t analog[LINE_SENSOR_COUNT] = {410, 395, 820, 3350, 2980, 640, 402, 388};
+    uint8_t* frame = lineUart.analogFrame;
+    frame[0] = LINE_FRAME_HEAD;
+    frame[1] = LINE_FRAME_HEAD;
+    frame[2] = 1;
+    frame[3] = LINE_ANALOG_DATA_LEN;
+    uint8_t sum = frame[2] + frame[3];
+    for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
+        frame[4 + i * 2] = analog[i] >> 8;
+        frame[5 + i * 2] = analog[i] & 0xFF;
+        sum += frame[4 + i * 2] + frame[5 + i * 2];
+    }
+    frame[LINE_ANALOG_FRAME_SIZE - 1] = ~sum;
+    lineSensor.setMode(LINE_MODE_ANALOG);
+    bench.run("lineSensor.update.analog", [&](uint32_t i) {
+        advanceControlPeriod();
+        LineSensorBench::exchange(lineSensor);
+    });
+    bench.run("lineSensor.getLinePosition.analog", [&](uint32_t i) {
+        sink = lineSensor.getLinePosition();
+    });
+
+    // 连续输出: 逐字节解析 + 环形缓冲区 + 取最新帧
+    lineSensor.setStreaming(true);
+    bench.run("lineSensor.update.stream", [&](uint32_t i) {
+        advanceControlPeriod();
+        lineUart.streamFrame();
+        lineSensor.update();
+    });
+    lineSensor.setStreaming(false);
+    lineSensor.setMode(LINE_MODE_DIGITAL);
+
+    // 赛道特征: 每32帧经过一次横线 (4帧全黑)
+    LineSnapshot snapshot = {};
+    bench.run("trackFeatures.update", [&](uint32_t i) {
+        bool bar = (i & 31) < 4;
+        snapshot.states = bar ? 0xFF : 0x18;
+        snapshot.activeCount = bar ? 8 : 2;
+        snapshot.found = true;
+        snapshot.seq = i;
+        sink = trackFeatures.update(snapshot, i * 2.0f);
+    });
+
+    // 线状态估计: 2ms一帧, 量化位置
+    LineSnapshot estSnapshot = {};
+    bench.run("lineEstimator.update", [&](uint32_t i) {
+        estSnapshot.position = positions[i & 7];
+        estSnapshot.found = true;
+        estSnapshot.seq = i;
+        estSnapshot.timestampUs = i * 2000;
+        lineEstimator.update(estSnapshot);
+        sink = lineEstimator.getRate();
+    });
+
+    // ---------- 物块检测 ----------
+    objectDetector.setLogCallback([](String message) {});
+    objectDetector.setFilterSize(params.objectFilterSize);
+    objectDetector.startDetection(0, params.objectDetectDist);
+    bench.run("objectDetector.update", [&](uint32_t i) {
+        advanceControlPeriod();
+        // 每400个周期经过一次物块 (约150个周期在物块内)
+        uint32_t phase = i % 400;
+        LaserSample sample;
+        sample.timestampUs = micros();
+        sample.raw = (phase >= 100 && phase < 250) ? 90 + (i & 7) : 8190;
+        sample.filtered = sample.raw;
+        laserRing.push(sample);
+        leftEncoder.count += 3;
+        rightEncoder.count += 3;
+        if (!objectDetector.isDetecting()) {
+            objectDetector.startDetection(0, params.objectDetectDist);
+        }
+        objectDetector.update(positions[i & 7]);
+    });
+    objectDetector.stopDetection();
+
+    ObjectDetectorBench::fillBuffers(objectDetector);
+    bench.run("objectDetector.getFilteredDistance", [&](uint32_t i) {
+        sink = ObjectDetectorBench::filtered(objectDetector, 80 + (i & 31));
+    });
+    bench.run("objectDetector.calculateMedianDistance", [&](uint32_t i) {
+        sink = ObjectDetectorBench::median(objectDetector);
+    });
+    bench.run("objectDetector.findPreciseCrossingPoint", [&](uint32_t i) {
+        sink = ObjectDetectorBench::crossing(objectDetector, i & 1);
+    });
+
+    // ---------- 任务管理 (执行中, 每周期检查完成条件) ----------
+    TaskParams taskParams;
+    taskParams.distance = 500;
+    taskParams.angle = 0;
+    taskParams.speed = 120;
+    taskParams.duration = 0;
+    taskParams.laserBaseline = 800;
+    taskParams.laserThreshold = 100;
+    taskManager.addTask(TASK_FORWARD, taskParams, "forward");
+    taskManager.setTaskExecutor([](Task* task) { return true; });
+    taskManager.setTaskChecker([](Task* task) { return false; });
+    taskManager.startExecution();
+    bench.run("taskManager.update", [&](uint32_t i) {
+        advanceControlPeriod();
+        taskManager.update();
+    });
+    taskManager.stopExecution();
+
+    // ---------- 参数JSON (只解析赋值, 不写NVS也不打印) ----------
+    String paramsJson = params.toJson();
+    bench.run("params.toJson", [&](uint32_t i) {
+        sink = params.toJson().length();
+    });
+    bench.run("params.applyJson", [&](uint32_t i) {
+        sink = params.applyJson(paramsJson);
+    });
+
+    // ---------- 状态JSON (原 getSystemStatus, 现为遥测记录序列化) ----------
+    TelemetryRecord rec = {};
+    rec.state = STATE_LINE_FOLLOW;
+    rec.flags = TELEM_RUNNING | TELEM_LINE_READY | TELEM_LASER_READY | TELEM_ULTRA_VALID;
+    rec.linePos = 120;
+    rec.laserDist = 812;
+    rec.loopFreq = CONTROL_LOOP_HZ;
+    bench.run("telemetryToJson", [&](uint32_t i) {
+        rec.seq = i;
+        JsonDocument doc;
+        telemetryToJson(rec, doc.to<JsonObject>());
+        String output;
+        serializeJson(doc, output);
+        sink = output.length();
+    });
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    Serial.println("Running benchmarks...");
+
+    // 参数使用构造函数默认值: 不调用 params.begin(), 基准过程中不读写NVS
+    BenchRunner bench;
+    runBenches(bench);
+    Serial.println(bench.toJson());
+}
+
+void loop() {
+    delay(1000);
+}
+
+#else
+
+int main(int argc, char** argv) {
+    const char* baselinePath = nullptr;
+    float tolerance = 0.25f;
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        }
+    }
+
+    BenchRunner bench;
+    Serial.setMuted(true);
+    runBenches(bench);
+    Serial.setMuted(false);
+    Serial.println(bench.toJson());
+
+    if (baselinePath) {
+        std::ifstream file(baselinePath);
+        if (!file) {
+            Serial.printf("Cannot read %s\n", baselinePath);
+            return 1;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        int regressions = bench.compare(String(buffer.str()), tolerance);
+        return regressions == 0 ? 0 : 1;
+    }
+    return 0;
+}
+
+#endif
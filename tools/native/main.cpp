@@ -0,0 +1,138 @@
+// 主机端冒烟运行 + 热路径计时 (pio run -e native && .pio/build/native/program)
+// 控制核心通过 hal/host 的仿真外设运行, 时间由虚拟时钟推进
+
+#include <Arduino.h>
+#include <chrono>
+#include "config.h"
+#include "LineSensor.h"
+#include "MotorControl.h"
+#include "PIDController.h"
+#include "ObjectDetector.h"
+#include "TaskManager.h"
+#include "hal/host/HostHal.h"
+
+static HostUart lineUart;
+static HostPwm motorPwm;
+static HostEncoder leftEncoder;
+static HostEncoder rightEncoder;
+
+static LineSensor lineSensor(&lineUart);
+static MotorControl motor(&motorPwm, &leftEncoder, &rightEncoder);
+static PIDController pid(KP_LINE, KI_LINE, KD_LINE);
+static LaserRing laserRing;
+static ObjectDetector detector(&laserRing, &motor);
+static TaskManager taskManager;
+
+// 循迹模块应答: 收到读取指令(1)后返回一个状态字节
+static uint8_t simulatedStates = 0x18;
+
+template <typename F>
+static double measureNs(int iterations, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        body(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+static void setDistance(float mm) {
+    int64_t pulses = (int64_t)(mm / MM_PER_PULSE);
+    leftEncoder.setCount(pulses);
+    rightEncoder.setCount(pulses);
+}
+
+// 循迹 -> PID -> 电机 的单周期耗时
+static void benchLineLoop() {
+    const uint8_t pattern[] = {0x18, 0x0C, 0x06, 0x03, 0x01, 0x00, 0x80, 0xC0, 0x60, 0x30};
+    const int iterations = 1000000;
+
+    Serial.setMuted(true);
+    double ns = measureNs(iterations, [&](int i) {
+        simulatedStates = pattern[(i / 50) % sizeof(pattern)];
+        hostClockAdvance(1000000 / CONTROL_LOOP_HZ);
+        lineSensor.update();
+        motor.update();
+        int16_t position = lineSensor.getLinePosition();
+        float correction = pid.compute(position);
+        motor.setDifferentialSpeed(SPEED_NORMAL, (int)correction);
+    });
+    Serial.setMuted(false);
+
+    Serial.printf("line loop:       %8.1f ns/cycle  (PWM L1=%u R1=%u)\n",
+                  ns, motorPwm.getDuty(PWM_CHANNEL_L1), motorPwm.getDuty(PWM_CHANNEL_R1));
+}
+
+// 物块检测: 匀速经过一个已知长度的物块, 检查测量结果
+static void runObjectDetection() {
+    const float speedMmS = 300.0f;
+    const float blockStart = 200.0f;
+    const float blockLength = 600.0f;
+    const float runLength = 1100.0f;
+    const uint32_t stepUs = 1000000 / CONTROL_LOOP_HZ;
+
+    setDistance(0);
+    Serial.setMuted(true);
+    detector.startDetection(800, 150);
+
+    uint64_t startUs = hostClockMicros();
+    uint64_t lastSampleUs = startUs;
+    float distance = 0;
+    while (distance < runLength && detector.isDetecting()) {
+        hostClockAdvance(stepUs);
+        uint64_t now = hostClockMicros();
+        distance = speedMmS * (now - startUs) / 1e6f;
+        setDistance(distance);
+
+        if (now - lastSampleUs >= LASER_PERIOD_MS * 1000) {
+            lastSampleUs = now;
+            bool inBlock = distance >= blockStart && distance < blockStart + blockLength;
+            LaserSample sample;
+            sample.timestampUs = (uint32_t)now;
+            sample.raw = inBlock ? 60 : 8190;
+            sample.filtered = sample.raw;
+            laserRing.push(sample);
+        }
+        detector.update(0);
+    }
+    Serial.setMuted(false);
+
+    ObjectMeasurement result = detector.getResult();
+    Serial.printf("object detect:   length=%.1fmm (true %.0fmm) valid=%d state=%s\n",
+                  result.length, blockLength, result.valid,
+                  detector.isCompleted() ? "completed" : "not completed");
+}
+
+// 任务队列JSON往返
+static void runTaskJson() {
+    const char* json = "{\"tasks\":["
+        "{\"type\":2,\"description\":\"forward\",\"params\":{\"distance\":500,\"speed\":120}},"
+        "{\"type\":4,\"description\":\"left\",\"params\":{\"angle\":90,\"speed\":100}}]}";
+
+    Serial.setMuted(true);
+    bool ok = taskManager.loadTasksFromJson(json);
+    Serial.setMuted(false);
+
+    Serial.printf("task json:       loaded=%d total=%d\n", ok, taskManager.getTotalTasks());
+    Serial.println("                 " + taskManager.getTasksJson());
+}
+
+int main() {
+    lineUart.setResponder([](uint8_t request, HostUart& uart) {
+        if (request == 1) {
+            uart.inject(&simulatedStates, 1);
+        }
+    });
+
+    Serial.setMuted(true);
+    lineSensor.begin();
+    motor.begin();
+    Serial.setMuted(false);
+
+    pid.setOutputLimits(-255, 255);
+
+    benchLineLoop();
+    runObjectDetection();
+    runTaskJson();
+    return 0;
+}
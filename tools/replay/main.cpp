@@ -0,0 +1,129 @@
+// 物块检测回放: 同一段录制分别用录制参数 (A) 与覆盖后的参数 (B) 重跑 ObjectDetector
+// pio run -e replay && .pio/build/replay/program detect.srec [params.json]
+//     [--filter N] [--threshold N] [--stable N] [--scale X] [--offset X] [--devcorr X] [--verbose]
+// detect.srec 从网页 /api/record 下载; params.json 与 /api/params 导出格式相同, 只取物块检测相关字段
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "ParameterManager.h"
+#include "SensorReplay.h"
+
+static bool loadFile(const char* path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+static void resultToJson(JsonObject out, const ReplayConfig& config, const ObjectMeasurement& result,
+                         DetectionState state) {
+    JsonObject cfg = out["config"].to<JsonObject>();
+    cfg["threshold"] = config.threshold;
+    cfg["filter"] = config.filterSize;
+    cfg["stable"] = config.stableCount;
+    cfg["scale"] = config.lengthScale;
+    cfg["offset"] = config.lengthOffset;
+    cfg["devCorr"] = config.deviationCorrection;
+    out["state"] = (int)state;
+    out["valid"] = result.valid;
+    out["length"] = roundf(result.length * 10) / 10;
+    out["avgDistance"] = roundf(result.avgDistance * 10) / 10;
+    out["startPos"] = roundf(result.startPos * 10) / 10;
+    out["endPos"] = roundf(result.endPos * 10) / 10;
+    out["duration"] = result.duration;
+}
+
+int main(int argc, char** argv) {
+    const char* recordingPath = nullptr;
+    const char* paramsPath = nullptr;
+    bool verbose = false;
+    bool overridden = false;
+    std::vector<std::pair<String, const char*>> overrides;
+
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        if (arg.startsWith("--") && arg != "--verbose" && i + 1 < argc) {
+            overrides.push_back({arg, argv[++i]});
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (!recordingPath) {
+            recordingPath = argv[i];
+        } else {
+            paramsPath = argv[i];
+        }
+    }
+    if (!recordingPath) {
+        Serial.println("Usage: replay detect.srec [params.json] [--filter N] [--threshold N] [--stable N] "
+                       "[--scale X] [--offset X] [--devcorr X] [--verbose]");
+        return 1;
+    }
+
+    std::string data;
+    if (!loadFile(recordingPath, data)) {
+        Serial.printf("Cannot read %s\n", recordingPath);
+        return 1;
+    }
+
+    SensorReplay replay;
+    if (!verbose) {
+        replay.setLogCallback([](String message) {});
+    }
+    if (!replay.load((const uint8_t*)data.data(), data.size())) {
+        Serial.printf("Invalid recording: %s\n", replay.getError());
+        return 1;
+    }
+
+    // B 组参数: 录制参数 <- params.json <- 命令行
+    ReplayConfig recorded = replay.getConfig();
+    ReplayConfig candidate = recorded;
+    if (paramsPath) {
+        std::string json;
+        if (!loadFile(paramsPath, json)) {
+            Serial.printf("Cannot read %s\n", paramsPath);
+            return 1;
+        }
+        ParameterManager params;
+        params.fromJson(String(json));
+        candidate.filterSize = params.objectFilterSize;
+        candidate.lengthScale = params.objectLengthScale;
+        candidate.lengthOffset = params.objectLengthOffset;
+        candidate.deviationCorrection = params.objectDeviationCorrection;
+        overridden = true;
+    }
+    for (auto& o : overrides) {
+        if (o.first == "--filter") candidate.filterSize = atoi(o.second);
+        else if (o.first == "--threshold") candidate.threshold = atoi(o.second);
+        else if (o.first == "--stable") candidate.stableCount = atoi(o.second);
+        else if (o.first == "--scale") candidate.lengthScale = atof(o.second);
+        else if (o.first == "--offset") candidate.lengthOffset = atof(o.second);
+        else if (o.first == "--devcorr") candidate.deviationCorrection = atof(o.second);
+        else {
+            Serial.printf("Unknown option %s\n", o.first.c_str());
+            return 1;
+        }
+        overridden = true;
+    }
+
+    const SensorRecordingHeader& header = replay.getHeader();
+    JsonDocument doc;
+    doc["records"] = header.count;
+    doc["dropped"] = header.dropped;
+
+    ObjectMeasurement a = replay.run(recorded);
+    resultToJson(doc["a"].to<JsonObject>(), recorded, a, replay.getFinalState());
+    if (overridden) {
+        ObjectMeasurement b = replay.run(candidate);
+        resultToJson(doc["b"].to<JsonObject>(), candidate, b, replay.getFinalState());
+        doc["deltaLength"] = roundf((b.length - a.length) * 10) / 10;
+    }
+
+    String output;
+    serializeJson(doc, output);
+    Serial.println(output);
+    return a.valid ? 0 : 2;
+}
@@ -0,0 +1,264 @@
+#include "SimWorld.h"
+#include "config.h"
+
+static const float DEG = (float)PI / 180.0f;
+static const float ARC_STEP_DEG = 5.0f;   // 圆弧离散步长
+
+// ==================== SimTrack ====================
+
+SimTrack::SimTrack() {
+    cursor = {0, 0};
+    cursorHeading = 0;
+    lineWidth = 18.0f;   // 常见黑胶带宽度
+}
+
+void SimTrack::addPoint(Vec2 p) {
+    float length = 0;
+    if (!points.empty()) {
+        Vec2 last = points.back();
+        length = cumulative.back() + hypotf(p.x - last.x, p.y - last.y);
+        bounds.push_back({std::min(last.x, p.x), std::min(last.y, p.y),
+                          std::max(last.x, p.x), std::max(last.y, p.y), nullptr});
+    }
+    points.push_back(p);
+    cumulative.push_back(length);
+    cursor = p;
+}
+
+void SimTrack::start(float x, float y, float headingDeg) {
+    points.clear();
+    cumulative.clear();
+    bounds.clear();
+    cursorHeading = headingDeg * DEG;
+    addPoint({x, y});
+}
+
+void SimTrack::straight(float lengthMm) {
+    addPoint({cursor.x + lengthMm * cosf(cursorHeading),
+              cursor.y + lengthMm * sinf(cursorHeading)});
+}
+
+void SimTrack::arc(float radiusMm, float angleDeg) {
+    // 圆心在当前朝向的左侧(左转)或右侧(右转)
+    float side = angleDeg >= 0 ? 1.0f : -1.0f;
+    Vec2 center = {cursor.x - side * radiusMm * sinf(cursorHeading),
+                   cursor.y + side * radiusMm * cosf(cursorHeading)};
+    float startAngle = cursorHeading - side * (float)PI / 2;
+
+    int steps = (int)ceilf(fabsf(angleDeg) / ARC_STEP_DEG);
+    for (int i = 1; i <= steps; i++) {
+        float a = startAngle + angleDeg * DEG * i / steps;
+        addPoint({center.x + radiusMm * cosf(a), center.y + radiusMm * sinf(a)});
+    }
+    cursorHeading += angleDeg * DEG;
+}
+
+// 第 i 段 (points[i] -> points[i+1]) 到点的距离平方
+float SimTrack::segmentDistance2(size_t i, Vec2 p, float* t) const {
+    Vec2 a = points[i];
+    Vec2 b = points[i + 1];
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float len2 = dx * dx + dy * dy;
+    float u = len2 > 0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / len2 : 0;
+    u = constrain(u, 0.0f, 1.0f);
+    float ex = a.x + u * dx - p.x;
+    float ey = a.y + u * dy - p.y;
+    if (t) *t = u;
+    return ex * ex + ey * ey;
+}
+
+float SimTrack::distanceTo(Vec2 p, float* progress) const {
+    float best = 1e18f;
+    float bestRadius = 1e9f;
+    float bestProgress = 0;
+    for (size_t i = 0; i < bounds.size(); i++) {
+        const SimBox& box = bounds[i];
+        if (p.x < box.x0 - bestRadius || p.x > box.x1 + bestRadius ||
+            p.y < box.y0 - bestRadius || p.y > box.y1 + bestRadius) {
+            continue;
+        }
+        float t;
+        float d = segmentDistance2(i, p, &t);
+        if (d < best) {
+            best = d;
+            bestRadius = sqrtf(d);
+            bestProgress = cumulative[i] + t * (cumulative[i + 1] - cumulative[i]);
+        }
+    }
+    if (progress) *progress = bestProgress;
+    return sqrtf(best);
+}
+
+// 点到线段 ab 的距离
+static float markDistance(const SimMark& m, Vec2 p) {
+    float dx = m.b.x - m.a.x;
+    float dy = m.b.y - m.a.y;
+    float len2 = dx * dx + dy * dy;
+    float u = len2 > 0 ? constrain(((p.x - m.a.x) * dx + (p.y - m.a.y) * dy) / len2, 0.0f, 1.0f) : 0;
+    return hypotf(m.a.x + u * dx - p.x, m.a.y + u * dy - p.y);
+}
+
+float SimTrack::edgeDistance(Vec2 p) const {
+    float edge = distanceTo(p) - lineWidth / 2;
+    for (const SimMark& m : marks) {
+        edge = std::min(edge, markDistance(m, p) - m.width / 2);
+    }
+    return edge;
+}
+
+bool SimTrack::isOnLine(Vec2 p) const {
+    for (const SimMark& m : marks) {
+        if (markDistance(m, p) <= m.width / 2) return true;
+    }
+    float radius = lineWidth / 2;
+    for (size_t i = 0; i < bounds.size(); i++) {
+        const SimBox& box = bounds[i];
+        if (p.x < box.x0 - radius || p.x > box.x1 + radius ||
+            p.y < box.y0 - radius || p.y > box.y1 + radius) {
+            continue;
+        }
+        if (segmentDistance2(i, p, nullptr) <= radius * radius) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ==================== 场景 ====================
+
+SimScenario SimScenario::standard() {
+    SimScenario s;
+    s.startPos = {0, 0};
+    s.startHeadingDeg = 0;
+
+    // 1. 起点直道, 右侧放待测物块
+    // 2. 左弯进入第二条直道, 中央放障碍物 (避障)
+    // 3. 左弯进入终点直道, 线尽头前方是车库墙 (第二次超声波触发入库)
+    s.track.start(0, 0, 0);
+    s.track.straight(1800);
+    s.track.arc(500, 90);
+    s.track.straight(2400);
+    s.track.arc(500, 90);
+    s.track.straight(1800);
+
+    s.objectLengthMm = 700;
+    s.boxes.push_back({500, -250, 500 + s.objectLengthMm, -150, "object"});
+
+    float half = OBSTACLE_WIDTH_CM * 10 / 2.0f;
+    s.boxes.push_back({2300 - half, 1800 - half, 2300 + half, 1800 + half, "obstacle"});
+
+    Vec2 end = s.track.getEnd();
+    s.boxes.push_back({end.x - 220, end.y - 250, end.x - 200, end.y + 250, "garage"});
+    s.garageBox = 2;
+    s.laps = 0;
+    return s;
+}
+
+SimScenario SimScenario::features() {
+    SimScenario s = standard();
+    const float w = s.track.getLineWidth();
+
+    // 起点横条 (40mm 宽) / 第一直道的十字 / 右分支
+    s.track.addMark({150, -60}, {150, 60}, 40);
+    s.track.addMark({1300, -80}, {1300, 80}, w);
+    s.track.addMark({1550, 0}, {1650, -120}, w);
+    // 第二直道 (朝 +y) 的左分支
+    s.track.addMark({2300, 900}, {2180, 1000}, w);
+    // 终点直道 (朝 -x) 的终点横条
+    Vec2 end = s.track.getEnd();
+    s.track.addMark({end.x + 1200, end.y - 60}, {end.x + 1200, end.y + 60}, 40);
+    return s;
+}
+
+SimScenario SimScenario::loop() {
+    SimScenario s;
+    s.startPos = {0, 0};
+    s.startHeadingDeg = 0;
+
+    // 圆角矩形: 长直道 + 大弯, 短直道 + 小弯, 首尾相接
+    s.track.start(0, 0, 0);
+    for (int i = 0; i < 2; i++) {
+        s.track.straight(2400);
+        s.track.arc(500, 90);
+        s.track.straight(1000);
+        s.track.arc(300, 90);
+    }
+    s.track.addMark({300, -60}, {300, 60}, 40);
+
+    s.objectLengthMm = 0;
+    s.garageBox = -1;
+    s.laps = 3;
+    return s;
+}
+
+// ==================== 几何工具 ====================
+
+float rayCast(const std::vector<SimBox>& boxes, Vec2 origin, float angleRad, float maxRange) {
+    float dx = cosf(angleRad);
+    float dy = sinf(angleRad);
+    float nearest = maxRange;
+
+    // slab 法求射线与轴对齐矩形的交点
+    for (const SimBox& box : boxes) {
+        float tMin = 0;
+        float tMax = nearest;
+        bool hit = true;
+        const float lo[2] = {box.x0, box.y0};
+        const float hi[2] = {box.x1, box.y1};
+        const float o[2] = {origin.x, origin.y};
+        const float d[2] = {dx, dy};
+        for (int axis = 0; axis < 2 && hit; axis++) {
+            if (fabsf(d[axis]) < 1e-9f) {
+                if (o[axis] < lo[axis] || o[axis] > hi[axis]) hit = false;
+                continue;
+            }
+            float t1 = (lo[axis] - o[axis]) / d[axis];
+            float t2 = (hi[axis] - o[axis]) / d[axis];
+            if (t1 > t2) std::swap(t1, t2);
+            tMin = std::max(tMin, t1);
+            tMax = std::min(tMax, t2);
+            if (tMin > tMax) hit = false;
+        }
+        if (hit && tMin < nearest) {
+            nearest = tMin;
+        }
+    }
+    return nearest;
+}
+
+bool bodyIntersects(const SimBox& box, Vec2 center, float headingRad, float length, float width) {
+    // 分离轴: 矩形的两条轴 + 车身的两条轴
+    float c = cosf(headingRad);
+    float s = sinf(headingRad);
+    float hl = length / 2;
+    float hw = width / 2;
+    Vec2 corners[4] = {
+        {center.x + c * hl - s * hw, center.y + s * hl + c * hw},
+        {center.x + c * hl + s * hw, center.y + s * hl - c * hw},
+        {center.x - c * hl + s * hw, center.y - s * hl - c * hw},
+        {center.x - c * hl - s * hw, center.y - s * hl + c * hw},
+    };
+
+    float minX = 1e9f, maxX = -1e9f, minY = 1e9f, maxY = -1e9f;
+    for (const Vec2& p : corners) {
+        minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+    }
+    if (maxX < box.x0 || minX > box.x1 || maxY < box.y0 || minY > box.y1) return false;
+
+    Vec2 boxCorners[4] = {{box.x0, box.y0}, {box.x1, box.y0}, {box.x1, box.y1}, {box.x0, box.y1}};
+    const Vec2 axes[2] = {{c, s}, {-s, c}};
+    const float extent[2] = {hl, hw};
+    for (int i = 0; i < 2; i++) {
+        float centerProj = center.x * axes[i].x + center.y * axes[i].y;
+        float lo = 1e9f, hi = -1e9f;
+        for (const Vec2& p : boxCorners) {
+            float proj = p.x * axes[i].x + p.y * axes[i].y;
+            lo = std::min(lo, proj);
+            hi = std::max(hi, proj);
+        }
+        if (hi < centerProj - extent[i] || lo > centerProj + extent[i]) return false;
+    }
+    return true;
+}
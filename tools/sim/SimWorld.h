@@ -0,0 +1,86 @@
+#ifndef SIM_WORLD_H
+#define SIM_WORLD_H
+
+#include <Arduino.h>
+#include <vector>
+
+// 仿真场地: 黑线折线 + 矩形障碍物, 单位mm, 坐标系 x向右 y向上, 角度逆时针为正
+
+struct Vec2 {
+    float x;
+    float y;
+};
+
+// 轴对齐矩形 (物块 / 障碍物 / 车库墙)
+struct SimBox {
+    float x0, y0, x1, y1;
+    const char* name;
+};
+
+// 赛道标记: 横线 / 分支等不属于主线的黑线段 (不参与进度计算)
+struct SimMark {
+    Vec2 a;
+    Vec2 b;
+    float width;
+};
+
+class SimTrack {
+public:
+    SimTrack();
+
+    // 从当前位置/朝向继续铺设赛道
+    void start(float x, float y, float headingDeg);
+    void straight(float lengthMm);
+    void arc(float radiusMm, float angleDeg);   // 正: 左转, 负: 右转
+    void addMark(Vec2 a, Vec2 b, float widthMm) { marks.push_back({a, b, widthMm}); }
+
+    void setLineWidth(float mm) { lineWidth = mm; }
+    float getLineWidth() const { return lineWidth; }
+    float getLength() const { return cumulative.empty() ? 0 : cumulative.back(); }
+    Vec2 getEnd() const { return cursor; }
+    float getEndHeading() const { return cursorHeading; }
+
+    // 点到赛道中心线的距离 (mm), 可选返回沿线进度 (mm)
+    float distanceTo(Vec2 p, float* progress = nullptr) const;
+    bool isOnLine(Vec2 p) const;
+    // 点到最近黑线边缘的距离 (mm, 在线内为负), 包含标记
+    float edgeDistance(Vec2 p) const;
+
+private:
+    std::vector<Vec2> points;
+    std::vector<float> cumulative;   // 每个点处的累计长度
+    std::vector<SimBox> bounds;      // 每段的包围盒, 用于快速排除
+    Vec2 cursor;
+    float cursorHeading;             // 弧度
+    float lineWidth;
+    std::vector<SimMark> marks;
+
+    void addPoint(Vec2 p);
+    float segmentDistance2(size_t i, Vec2 p, float* t) const;
+};
+
+// 一个完整场景: 赛道 + 障碍物 + 起点 + 真值
+struct SimScenario {
+    SimTrack track;
+    std::vector<SimBox> boxes;
+    Vec2 startPos;
+    float startHeadingDeg;
+    float objectLengthMm;     // 待测物块真实长度
+    int garageBox;            // 车库墙在 boxes 中的下标, -1 表示无
+    int laps;                 // >0: 环形赛道, 跑完此圈数即结束 (不入库)
+
+    // 默认场景: 直道旁物块 -> 左弯 -> 直道中央障碍物 -> 左弯 -> 车库
+    static SimScenario standard();
+    // 标准场景 + 起/终点横条、十字、左右分支 (赛道特征识别)
+    static SimScenario features();
+    // 环形赛道 (两种半径的弯道) + 起/终点横条, 无物块/障碍物, 跑3圈 (赛道学习)
+    static SimScenario loop();
+};
+
+// 射线与矩形求交, 返回最近距离 (mm), 未命中返回 maxRange
+float rayCast(const std::vector<SimBox>& boxes, Vec2 origin, float angleRad, float maxRange);
+
+// 车身矩形 (中心, 朝向, 长, 宽) 是否与矩形相交
+bool bodyIntersects(const SimBox& box, Vec2 center, float headingRad, float length, float width);
+
+#endif
@@ -0,0 +1,437 @@
+#include "Simulation.h"
+#include <ArduinoJson.h>
+#include <chrono>
+
+static const uint32_t CONTROL_PERIOD_US = 1000000 / CONTROL_LOOP_HZ;
+static const uint32_t PHYSICS_STEP_US = 500;
+static const float WHEEL_BASE_MM = WHEEL_BASE_CM * 10.0f;
+
+// ==================== SimResult ====================
+
+String SimResult::toJson() const {
+    JsonDocument doc;
+    doc["finished"] = finished;
+    doc["collided"] = collided;
+    doc["timedOut"] = timedOut;
+    doc["lapTime"] = lapTimeS;
+    doc["finalState"] = (int)finalState;
+    doc["progress"] = progressMm;
+    if (!splitsS.empty()) {
+        JsonArray splits = doc["splits"].to<JsonArray>();
+        for (float split : splitsS) {
+            splits.add(split);
+        }
+    }
+
+    JsonObject object = doc["object"].to<JsonObject>();
+    object["valid"] = objectValid;
+    object["measured"] = objectLengthMm;
+    object["truth"] = objectTrueMm;
+    object["error"] = objectLengthMm - objectTrueMm;
+
+    doc["avoided"] = avoided;
+    doc["maxLineError"] = maxLineErrorMm;
+    doc["meanLineError"] = meanLineErrorMm;
+    doc["parkGap"] = parkGapMm;
+
+    JsonObject odom = doc["odom"].to<JsonObject>();
+    odom["error"] = odomErrorMm;
+    odom["headingError"] = odomHeadingErrorDeg;
+
+    JsonObject perf = doc["perf"].to<JsonObject>();
+    perf["simSeconds"] = simSeconds;
+    perf["wallSeconds"] = wallSeconds;
+    perf["cycles"] = cycles;
+    perf["speedup"] = wallSeconds > 0 ? simSeconds / wallSeconds : 0;
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+// ==================== SimSensors ====================
+
+SimSensors::SimSensors() {
+    distanceCm = ULTRASONIC_NO_ECHO_CM;
+    timestamp = 0;
+    pressStart = 0;
+    pressEnd = 0;
+    alarm = false;
+}
+
+bool SimSensors::isUltrasonicValid() {
+    return timestamp != 0 && millis() - timestamp <= ULTRASONIC_MAX_AGE_MS;
+}
+
+bool SimSensors::isButtonPressed() {
+    unsigned long now = millis();
+    return now >= pressStart && now < pressEnd;
+}
+
+void SimSensors::setUltrasonic(float cm, unsigned long timestampMs) {
+    distanceCm = cm;
+    timestamp = timestampMs;
+}
+
+void SimSensors::pressButton(unsigned long atMs, unsigned long durationMs) {
+    pressStart = atMs;
+    pressEnd = atMs + durationMs;
+}
+
+// ==================== Simulation ====================
+
+Simulation::Simulation(const SimScenario& scenario, const ParameterManager& params,
+                       const SimCarConfig& config, uint32_t seed)
+    : scenario(scenario),
+      config(config),
+      rng(seed ? seed : 1),
+      calibrateFirst(false),
+      params(params),
+      lineSensor(&lineUart),
+      motor(&motorPwm, &leftEncoder, &rightEncoder),
+      pidController(KP_LINE, KI_LINE, KD_LINE),
+      encoderPid(1.0, 0, 0),
+      gyroPublisher(&gyroRing),
+      objectDetector(&laserRing, &motor),
+      car(&lineSensor, &motor, &sensors, &pidController, &encoderPid,
+          &objectDetector, &taskManager, &this->params) {
+    pos = scenario.startPos;
+    heading = scenario.startHeadingDeg * (float)PI / 180.0f;
+    leftSpeed = 0;
+    rightSpeed = 0;
+    leftResidual = 0;
+    rightResidual = 0;
+    omega = 0;
+    gyroSumRaw = 0;
+    gyroFrames = 0;
+    nextGyroFrameUs = 0;
+    nextGyroPollUs = 0;
+    physicsUs = 0;
+    nextLaserUs = 0;
+    nextSonarUs = 0;
+    nextLineUs = 0;
+    lineStreamCommand = 0;
+    collided = false;
+    if (config.gyro) {
+        car.setGyroSource(&gyroRing);
+    }
+
+    // 循迹模块应答: 按当前车姿渲染8路数字状态或模拟量帧; 连续输出指令改由 catchUp() 定时发帧
+    lineUart.setResponder([this](uint8_t request, HostUart& uart) {
+        if (request == LINE_CMD_STREAM_DIGITAL || request == LINE_CMD_STREAM_ANALOG) {
+            lineStreamCommand = request;
+            nextLineUs = physicsUs + this->config.lineStreamPeriodUs;
+        } else if (request == LINE_CMD_MANUAL) {
+            lineStreamCommand = 0;
+        } else if (request == LINE_CMD_DIGITAL) {
+            uint8_t states = renderLine();
+            uart.inject(&states, 1);
+        } else if (request == LINE_CMD_ANALOG) {
+            uint8_t frame[LINE_ANALOG_FRAME_SIZE];
+            renderAnalogFrame(frame);
+            uart.inject(frame, sizeof(frame));
+        }
+    });
+}
+
+// 车体坐标 (前, 右) -> 场地坐标
+Vec2 Simulation::bodyPoint(float forward, float right) const {
+    float c = cosf(heading);
+    float s = sinf(heading);
+    return {pos.x + forward * c + right * s, pos.y + forward * s - right * c};
+}
+
+// 确定性随机数: xorshift32, [0, 1)
+float Simulation::uniform() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng & 0xFFFFFF) / (float)0x1000000;
+}
+
+// 4个均匀分布求和近似高斯
+float Simulation::noise(float sigma) {
+    float sum = 0;
+    for (int i = 0; i < 4; i++) {
+        sum += uniform();
+    }
+    return (sum - 2.0f) * 1.7320508f * sigma;
+}
+
+uint8_t Simulation::renderLine() {
+    uint8_t states = 0;
+    for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
+        float right = (i - (LINE_SENSOR_COUNT - 1) / 2.0f) * config.linePitchMm;
+        if (scenario.track.isOnLine(bodyPoint(config.lineForwardMm, right))) {
+            states |= 1 << i;
+        }
+    }
+    return states;
+}
+
+void Simulation::renderAnalogFrame(uint8_t* frame) {
+    frame[0] = LINE_FRAME_HEAD;
+    frame[1] = LINE_FRAME_HEAD;
+    frame[2] = 1;
+    frame[3] = LINE_ANALOG_DATA_LEN;
+
+    uint8_t sum = frame[2] + frame[3];
+    for (int i = 0; i < LINE_SENSOR_COUNT; i++) {
+        float right = (i - (LINE_SENSOR_COUNT - 1) / 2.0f) * config.linePitchMm;
+        float edge = scenario.track.edgeDistance(bodyPoint(config.lineForwardMm, right));
+        float coverage = constrain((config.lineSpotMm / 2 - edge) / config.lineSpotMm, 0.0f, 1.0f);
+        float level = config.lineFloorLevel + coverage * (config.lineBlackLevel - config.lineFloorLevel)
+                      + noise(config.lineAnalogNoise);
+        uint16_t value = (uint16_t)constrain(level, 0.0f, (float)LINE_ANALOG_MAX);
+        frame[4 + i * 2] = value >> 8;
+        frame[5 + i * 2] = value & 0xFF;
+        sum += frame[4 + i * 2] + frame[5 + i * 2];
+    }
+    frame[LINE_ANALOG_FRAME_SIZE - 1] = ~sum;
+}
+
+void Simulation::streamLine() {
+    uint8_t frame[LINE_ANALOG_FRAME_SIZE];
+    size_t len;
+    if (lineStreamCommand == LINE_CMD_STREAM_ANALOG) {
+        renderAnalogFrame(frame);
+        len = sizeof(frame);
+    } else {
+        frame[0] = renderLine();
+        len = 1;
+    }
+    if (config.lineCorruptRate > 0 && uniform() < config.lineCorruptRate) {
+        frame[(size_t)(uniform() * len)] ^= 1 << (rng % 8);
+    }
+    lineUart.inject(frame, len);
+}
+
+void Simulation::sampleLaser() {
+    Vec2 origin = bodyPoint(config.laserForwardMm, config.laserSideMm);
+    float range = rayCast(scenario.boxes, origin, heading - (float)PI / 2, config.laserMaxMm);
+
+    LaserSample sample;
+    sample.timestampUs = (uint32_t)physicsUs;
+    sample.raw = range >= config.laserMaxMm ? 8190 : (uint16_t)constrain(range + noise(config.laserNoiseMm), 0.0f, 8189.0f);
+    sample.filtered = laserFilter.update(sample.raw);
+    laserRing.push(sample);
+}
+
+// 陀螺仪按ODR逐帧采样真实角速度 (加零偏与噪声), 读取周期到时整批送出 (与板上读取任务相同)
+void Simulation::sampleGyro() {
+    static const float LSB_PER_DPS = 32768.0f / IMU_GYRO_RANGE_DPS;
+    static const uint32_t FRAME_US = 1000000 / IMU_GYRO_ODR_HZ;
+    while (nextGyroFrameUs <= physicsUs) {
+        nextGyroFrameUs += FRAME_US;
+        float dps = omega * 180.0f / (float)PI + config.gyroBiasDps + noise(config.gyroNoiseDps);
+        gyroSumRaw += (int32_t)constrain(lroundf(dps * LSB_PER_DPS * IMU_GYRO_Z_SIGN), -32768L, 32767L);
+        gyroFrames++;
+    }
+    if (physicsUs >= nextGyroPollUs) {
+        nextGyroPollUs += IMU_POLL_MS * 1000;
+        gyroPublisher.publishSum(gyroSumRaw, gyroFrames, (uint32_t)physicsUs);
+        gyroSumRaw = 0;
+        gyroFrames = 0;
+    }
+}
+
+void Simulation::sampleSonar() {
+    Vec2 origin = bodyPoint(config.sonarForwardMm, 0);
+    float cone = config.sonarConeDeg * (float)PI / 180.0f;
+    float nearest = config.sonarMaxMm;
+    for (int i = -2; i <= 2; i++) {
+        nearest = std::min(nearest, rayCast(scenario.boxes, origin, heading + cone * i / 2, config.sonarMaxMm));
+    }
+    float cm = nearest >= config.sonarMaxMm ? ULTRASONIC_NO_ECHO_CM : std::max(0.0f, nearest + noise(2.0f)) / 10.0f;
+    sensors.setUltrasonic(cm, (unsigned long)(physicsUs / 1000));
+}
+
+// H桥输入 -> 轮速: 双高刹车, 双低滑行, 否则按占空比差一阶逼近稳态速度
+float Simulation::wheelSpeed(float current, uint8_t ch1, uint8_t ch2, float gain, float dt) {
+    float d1 = motorPwm.getDuty(ch1);
+    float d2 = motorPwm.getDuty(ch2);
+    float target = 0;
+    float tauMs = config.motorTauMs;
+
+    if (d1 >= 255 && d2 >= 255) {
+        tauMs = config.brakeTauMs;
+    } else if (d1 == 0 && d2 == 0) {
+        tauMs = config.coastTauMs;
+    } else {
+        float duty = d1 - d2;
+        float magnitude = std::max(0.0f, fabsf(duty) - config.stictionDuty) / (255.0f - config.stictionDuty);
+        target = copysignf(magnitude * config.maxSpeedMmS * gain, duty);
+    }
+    return current + (target - current) * (1.0f - expf(-dt * 1000.0f / tauMs));
+}
+
+void Simulation::stepPhysics(float dt) {
+    leftSpeed = wheelSpeed(leftSpeed, PWM_CHANNEL_L1, PWM_CHANNEL_L2, config.leftGain, dt);
+    rightSpeed = wheelSpeed(rightSpeed, PWM_CHANNEL_R1, PWM_CHANNEL_R2, config.rightGain, dt);
+
+    // 差速运动学 (中点积分); 转向打滑按原地转的程度 (差速占比) 折减角速度
+    float v = (leftSpeed + rightSpeed) / 2;
+    float spin = fabsf(rightSpeed - leftSpeed) / std::max(fabsf(leftSpeed) + fabsf(rightSpeed), 1.0f);
+    omega = (rightSpeed - leftSpeed) / WHEEL_BASE_MM * (1.0f - config.spinSlip * spin);
+    float midHeading = heading + omega * dt / 2;
+    pos.x += v * dt * cosf(midHeading);
+    pos.y += v * dt * sinf(midHeading);
+    heading += omega * dt;
+
+    emitPulses(leftEncoder, leftResidual, leftSpeed * dt, dt);
+    emitPulses(rightEncoder, rightResidual, rightSpeed * dt, dt);
+}
+
+// 编码器逐个累加整数脉冲, 余量留到下一步; 步内按匀速插值脉冲时刻 (T法测速用到边沿时刻)
+void Simulation::emitPulses(HostEncoder& encoder, float& residual, float travel, float dt) {
+    float start = residual;
+    residual += travel;
+    int64_t pulses = (int64_t)(residual / MM_PER_PULSE);
+    int direction = pulses > 0 ? 1 : -1;
+    for (int64_t i = 1; i <= pulses * direction; i++) {
+        float fraction = constrain((direction * i * MM_PER_PULSE - start) / travel, 0.0f, 1.0f);
+        encoder.addPulse(direction, (uint32_t)(physicsUs + (uint64_t)(fraction * dt * 1e6f)));
+    }
+    residual -= pulses * MM_PER_PULSE;
+}
+
+// 物理与传感器推进到虚拟时钟当前时刻 (控制周期之间, 以及被测代码 delay() 期间)
+void Simulation::catchUp() {
+    uint64_t now = hostClockMicros();
+    while (physicsUs < now) {
+        uint64_t dt = std::min<uint64_t>(PHYSICS_STEP_US, now - physicsUs);
+        stepPhysics(dt / 1e6f);
+        physicsUs += dt;
+
+        if (physicsUs >= nextLaserUs) {
+            nextLaserUs += LASER_PERIOD_MS * 1000;
+            sampleLaser();
+        }
+        if (config.gyro) {
+            sampleGyro();
+        }
+        if (physicsUs >= nextSonarUs) {
+            nextSonarUs += ULTRASONIC_INTERVAL_MS * 1000;
+            sampleSonar();
+        }
+        if (lineStreamCommand && physicsUs >= nextLineUs) {
+            nextLineUs += config.lineStreamPeriodUs;
+            streamLine();
+        }
+    }
+
+    for (const SimBox& box : scenario.boxes) {
+        if (bodyIntersects(box, bodyPoint(config.bodyForwardMm, 0), heading,
+                           config.bodyLengthMm, config.bodyWidthMm)) {
+            collided = true;
+        }
+    }
+}
+
+void Simulation::step() {
+    hostClockAdvance(CONTROL_PERIOD_US);
+    catchUp();
+    car.cycle();
+    lineUart.sent().clear();
+}
+
+SimResult Simulation::run(float timeoutS) {
+    SimResult result = {};
+    result.objectTrueMm = scenario.objectLengthMm;
+
+    // 时钟从1s开始, 避免时间戳0被当作"无数据"
+    hostClockSet(1000000);
+    physicsUs = hostClockMicros();
+    nextLaserUs = physicsUs;
+    nextSonarUs = physicsUs;
+    nextGyroFrameUs = physicsUs;
+    nextGyroPollUs = physicsUs;
+    hostClockSetDelayHook([this](uint64_t us) { catchUp(); });
+
+    auto wallStart = std::chrono::steady_clock::now();
+
+    lineSensor.begin();
+    motor.begin();
+    car.begin();
+
+    if (calibrateFirst) {
+        car.requestLineCalibration();
+        step();
+        while (car.isRunning() && hostClockMicros() < 20000000) {
+            step();
+        }
+    }
+
+    // 发车前静止1s (陀螺仪完成零偏标定)
+    unsigned long startMs = millis() + 1000;
+    sensors.pressButton(startMs, 100);
+
+    uint64_t timeoutUs = hostClockMicros() + (uint64_t)(timeoutS * 1e6f);
+    double lineErrorSum = 0;
+    uint32_t lineErrorCount = 0;
+    bool wasAvoiding = false;
+
+    while (!collided && hostClockMicros() < timeoutUs) {
+        step();
+        result.cycles++;
+
+        SystemState state = car.getState();
+        if (state == STATE_LINE_FOLLOW && car.isRunning()) {
+            float progress;
+            float error = scenario.track.distanceTo(bodyPoint(config.lineForwardMm, 0), &progress);
+            lineErrorSum += error;
+            lineErrorCount++;
+            result.maxLineErrorMm = std::max(result.maxLineErrorMm, error);
+            if (error < 100) {
+                result.progressMm = std::max(result.progressMm, progress);
+            }
+            if (wasAvoiding) {
+                result.avoided = true;
+            }
+        }
+        if (state == STATE_OBSTACLE_AVOID) {
+            wasAvoiding = true;
+        }
+        if (state == STATE_FINISHED) {
+            result.finished = true;
+            break;
+        }
+        if (scenario.laps > 0 && car.getLapCount() > result.splitsS.size()) {
+            result.splitsS.push_back(car.getLastLapMs() / 1000.0f);
+            if ((int)result.splitsS.size() >= scenario.laps) {
+                result.finished = true;
+                break;
+            }
+        }
+    }
+
+    hostClockSetDelayHook(nullptr);
+
+    result.collided = collided;
+    result.timedOut = !result.finished && !collided;
+    result.finalState = car.getState();
+    result.lapTimeS = (millis() - startMs) / 1000.0f;
+    result.meanLineErrorMm = lineErrorCount ? lineErrorSum / lineErrorCount : 0;
+
+    ObjectMeasurement object = objectDetector.getResult();
+    result.objectValid = object.valid;
+    result.objectLengthMm = object.length;
+
+    // 里程计位姿 (上电起点坐标系) 换算到世界坐标, 与真实位姿比较
+    const Pose& pose = car.getOdometry().getPose();
+    float startHeading = scenario.startHeadingDeg * (float)PI / 180.0f;
+    float odomX = scenario.startPos.x + pose.x * cosf(startHeading) - pose.y * sinf(startHeading);
+    float odomY = scenario.startPos.y + pose.x * sinf(startHeading) + pose.y * cosf(startHeading);
+    result.odomErrorMm = hypotf(odomX - pos.x, odomY - pos.y);
+    result.odomHeadingErrorDeg = (pose.heading + startHeading - heading) * 180.0f / (float)PI;
+
+    if (scenario.garageBox >= 0) {
+        std::vector<SimBox> garage(1, scenario.boxes[scenario.garageBox]);
+        result.parkGapMm = rayCast(garage, bodyPoint(config.bodyForwardMm + config.bodyLengthMm / 2, 0),
+                                   heading, config.sonarMaxMm);
+    }
+
+    result.simSeconds = (hostClockMicros() - 1000000) / 1e6f;
+    result.wallSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - wallStart).count();
+    return result;
+}
@@ -0,0 +1,183 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "LineSensor.h"
+#include "MotorControl.h"
+#include "PIDController.h"
+#include "ParameterManager.h"
+#include "ObjectDetector.h"
+#include "TaskManager.h"
+#include "CarController.h"
+#include "CarSensors.h"
+#include "LaserSample.h"
+#include "GyroSample.h"
+#include "hal/host/HostHal.h"
+#include "SimWorld.h"
+
+// 车体与传感器安装参数 (轮径/轮距/编码器取自 config.h)
+struct SimCarConfig {
+    float maxSpeedMmS = 1200.0f;   // PWM=255 时的稳态轮速
+    float stictionDuty = 20.0f;    // 低于此占空比电机不转
+    float motorTauMs = 60.0f;      // 轮速一阶响应时间常数
+    float brakeTauMs = 15.0f;      // 短路刹车
+    float coastTauMs = 200.0f;     // 滑行
+    float leftGain = 1.0f;         // 左右电机效率差异
+    float rightGain = 1.0f;
+    float spinSlip = 0.0f;         // 转向打滑: 原地转时车体角速度比差速给出的小这个比例 (编码器照常计数), 直行为0
+
+    float bodyLengthMm = 200.0f;   // 车身 (碰撞检测)
+    float bodyWidthMm = 170.0f;
+    float bodyForwardMm = 40.0f;   // 车身中心相对驱动轴前移
+
+    float lineForwardMm = 70.0f;   // 循迹传感器阵列在轴前方
+    float linePitchMm = 12.0f;     // 相邻探头间距, 探头7在右侧
+    float lineSpotMm = 8.0f;       // 单路探头光斑直径 (模拟量随压线面积线性变化)
+    float lineFloorLevel = 400.0f; // 模拟量: 地面 / 黑线 / 噪声
+    float lineBlackLevel = 3600.0f;
+    float lineAnalogNoise = 40.0f;
+    uint32_t lineStreamPeriodUs = 2000;   // 连续输出模式的发帧周期
+    float lineCorruptRate = 0.0f;         // 连续输出帧中随机破坏一个字节的概率 (测试重新对齐)
+
+    float laserForwardMm = 0.0f;   // VL53L0X 朝右安装
+    float laserSideMm = 60.0f;
+    float laserNoiseMm = 3.0f;
+    float laserMaxMm = 2000.0f;
+
+    float sonarForwardMm = 120.0f; // 超声波朝前安装
+    float sonarConeDeg = 12.0f;
+    float sonarMaxMm = 4000.0f;
+
+    bool gyro = true;              // BMI160 (关闭时航向只用编码器)
+    float gyroBiasDps = 0.8f;      // 零偏
+    float gyroNoiseDps = 0.2f;     // 每帧噪声 1σ
+};
+
+// 一次仿真运行的结果
+struct SimResult {
+    bool finished;          // 到达 STATE_FINISHED
+    bool collided;          // 车身碰到障碍物
+    bool timedOut;
+    float lapTimeS;         // 按键启动到停车报警结束 (环形赛道: 到跑完规定圈数)
+    std::vector<float> splitsS;   // 环形赛道每圈用时 (横条之间)
+    bool objectValid;
+    float objectLengthMm;
+    float objectTrueMm;
+    bool avoided;           // 完成避障并回到循迹
+    float maxLineErrorMm;   // 循迹状态下探头中心到线的距离
+    float meanLineErrorMm;
+    float parkGapMm;        // 停车后车头到车库墙的距离
+    float progressMm;       // 沿赛道最远进度
+    float odomErrorMm;      // 结束时里程计位置与真实位置的距离
+    float odomHeadingErrorDeg;
+    SystemState finalState;
+    float simSeconds;
+    float wallSeconds;
+    uint32_t cycles;
+
+    String toJson() const;
+};
+
+// 虚拟超声波/按键/报警
+class SimSensors : public CarSensors {
+public:
+    SimSensors();
+    void update() override {}
+    float getUltrasonicDistance() override { return distanceCm; }
+    bool isUltrasonicValid() override;
+    bool isButtonPressed() override;
+    void setAlarm(bool on) override { alarm = on; }
+
+    void setUltrasonic(float cm, unsigned long timestampMs);
+    void pressButton(unsigned long atMs, unsigned long durationMs);
+    bool isAlarmOn() const { return alarm; }
+
+private:
+    float distanceCm;
+    unsigned long timestamp;
+    unsigned long pressStart;
+    unsigned long pressEnd;
+    bool alarm;
+};
+
+// 用真实的 CarController/ObjectDetector/LineSensor/MotorControl 驱动仿真车
+// 所有外设走 hal/host, 时间走线程本地虚拟时钟, 每个实例独立, 可在多个线程并行运行
+class Simulation {
+public:
+    Simulation(const SimScenario& scenario, const ParameterManager& params,
+               const SimCarConfig& config = SimCarConfig(), uint32_t seed = 1);
+
+    SimResult run(float timeoutS = 120.0f);
+
+    // 发车前先执行一次循迹校准 (与网页"循迹校准"相同的流程), 结果在 run() 中生效
+    void setCalibrateFirst(bool enable) { calibrateFirst = enable; }
+
+    // 单步接口 (回放/调试): 推进一个控制周期
+    void step();
+    CarController& getController() { return car; }
+    Vec2 getPosition() const { return pos; }
+    float getHeading() const { return heading; }
+
+private:
+    SimScenario scenario;
+    SimCarConfig config;
+    uint32_t rng;
+    bool calibrateFirst;
+
+    // 仿真外设
+    HostUart lineUart;
+    HostPwm motorPwm;
+    HostEncoder leftEncoder;
+    HostEncoder rightEncoder;
+
+    // 被测代码 (与 main.cpp 相同的对象图)
+    ParameterManager params;
+    LineSensor lineSensor;
+    MotorControl motor;
+    PIDController pidController;
+    PIDController encoderPid;
+    LaserRing laserRing;
+    LaserFilter laserFilter;
+    GyroRing gyroRing;
+    GyroPublisher gyroPublisher;
+    ObjectDetector objectDetector;
+    TaskManager taskManager;
+    SimSensors sensors;
+    CarController car;
+
+    // 车体状态 (驱动轴中心)
+    Vec2 pos;
+    float heading;
+    float leftSpeed;      // mm/s
+    float rightSpeed;
+    float leftResidual;   // 未满一个脉冲的行程
+    float rightResidual;
+    float omega;          // 车体角速度 rad/s
+    int32_t gyroSumRaw;   // 本次FIFO读取前累计的帧
+    int gyroFrames;
+    uint64_t nextGyroFrameUs;
+    uint64_t nextGyroPollUs;
+    uint64_t physicsUs;
+    uint64_t nextLaserUs;
+    uint64_t nextSonarUs;
+    uint64_t nextLineUs;
+    uint8_t lineStreamCommand;   // 0 = 未处于连续输出
+    bool collided;
+
+    void catchUp();
+    void stepPhysics(float dt);
+    void emitPulses(HostEncoder& encoder, float& residual, float travel, float dt);
+    float wheelSpeed(float current, uint8_t ch1, uint8_t ch2, float gain, float dt);
+    uint8_t renderLine();
+    void renderAnalogFrame(uint8_t* frame);
+    void streamLine();
+    void sampleLaser();
+    void sampleSonar();
+    void sampleGyro();
+    float uniform();
+    float noise(float sigma);
+    Vec2 bodyPoint(float forward, float right) const;
+};
+
+#endif
@@ -0,0 +1,101 @@
+// 赛道仿真: 真实状态机 + 虚拟时钟, 评估一组参数的圈速与测量精度
+// pio run -e sim && .pio/build/sim/program [params.json] [--runs N] [--seed S] [--verbose]
+//                                          [--calibrate] [--floor N] [--black N] [--scenario features|loop]
+//                                          [--motor-gain X] [--slip X] [--no-gyro]
+// params.json 与网页 /api/params 导出的格式相同, 未给出的字段使用默认值
+
+#include <Arduino.h>
+#include <fstream>
+#include <sstream>
+#include "Simulation.h"
+
+static bool loadFile(const char* path, String& content) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    content = String(buffer.str());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* paramsPath = nullptr;
+    int runs = 1;
+    uint32_t seed = 1;
+    bool verbose = false;
+    bool calibrate = false;
+    SimCarConfig config;
+    SimScenario scenario = SimScenario::standard();
+
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "--calibrate") {
+            calibrate = true;
+        } else if (arg == "--floor" && i + 1 < argc) {
+            config.lineFloorLevel = atof(argv[++i]);   // 场地光照: 模拟量的地面/黑线读数
+        } else if (arg == "--black" && i + 1 < argc) {
+            config.lineBlackLevel = atof(argv[++i]);
+        } else if (arg == "--motor-gain" && i + 1 < argc) {
+            // 电池电压/地面摩擦: 同一占空比下的轮速比例
+            config.leftGain = config.rightGain = atof(argv[++i]);
+        } else if (arg == "--slip" && i + 1 < argc) {
+            config.spinSlip = atof(argv[++i]);   // 原地转向打滑比例 (0~1)
+        } else if (arg == "--no-gyro") {
+            config.gyro = false;
+        } else if (arg == "--scenario" && i + 1 < argc) {
+            String name = argv[++i];
+            if (name == "features") {
+                scenario = SimScenario::features();
+            } else if (name == "loop") {
+                scenario = SimScenario::loop();
+            }
+        } else {
+            paramsPath = argv[i];
+        }
+    }
+
+    ParameterManager params;
+    if (paramsPath) {
+        String json;
+        if (!loadFile(paramsPath, json)) {
+            Serial.printf("Cannot read %s\n", paramsPath);
+            return 1;
+        }
+        params.fromJson(json);
+    }
+
+    int finished = 0;
+    float lapSum = 0;
+    float objectErrorSum = 0;
+    float speedupSum = 0;
+
+    for (int run = 0; run < runs; run++) {
+        Simulation sim(scenario, params, config, seed + run);
+        sim.setCalibrateFirst(calibrate);
+
+        Serial.setMuted(!verbose);
+        SimResult result = sim.run();
+        Serial.setMuted(false);
+
+        Serial.println(result.toJson());
+        if (result.finished) {
+            finished++;
+            lapSum += result.lapTimeS;
+        }
+        objectErrorSum += fabsf(result.objectLengthMm - result.objectTrueMm);
+        speedupSum += result.wallSeconds > 0 ? result.simSeconds / result.wallSeconds : 0;
+    }
+
+    if (runs > 1) {
+        Serial.printf("runs=%d finished=%d avgLap=%.2fs avgObjectError=%.1fmm avgSpeedup=%.0fx\n",
+                      runs, finished, finished ? lapSum / finished : 0.0f,
+                      objectErrorSum / runs, speedupSum / runs);
+    }
+    return finished == runs ? 0 : 2;
+}